@@ -205,6 +205,7 @@ get_install_cmd() {
                 pkg-config) echo "sudo pacman -S pkgconf" ;;
                 qt6-base-dev) echo "sudo pacman -S qt6-base" ;;
                 qt6-multimedia-dev) echo "sudo pacman -S qt6-multimedia" ;;
+                libjpeg-dev) echo "sudo pacman -S libjpeg-turbo" ;;
                 lsof) echo "sudo pacman -S lsof" ;;
                 *) echo "sudo pacman -S $package" ;;
             esac
@@ -219,6 +220,7 @@ get_install_cmd() {
                 build-essential) echo "sudo dnf groupinstall 'Development Tools'" ;;
                 qt6-base-dev) echo "sudo dnf install qt6-qtbase-devel" ;;
                 qt6-multimedia-dev) echo "sudo dnf install qt6-qtmultimedia-devel" ;;
+                libjpeg-dev) echo "sudo dnf install libjpeg-turbo-devel" ;;
                 pkg-config) echo "sudo dnf install pkgconfig" ;;
                 *) echo "sudo dnf install $package" ;;
             esac
@@ -241,6 +243,9 @@ get_install_cmd() {
                 qt6-multimedia-dev)
                     echo "Arch: sudo pacman -S qt6-multimedia | Debian/Ubuntu: sudo apt install qt6-multimedia-dev | Fedora: sudo dnf install qt6-qtmultimedia-devel"
                     ;;
+                libjpeg-dev)
+                    echo "Arch: sudo pacman -S libjpeg-turbo | Debian/Ubuntu: sudo apt install libjpeg-dev | Fedora: sudo dnf install libjpeg-turbo-devel"
+                    ;;
                 lsof)
                     echo "Arch: sudo pacman -S lsof | Debian/Ubuntu: sudo apt install lsof | Fedora: sudo dnf install lsof"
                     ;;
@@ -343,6 +348,15 @@ check_dependencies() {
         all_ok=false
     fi
 
+    # Check for libjpeg(-turbo)
+    if pkg-config --exists libjpeg 2>/dev/null; then
+        print_msg "$GREEN" "  ✓ libjpeg-turbo"
+    else
+        print_msg "$RED" "  ✗ libjpeg-turbo - NOT FOUND"
+        print_msg "$YELLOW" "    Install: $(get_install_cmd libjpeg-dev)"
+        all_ok=false
+    fi
+
     # Check for optional but recommended tools
     echo ""
     print_msg "$BLUE" "Optional dependencies:"
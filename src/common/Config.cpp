@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <unordered_set>
 #include <algorithm>
+#include <cctype>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -50,6 +51,10 @@ void Config::setDefaults()
 
     // Video / preview
     m_settings.previewFormat = "auto";
+    m_settings.previewQuality = "display";
+    m_settings.captureBackend = "qt";
+    m_settings.captureDevice = "auto";
+    m_settings.captureBuffers = 4;
 
     for (auto &preset : m_settings.presets) {
         preset.defined = false;
@@ -63,6 +68,13 @@ void Config::setDefaults()
     m_settings.virtualCameraEnabled = false;
     m_settings.virtualCameraDevice = "/dev/video42";
     m_settings.virtualCameraResolution = "match";
+    m_settings.virtualCameraFormat = "yuyv";
+    m_settings.virtualCameraGpuConversion = false;
+    m_settings.virtualCameraReadbackLatency = 1;
+    m_settings.virtualCameraFps = 0;
+    m_settings.virtualCameraThreads = 0;
+    m_settings.virtualCameraOutputFps = 0;
+    m_settings.virtualCameraExtraSinks.clear();
 }
 
 std::string Config::getXdgConfigHome() const
@@ -183,9 +195,20 @@ bool Config::load(std::vector<ValidationError> &errors)
         "track_speed",
         "audio_auto_gain",
         "preview_format",
+        "preview_quality",
+        "capture_backend",
+        "capture_device",
+        "capture_buffers",
         "virtual_camera_enabled",
         "virtual_camera_device",
         "virtual_camera_resolution",
+        "virtual_camera_format",
+        "virtual_camera_gpu_conversion",
+        "virtual_camera_readback_latency",
+        "virtual_camera_fps",
+        "virtual_camera_threads",
+        "virtual_camera_output_fps",
+        "virtual_camera_extra_sinks",
         "white_balance_kelvin"
     };
 
@@ -516,6 +539,46 @@ bool Config::parseLine(const std::string &line, int lineNumber, std::vector<Vali
         }
     } else if (key == "preview_format") {
         m_settings.previewFormat = value;
+    } else if (key == "preview_quality") {
+        std::string normalized = value;
+        std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (normalized != "display" && normalized != "full") {
+            addError(InvalidValue, "preview_quality must be display or full");
+            return false;
+        }
+        m_settings.previewQuality = normalized;
+    } else if (key == "capture_backend") {
+        std::string normalized = value;
+        std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (normalized != "qt" && normalized != "v4l2") {
+            addError(InvalidValue, "capture_backend must be qt or v4l2");
+            return false;
+        }
+        m_settings.captureBackend = normalized;
+    } else if (key == "capture_device") {
+        if (value.empty() || value == "auto") {
+            m_settings.captureDevice = "auto";
+            return true;
+        }
+        if (value.rfind("/dev/", 0) != 0) {
+            addError(InvalidValue, "capture_device must be 'auto' or a /dev/videoN path");
+            return false;
+        }
+        m_settings.captureDevice = value;
+    } else if (key == "capture_buffers") {
+        try {
+            const int buffers = std::stoi(value);
+            if (buffers < 2 || buffers > 16) {
+                addError(InvalidValue, "capture_buffers must be between 2 and 16");
+                return false;
+            }
+            m_settings.captureBuffers = buffers;
+        } catch (...) {
+            addError(InvalidValue, "capture_buffers must be an integer between 2 and 16");
+            return false;
+        }
     } else if (key == "start_minimized") {
         if (!parseBool(value, m_settings.startMinimized)) {
             addError(InvalidValue, "start_minimized must be true/false or enabled/disabled");
@@ -564,6 +627,84 @@ bool Config::parseLine(const std::string &line, int lineNumber, std::vector<Vali
             addError(InvalidValue, "virtual_camera_resolution must be 'match' or WIDTHxHEIGHT (e.g. 1280x720)");
             return false;
         }
+    } else if (key == "virtual_camera_format") {
+        std::string normalized = value;
+        std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (normalized != "yuyv" && normalized != "nv12" && normalized != "i420" && normalized != "mjpeg") {
+            addError(InvalidValue, "virtual_camera_format must be yuyv, nv12, i420 or mjpeg");
+            return false;
+        }
+        m_settings.virtualCameraFormat = normalized;
+    } else if (key == "virtual_camera_gpu_conversion") {
+        if (!parseBool(value, m_settings.virtualCameraGpuConversion)) {
+            addError(InvalidValue, "virtual_camera_gpu_conversion must be true/false or enabled/disabled");
+            return false;
+        }
+    } else if (key == "virtual_camera_readback_latency") {
+        try {
+            int latency = std::stoi(value);
+            if (latency < 0 || latency > 2) {
+                addError(InvalidValue, "virtual_camera_readback_latency must be between 0 and 2");
+                return false;
+            }
+            m_settings.virtualCameraReadbackLatency = latency;
+        } catch (...) {
+            addError(InvalidValue, "virtual_camera_readback_latency must be an integer between 0 and 2");
+            return false;
+        }
+    } else if (key == "virtual_camera_fps") {
+        try {
+            int fps = std::stoi(value);
+            if (fps < 0 || fps > 120) {
+                addError(InvalidValue, "virtual_camera_fps must be between 0 and 120");
+                return false;
+            }
+            m_settings.virtualCameraFps = fps;
+        } catch (...) {
+            addError(InvalidValue, "virtual_camera_fps must be an integer between 0 and 120");
+            return false;
+        }
+    } else if (key == "virtual_camera_threads") {
+        try {
+            int threads = std::stoi(value);
+            if (threads < 0 || threads > 16) {
+                addError(InvalidValue, "virtual_camera_threads must be between 0 and 16");
+                return false;
+            }
+            m_settings.virtualCameraThreads = threads;
+        } catch (...) {
+            addError(InvalidValue, "virtual_camera_threads must be an integer between 0 and 16");
+            return false;
+        }
+    } else if (key == "virtual_camera_output_fps") {
+        try {
+            int fps = std::stoi(value);
+            if (fps < 0 || fps > 120) {
+                addError(InvalidValue, "virtual_camera_output_fps must be between 0 and 120");
+                return false;
+            }
+            m_settings.virtualCameraOutputFps = fps;
+        } catch (...) {
+            addError(InvalidValue, "virtual_camera_output_fps must be an integer between 0 and 120");
+            return false;
+        }
+    } else if (key == "virtual_camera_extra_sinks") {
+        std::vector<VirtualCameraSink> sinks;
+        std::string error;
+        if (!parseVirtualCameraSinks(value, sinks, error)) {
+            addError(InvalidValue, "virtual_camera_extra_sinks: " + error);
+            return false;
+        }
+
+        std::string normalized;
+        for (const VirtualCameraSink &sink : sinks) {
+            if (!normalized.empty()) {
+                normalized += ",";
+            }
+            normalized += sink.device + ":" + sink.resolution + ":" + sink.format;
+        }
+        m_settings.virtualCameraExtraSinks = normalized;
     }
 
     return true;
@@ -655,6 +796,55 @@ bool Config::validateSettings(std::vector<ValidationError> &errors)
         }
     }
 
+    if (m_settings.previewQuality != "display" && m_settings.previewQuality != "full") {
+        addError("preview_quality must be display or full");
+    }
+
+    if (m_settings.captureBackend != "qt" && m_settings.captureBackend != "v4l2") {
+        addError("capture_backend must be qt or v4l2");
+    }
+
+    if (m_settings.captureDevice != "auto" && m_settings.captureDevice.rfind("/dev/", 0) != 0) {
+        addError("capture_device must be 'auto' or a /dev/videoN path");
+    }
+
+    if (m_settings.captureBuffers < 2 || m_settings.captureBuffers > 16) {
+        addError("capture_buffers out of range (must be 2-16)");
+    }
+
+    const std::string &format = m_settings.virtualCameraFormat;
+    if (format != "yuyv" && format != "nv12" && format != "i420" && format != "mjpeg") {
+        addError("virtual_camera_format must be yuyv, nv12, i420 or mjpeg");
+    }
+
+    if (m_settings.virtualCameraReadbackLatency < 0 || m_settings.virtualCameraReadbackLatency > 2) {
+        addError("virtual_camera_readback_latency out of range (must be 0-2)");
+    }
+
+    if (m_settings.virtualCameraFps < 0 || m_settings.virtualCameraFps > 120) {
+        addError("virtual_camera_fps out of range (must be 0-120)");
+    }
+
+    if (m_settings.virtualCameraThreads < 0 || m_settings.virtualCameraThreads > 16) {
+        addError("virtual_camera_threads out of range (must be 0-16)");
+    }
+
+    if (m_settings.virtualCameraOutputFps < 0 || m_settings.virtualCameraOutputFps > 120) {
+        addError("virtual_camera_output_fps out of range (must be 0-120)");
+    }
+
+    std::vector<VirtualCameraSink> extraSinks;
+    std::string sinkError;
+    if (!parseVirtualCameraSinks(m_settings.virtualCameraExtraSinks, extraSinks, sinkError)) {
+        addError("virtual_camera_extra_sinks: " + sinkError);
+    } else {
+        for (const VirtualCameraSink &sink : extraSinks) {
+            if (sink.device == m_settings.virtualCameraDevice) {
+                addError("virtual_camera_extra_sinks cannot repeat virtual_camera_device " + sink.device);
+            }
+        }
+    }
+
     return errors.empty();
 }
 
@@ -778,7 +968,19 @@ bool Config::save()
     file << "audio_auto_gain=" << (m_settings.audioAutoGain ? "enabled" : "disabled") << "\n\n";
 
     file << "# Preferred preview format (auto or WIDTHxHEIGHT@FPS)\n";
-    file << "preview_format=" << (m_settings.previewFormat.empty() ? "auto" : m_settings.previewFormat) << "\n\n";
+    file << "preview_format=" << (m_settings.previewFormat.empty() ? "auto" : m_settings.previewFormat) << "\n";
+    file << "# Preview rendering: display samples a preview-sized copy and, while the\n";
+    file << "# virtual camera is off, runs the effects at preview size; full always\n";
+    file << "# renders at the camera resolution\n";
+    file << "preview_quality=" << (m_settings.previewQuality.empty() ? "display" : m_settings.previewQuality) << "\n\n";
+
+    file << "# Camera capture backend: qt (QtMultimedia) or v4l2 (direct mmap streaming)\n";
+    file << "capture_backend=" << (m_settings.captureBackend.empty() ? "qt" : m_settings.captureBackend) << "\n";
+    file << "# Device for the v4l2 backend: auto uses the OBSBOT camera, or a\n";
+    file << "# /dev/videoN path (e.g. a vivid or v4l2loopback node for testing)\n";
+    file << "capture_device=" << (m_settings.captureDevice.empty() ? "auto" : m_settings.captureDevice) << "\n";
+    file << "# Capture buffers requested from the driver by the v4l2 backend (2-16)\n";
+    file << "capture_buffers=" << m_settings.captureBuffers << "\n\n";
 
     file << "# Application Settings\n";
     file << "# Start application minimized to system tray\n";
@@ -789,12 +991,113 @@ bool Config::save()
     file << "virtual_camera_device=" << (m_settings.virtualCameraDevice.empty() ? "/dev/video42" : m_settings.virtualCameraDevice) << "\n";
     file << "# Set 'match' to follow the preview output, or WIDTHxHEIGHT (e.g. 1280x720)\n";
     file << "virtual_camera_resolution=" << (m_settings.virtualCameraResolution.empty() ? "match" : m_settings.virtualCameraResolution) << "\n";
+    file << "# Output pixel format: yuyv, nv12, i420 or mjpeg. MJPEG uses the least\n";
+    file << "# memory bandwidth at high resolutions at the cost of CPU encoding time\n";
+    file << "virtual_camera_format=" << (m_settings.virtualCameraFormat.empty() ? "yuyv" : m_settings.virtualCameraFormat) << "\n";
+    file << "# Convert to YUYV on the GPU instead of the CPU (saves a full-size RGB readback).\n";
+    file << "# Only used with the yuyv output format\n";
+    file << "virtual_camera_gpu_conversion=" << (m_settings.virtualCameraGpuConversion ? "enabled" : "disabled") << "\n";
+    file << "# Frames the virtual camera output lags the preview (0-2). 0 reads back\n";
+    file << "# synchronously and can stall the UI; 1 or more overlaps readback with rendering\n";
+    file << "virtual_camera_readback_latency=" << m_settings.virtualCameraReadbackLatency << "\n";
+    file << "# Frame rate of the effects pipeline (1-120), independent of the preview.\n";
+    file << "# 0 processes every captured frame; otherwise extra frames are dropped.\n";
+    file << "# To hold a rate on the device, set virtual_camera_output_fps\n";
+    file << "virtual_camera_fps=" << m_settings.virtualCameraFps << "\n";
+    file << "# Threads used to scale and convert each virtual camera frame (0-16).\n";
+    file << "# 0 picks a count from the available CPU cores\n";
+    file << "virtual_camera_threads=" << m_settings.virtualCameraThreads << "\n";
+    file << "# Frame rate written to the virtual camera (1-120). Missing frames are\n";
+    file << "# repeated and extra ones dropped; 0 writes frames as they arrive\n";
+    file << "virtual_camera_output_fps=" << m_settings.virtualCameraOutputFps << "\n";
+    file << "# More devices fed from the same frames, comma-separated\n";
+    file << "# DEVICE[:RESOLUTION[:FORMAT]] (e.g. /dev/video43:1280x720:nv12).\n";
+    file << "# Sinks with the same resolution and format share the conversion work\n";
+    file << "virtual_camera_extra_sinks=" << m_settings.virtualCameraExtraSinks << "\n";
 
     file.close();
     std::cout << "[Config] Configuration saved successfully to " << configPath << std::endl;
     return true;
 }
 
+bool Config::parseVirtualCameraSinks(const std::string &value,
+                                     std::vector<VirtualCameraSink> &sinks,
+                                     std::string &error)
+{
+    sinks.clear();
+
+    auto trim = [](const std::string &text) -> std::string {
+        const size_t first = text.find_first_not_of(" \t");
+        if (first == std::string::npos) {
+            return std::string();
+        }
+        const size_t last = text.find_last_not_of(" \t");
+        return text.substr(first, last - first + 1);
+    };
+
+    std::stringstream entries(value);
+    std::string entry;
+    while (std::getline(entries, entry, ',')) {
+        entry = trim(entry);
+        if (entry.empty()) {
+            continue;
+        }
+
+        std::vector<std::string> fields;
+        std::stringstream parts(entry);
+        std::string field;
+        while (std::getline(parts, field, ':')) {
+            fields.push_back(trim(field));
+        }
+        if (fields.empty() || fields.size() > 3 || fields[0].empty()) {
+            error = "'" + entry + "' must be DEVICE[:RESOLUTION[:FORMAT]]";
+            return false;
+        }
+
+        VirtualCameraSink sink;
+        sink.device = fields[0];
+        sink.resolution = fields.size() > 1 && !fields[1].empty() ? fields[1] : "match";
+        sink.format = fields.size() > 2 && !fields[2].empty() ? fields[2] : "yuyv";
+        std::replace(sink.resolution.begin(), sink.resolution.end(), 'X', 'x');
+        std::transform(sink.format.begin(), sink.format.end(), sink.format.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        if (sink.resolution != "match") {
+            const size_t sep = sink.resolution.find('x');
+            bool validResolution = sep != std::string::npos;
+            if (validResolution) {
+                try {
+                    const int width = std::stoi(sink.resolution.substr(0, sep));
+                    const int height = std::stoi(sink.resolution.substr(sep + 1));
+                    validResolution = width > 0 && height > 0;
+                    sink.resolution = std::to_string(width) + "x" + std::to_string(height);
+                } catch (...) {
+                    validResolution = false;
+                }
+            }
+            if (!validResolution) {
+                error = "resolution of " + sink.device + " must be 'match' or WIDTHxHEIGHT (e.g. 1280x720)";
+                return false;
+            }
+        }
+
+        if (sink.format != "yuyv" && sink.format != "nv12" && sink.format != "i420" && sink.format != "mjpeg") {
+            error = "format of " + sink.device + " must be yuyv, nv12, i420 or mjpeg";
+            return false;
+        }
+
+        for (const VirtualCameraSink &existing : sinks) {
+            if (existing.device == sink.device) {
+                error = sink.device + " is listed more than once";
+                return false;
+            }
+        }
+        sinks.push_back(sink);
+    }
+
+    return true;
+}
+
 bool Config::resetToDefaults(bool saveToFile)
 {
     setDefaults();
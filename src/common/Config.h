@@ -68,6 +68,10 @@ public:
 
         // Preview / video
         std::string previewFormat; // Encoded as "widthxheight@fps" or "auto"
+        std::string previewQuality; // "display" (render at preview size when possible) or "full"
+        std::string captureBackend; // "qt" (QtMultimedia) or "v4l2" (direct mmap streaming)
+        std::string captureDevice;  // "auto" or a /dev/videoN path for the v4l2 backend
+        int captureBuffers;         // V4L2 capture buffers (2-16)
 
         std::array<PresetSlot, 3> presets;
 
@@ -76,6 +80,19 @@ public:
         bool virtualCameraEnabled;
         std::string virtualCameraDevice;
         std::string virtualCameraResolution;
+        std::string virtualCameraFormat;  // yuyv, nv12, i420 or mjpeg
+        bool virtualCameraGpuConversion; // Pack YUYV on the GPU before readback
+        int virtualCameraReadbackLatency; // Frames of readback delay (0-2), 0 = synchronous
+        int virtualCameraFps;  // Effects pipeline clock (0-120), 0 = follow the camera
+        int virtualCameraThreads;  // Conversion threads (0-16), 0 = pick from the CPU count
+        int virtualCameraOutputFps;  // Paced device output (0-120), 0 = write frames as they arrive
+        std::string virtualCameraExtraSinks;  // DEVICE[:RESOLUTION[:FORMAT]],... fed alongside the primary device
+    };
+
+    struct VirtualCameraSink {
+        std::string device;
+        std::string resolution;  // "match" or WIDTHxHEIGHT
+        std::string format;      // yuyv, nv12, i420 or mjpeg
     };
 
     Config();
@@ -131,6 +148,17 @@ public:
      */
     void disableSaving() { m_savingEnabled = false; }
 
+    /**
+     * @brief Parse a virtual_camera_extra_sinks value
+     * @param value Comma-separated DEVICE[:RESOLUTION[:FORMAT]] entries
+     * @param sinks Output parameter for the normalized sinks
+     * @param error Output parameter describing the first invalid entry
+     * @return true if every entry is valid
+     */
+    static bool parseVirtualCameraSinks(const std::string &value,
+                                        std::vector<VirtualCameraSink> &sinks,
+                                        std::string &error);
+
 private:
     CameraSettings m_settings;
     bool m_savingEnabled;
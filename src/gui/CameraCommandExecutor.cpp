@@ -0,0 +1,213 @@
+#include "CameraCommandExecutor.h"
+
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+Q_LOGGING_CATEGORY(CameraCommandLog, "obsbot.camera")
+
+namespace {
+
+// USB control transfers normally finish in a few milliseconds
+constexpr qint64 kSlowCommandMs = 250;
+
+struct PendingCommand {
+    QString key;  // Empty for commands that are never coalesced
+    QString description;
+    CameraCommandExecutor::Work work;
+    CameraCommandExecutor::Completion done;
+};
+
+} // namespace
+
+class CameraCommandWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CameraCommandWorker(CameraCommandExecutor *owner)
+        : m_owner(owner)
+        , m_drainScheduled(false)
+    {
+    }
+
+    // Called from the owner's thread
+    void enqueue(PendingCommand command)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!command.key.isEmpty()) {
+            auto pending = std::find_if(m_queue.begin(), m_queue.end(),
+                [&command](const PendingCommand &queued) { return queued.key == command.key; });
+            if (pending != m_queue.end()) {
+                // The newer set goes to the back: commands posted after the old
+                // one, such as the earlier steps of a batch, may depend on it
+                m_queue.erase(pending);
+                ++m_statistics.coalesced;
+            }
+        }
+        m_queue.push_back(std::move(command));
+        if (m_drainScheduled) {
+            return;
+        }
+        m_drainScheduled = true;
+        locker.unlock();
+        QMetaObject::invokeMethod(this, &CameraCommandWorker::drain, Qt::QueuedConnection);
+    }
+
+    int cancelPending()
+    {
+        QMutexLocker locker(&m_mutex);
+        const int dropped = static_cast<int>(m_queue.size());
+        m_queue.clear();
+        return dropped;
+    }
+
+    int pendingCount() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return static_cast<int>(m_queue.size());
+    }
+
+    CameraCommandExecutor::Statistics statistics() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_statistics;
+    }
+
+public slots:
+    void drain()
+    {
+        for (;;) {
+            PendingCommand command;
+            {
+                QMutexLocker locker(&m_mutex);
+                if (m_queue.empty()) {
+                    m_drainScheduled = false;
+                    return;
+                }
+                command = std::move(m_queue.front());
+                m_queue.pop_front();
+                ++m_statistics.sent;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            command.work();
+            const qint64 elapsed = timer.elapsed();
+            if (elapsed >= kSlowCommandMs) {
+                qCDebug(CameraCommandLog) << command.description << "took" << elapsed << "ms";
+            }
+
+            if (command.done) {
+                QMetaObject::invokeMethod(m_owner, std::move(command.done), Qt::QueuedConnection);
+            }
+        }
+    }
+
+private:
+    CameraCommandExecutor *m_owner;
+    mutable QMutex m_mutex;
+    std::deque<PendingCommand> m_queue;
+    CameraCommandExecutor::Statistics m_statistics;
+    bool m_drainScheduled;
+};
+
+CameraCommandExecutor::CameraCommandExecutor(QObject *parent)
+    : QObject(parent)
+    , m_workerThread(nullptr)
+    , m_worker(nullptr)
+    , m_generation(0)
+{
+}
+
+CameraCommandExecutor::~CameraCommandExecutor()
+{
+    if (m_workerThread && m_worker) {
+        const Statistics counts = m_worker->statistics();
+        qCDebug(CameraCommandLog) << "Camera commands sent:" << counts.sent
+                                  << "coalesced:" << counts.coalesced;
+        m_worker->cancelPending();
+        m_workerThread->quit();
+        m_workerThread->wait();
+        m_worker = nullptr;
+        m_workerThread = nullptr;
+    }
+}
+
+void CameraCommandExecutor::post(const QString &description, Work work, Completion done)
+{
+    if (!work) {
+        return;
+    }
+    ensureWorker();
+    m_worker->enqueue(PendingCommand{QString(), description, std::move(work), guardCompletion(std::move(done))});
+}
+
+void CameraCommandExecutor::postCoalesced(const QString &key, const QString &description,
+                                          Work work, Completion done)
+{
+    if (!work) {
+        return;
+    }
+    ensureWorker();
+    m_worker->enqueue(PendingCommand{key, description, std::move(work), guardCompletion(std::move(done))});
+}
+
+void CameraCommandExecutor::cancelPending()
+{
+    ++m_generation;
+    if (!m_worker) {
+        return;
+    }
+    const int dropped = m_worker->cancelPending();
+    if (dropped > 0) {
+        qCDebug(CameraCommandLog) << "Dropped" << dropped << "pending camera commands";
+    }
+}
+
+int CameraCommandExecutor::pendingCount() const
+{
+    return m_worker ? m_worker->pendingCount() : 0;
+}
+
+CameraCommandExecutor::Statistics CameraCommandExecutor::statistics() const
+{
+    return m_worker ? m_worker->statistics() : Statistics();
+}
+
+CameraCommandExecutor::Completion CameraCommandExecutor::guardCompletion(Completion done)
+{
+    if (!done) {
+        return done;
+    }
+    // Runs on this thread, after any cancelPending() made before it
+    return [this, generation = m_generation, done = std::move(done)]() {
+        if (generation == m_generation) {
+            done();
+        }
+    };
+}
+
+void CameraCommandExecutor::ensureWorker()
+{
+    if (m_worker) {
+        return;
+    }
+
+    m_workerThread = new QThread(this);
+    m_workerThread->setObjectName(QStringLiteral("CameraCommands"));
+    m_worker = new CameraCommandWorker(this);
+    m_worker->moveToThread(m_workerThread);
+    connect(m_workerThread, &QThread::finished,
+            m_worker, &QObject::deleteLater);
+    m_workerThread->start();
+}
+
+#include "CameraCommandExecutor.moc"
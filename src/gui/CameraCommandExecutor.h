@@ -0,0 +1,70 @@
+#ifndef CAMERACOMMANDEXECUTOR_H
+#define CAMERACOMMANDEXECUTOR_H
+
+#include <QObject>
+#include <QString>
+#include <functional>
+
+class QThread;
+class CameraCommandWorker;
+
+/**
+ * @brief Runs blocking OBSBOT SDK calls on a dedicated thread, in order.
+ *
+ * Every SDK transaction is a USB round trip that can take a noticeable
+ * time, so CameraController posts them here instead of making them on the
+ * GUI thread. Work runs on the command thread strictly in the order it was
+ * posted. Its completion, if any, is then called back on the thread that
+ * owns the executor, where it may update state and emit signals.
+ *
+ * Work must capture what it needs by value (typically the device's
+ * shared_ptr) and must not touch the poster's members.
+ *
+ * cancelPending() starts a new generation: queued work is dropped, and the
+ * command running at the time still finishes but its completion is
+ * skipped, so nothing meant for a device that has gone reaches the poster.
+ *
+ * Sets of one parameter can be coalesced: postCoalesced() drops a queued,
+ * not yet started command with the same key and appends the new one, so
+ * a slider drag costs one round trip in flight plus one waiting, whatever
+ * the event rate. The replaced command's completion never runs. Because the
+ * new command goes to the back, everything still runs in posting order.
+ */
+class CameraCommandExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Work = std::function<void()>;
+    using Completion = std::function<void()>;
+
+    struct Statistics {
+        quint64 sent = 0;       // Commands that ran on the device
+        quint64 coalesced = 0;  // Commands replaced before they ran
+    };
+
+    explicit CameraCommandExecutor(QObject *parent = nullptr);
+    // Drops work that has not started and waits for the running one
+    ~CameraCommandExecutor() override;
+
+    // The description is only used for logging
+    void post(const QString &description, Work work, Completion done = {});
+    // Same, but first drops a pending command with the same key
+    void postCoalesced(const QString &key, const QString &description, Work work, Completion done = {});
+
+    // Work that has not started is dropped together with its completion;
+    // so is the completion of the command that is running
+    void cancelPending();
+    int pendingCount() const;
+    Statistics statistics() const;
+
+private:
+    void ensureWorker();
+    Completion guardCompletion(Completion done);
+
+    QThread *m_workerThread;
+    CameraCommandWorker *m_worker;
+    quint64 m_generation;  // Bumped by cancelPending(); owner thread only
+};
+
+#endif // CAMERACOMMANDEXECUTOR_H
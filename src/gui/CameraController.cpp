@@ -1,13 +1,143 @@
 #include "CameraController.h"
-#include <QThread>
+#include <QCoreApplication>
+#include <QHash>
+#include <QMetaObject>
 #include <algorithm>
 
+namespace {
+
+// Everything updateState() reads, gathered on the command thread
+struct StatusSnapshot {
+    Device::CameraStatus status{};
+    bool brightnessValid = false;
+    int32_t brightness = 0;
+    bool contrastValid = false;
+    int32_t contrast = 0;
+    bool saturationValid = false;
+    int32_t saturation = 0;
+    bool whiteBalanceValid = false;
+    Device::DevWhiteBalanceType whiteBalanceType = Device::DevWhiteBalanceAuto;
+    int32_t whiteBalanceParam = 0;
+};
+
+struct ControlRanges {
+    CameraController::ParamRange brightness;
+    CameraController::ParamRange contrast;
+    CameraController::ParamRange saturation;
+    CameraController::ParamRange whiteBalanceKelvin;
+    std::vector<int> whiteBalanceTypes;
+};
+
+struct WhiteBalanceReading {
+    bool valid = false;
+    Device::DevWhiteBalanceType type = Device::DevWhiteBalanceAuto;
+    int32_t param = 0;
+};
+
+CameraController::StateFields changedFields(const CameraController::CameraState &before,
+                                            const CameraController::CameraState &after)
+{
+    CameraController::StateFields changed;
+    auto compare = [&changed](const auto &a, const auto &b, CameraController::StateField field) {
+        if (a != b) {
+            changed |= field;
+        }
+    };
+
+    compare(before.autoFramingEnabled, after.autoFramingEnabled, CameraController::AutoFramingField);
+    compare(before.aiMode, after.aiMode, CameraController::AiModeField);
+    compare(before.aiSubMode, after.aiSubMode, CameraController::AiSubModeField);
+    compare(before.autoZoomEnabled, after.autoZoomEnabled, CameraController::AutoZoomField);
+    compare(before.trackSpeedMode, after.trackSpeedMode, CameraController::TrackSpeedField);
+    compare(before.audioAutoGainEnabled, after.audioAutoGainEnabled, CameraController::AudioAutoGainField);
+    compare(before.pan, after.pan, CameraController::PanField);
+    compare(before.tilt, after.tilt, CameraController::TiltField);
+    compare(before.zoom, after.zoom, CameraController::ZoomField);
+    compare(before.hdrEnabled, after.hdrEnabled, CameraController::HdrField);
+    compare(before.fovMode, after.fovMode, CameraController::FovField);
+    compare(before.faceAEEnabled, after.faceAEEnabled, CameraController::FaceAEField);
+    compare(before.faceFocusEnabled, after.faceFocusEnabled, CameraController::FaceFocusField);
+    compare(before.autoFocusEnabled, after.autoFocusEnabled, CameraController::AutoFocusField);
+    compare(before.brightnessAuto, after.brightnessAuto, CameraController::BrightnessAutoField);
+    compare(before.brightness, after.brightness, CameraController::BrightnessField);
+    compare(before.contrastAuto, after.contrastAuto, CameraController::ContrastAutoField);
+    compare(before.contrast, after.contrast, CameraController::ContrastField);
+    compare(before.saturationAuto, after.saturationAuto, CameraController::SaturationAutoField);
+    compare(before.saturation, after.saturation, CameraController::SaturationField);
+    compare(before.whiteBalance, after.whiteBalance, CameraController::WhiteBalanceField);
+    compare(before.whiteBalanceKelvin, after.whiteBalanceKelvin, CameraController::WhiteBalanceKelvinField);
+    compare(before.zoomRatio, after.zoomRatio, CameraController::ZoomRatioField);
+    compare(before.devStatus, after.devStatus, CameraController::DevStatusField);
+    return changed;
+}
+
+// The state fields a coalescing key of executeCommand() sets
+CameraController::StateFields fieldsForParameter(const QString &parameter)
+{
+    static const QHash<QString, CameraController::StateFields> fields = {
+        {QStringLiteral("mediaMode"), CameraController::AutoFramingField},
+        {QStringLiteral("aiMode"), CameraController::AiModeField | CameraController::AiSubModeField},
+        {QStringLiteral("autoZoom"), CameraController::AutoZoomField},
+        {QStringLiteral("trackSpeed"), CameraController::TrackSpeedField},
+        {QStringLiteral("audioAutoGain"), CameraController::AudioAutoGainField},
+        {QStringLiteral("panTilt"), CameraController::PanField | CameraController::TiltField},
+        {QStringLiteral("zoom"), CameraController::ZoomField},
+        {QStringLiteral("hdr"), CameraController::HdrField},
+        {QStringLiteral("fov"), CameraController::FovField},
+        {QStringLiteral("faceAE"), CameraController::FaceAEField},
+        {QStringLiteral("faceFocus"), CameraController::FaceFocusField},
+        {QStringLiteral("brightness"), CameraController::BrightnessField},
+        {QStringLiteral("contrast"), CameraController::ContrastField},
+        {QStringLiteral("saturation"), CameraController::SaturationField},
+        {QStringLiteral("whiteBalance"),
+         CameraController::WhiteBalanceField | CameraController::WhiteBalanceKelvinField},
+    };
+    return fields.value(parameter);
+}
+
+void disableStatusPush(Device &device)
+{
+    device.enableDevStatusCallback(false);
+    device.setDevStatusCallbackFunc(nullptr, nullptr);
+    device.setFastDevStatusCallbackFunc(nullptr, nullptr);
+}
+
+// SDK callbacks run on SDK threads and can fire while the controller is
+// being destroyed, so they never touch it there. The call is queued on the
+// application object, which outlives the controller, and only made if the
+// token is still set once it reaches the GUI thread, where tokens are cleared.
+void postIfAlive(const std::shared_ptr<std::atomic<bool>> &token, std::function<void()> call)
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    if (!app || !token->load()) {
+        return;
+    }
+    QMetaObject::invokeMethod(app, [token, call = std::move(call)]() {
+        if (token->load()) {
+            call();
+        }
+    }, Qt::QueuedConnection);
+}
+
+} // namespace
+
 CameraController::CameraController(QObject *parent)
     : QObject(parent)
     , m_connected(false)
-    , m_settlingTimer(nullptr)
+    , m_commands(new CameraCommandExecutor(this))
+    , m_alive(std::make_shared<std::atomic<bool>>(true))
+    , m_devChangedRegistered(false)
+    , m_statePublished(false)
+    , m_deviceStateKnown(false)
+    , m_stateReadPending(false)
+    , m_hasDeferredState(false)
+    , m_settling(false)
+    , m_batchSerial(0)
+    , m_targetPan(0.0)
+    , m_targetTilt(0.0)
 {
     m_currentState = {};
+    m_publishedState = {};
     m_cachedState = {};
     m_currentState.whiteBalanceKelvin = 5000;
     m_cachedState.whiteBalanceKelvin = 5000;
@@ -15,47 +145,43 @@ CameraController::CameraController(QObject *parent)
     m_whiteBalanceFallbackActive = false;
     m_fallbackWhiteBalanceMode = static_cast<int>(Device::DevWhiteBalanceAuto);
 
-    // Create settling timer
-    m_settlingTimer = new QTimer(this);
-    m_settlingTimer->setSingleShot(true);
-
     resetControlRanges();
 }
 
 CameraController::~CameraController()
 {
+    // Callbacks already on their way are dropped by the tokens
+    m_alive->store(false);
+    if (m_pushToken) {
+        m_pushToken->store(false);
+    }
+    if (m_devChangedRegistered) {
+        Devices::get().setDevChangedCallback(nullptr, nullptr);
+    }
+
+    // Drops queued commands and waits for the running one, so nothing else
+    // is using the device when the SDK is told to stop pushing status
+    delete m_commands;
+    m_commands = nullptr;
+    if (m_device) {
+        disableStatusPush(*m_device);
+    }
 }
 
 void CameraController::connectToCamera()
 {
-    // Setup device detection callback
-    auto onDevChanged = [this](std::string dev_sn, bool connected, void *param) {
-        if (connected) {
-            // Device connected
-            auto dev_list = Devices::get().getDevList();
-            if (!dev_list.empty()) {
-                m_device = dev_list.front();
-                m_connected = true;
-
-                m_cameraInfo.name = QString::fromStdString(m_device->devName());
-                m_cameraInfo.serialNumber = QString::fromStdString(m_device->devSn());
-                m_cameraInfo.version = QString::fromStdString(m_device->devVersion());
-                m_cameraInfo.productType = m_device->productType();
-                m_cameraInfo.connected = true;
-
-                refreshControlRanges();
-                emit cameraConnected(m_cameraInfo);
-                updateState();
-            }
-        } else {
-            m_connected = false;
-            m_cameraInfo.connected = false;
-            resetControlRanges();
-            emit cameraDisconnected();
-        }
+    // Setup device detection callback. It fires on an SDK thread, while the
+    // device handle and state belong to the GUI thread.
+    auto onDevChanged = [this, alive = m_alive](std::string dev_sn, bool connected, void *param) {
+        Q_UNUSED(dev_sn);
+        Q_UNUSED(param);
+        postIfAlive(alive, [this, connected]() {
+            handleDeviceChanged(connected);
+        });
     };
 
     Devices::get().setDevChangedCallback(onDevChanged, nullptr);
+    m_devChangedRegistered = true;
     Devices::get().setEnableMdnsScan(false);  // USB only
 
     // Actively check for existing devices (handles reconnection scenario)
@@ -63,43 +189,146 @@ void CameraController::connectToCamera()
     // is already connected (e.g., after window restore), we need to connect directly
     auto dev_list = Devices::get().getDevList();
     if (!dev_list.empty() && !m_connected) {
-        m_device = dev_list.front();
-        m_connected = true;
+        attachDevice(dev_list.front());
+    }
+}
+
+void CameraController::disconnectFromCamera()
+{
+    if (m_connected) {
+        detachDevice();
+        emit cameraDisconnected();
+    }
+}
+
+void CameraController::detachDevice()
+{
+    // Queued commands are for this device only
+    m_commands->cancelPending();
+    if (m_pushToken) {
+        m_pushToken->store(false);
+        m_pushToken.reset();
+    }
+    if (m_device) {
+        m_commands->post(QStringLiteral("Disable status push"), [device = m_device]() {
+            disableStatusPush(*device);
+        });
+    }
 
-        m_cameraInfo.name = QString::fromStdString(m_device->devName());
-        m_cameraInfo.serialNumber = QString::fromStdString(m_device->devSn());
+    // Release our device handle - this allows other apps to access the camera
+    m_device.reset();
+    m_connected = false;
+    m_settling = false;
+    m_stateReadPending = false;
+    m_hasDeferredState = false;
+    m_cameraInfo.connected = false;
+    resetControlRanges();
+}
+
+void CameraController::attachDevice(const std::shared_ptr<Device> &device)
+{
+    // Commands, completions and pushes still in flight were meant for the
+    // old device
+    m_commands->cancelPending();
+    if (m_pushToken) {
+        m_pushToken->store(false);
+        m_pushToken.reset();
+    }
+    if (m_device && m_device != device) {
+        m_commands->post(QStringLiteral("Disable status push"), [previous = m_device]() {
+            disableStatusPush(*previous);
+        });
+    }
+    m_device = device;
+    m_statePublished = false;
+    m_deviceStateKnown = false;
+    m_stateReadPending = false;
+    m_hasDeferredState = false;
+    m_failedFields = {};
+    m_settling = false;
+    m_connected = true;
+
+    m_cameraInfo.name = QString::fromStdString(m_device->devName());
+    m_cameraInfo.serialNumber = QString::fromStdString(m_device->devSn());
     m_cameraInfo.version = QString::fromStdString(m_device->devVersion());
     m_cameraInfo.productType = m_device->productType();
     m_cameraInfo.connected = true;
 
-    refreshControlRanges();
-    emit cameraConnected(m_cameraInfo);
-    updateState();
-    }
+    // Listeners may apply settings as soon as they hear of the camera, and
+    // those are clamped to the ranges, so announce it once they are known.
+    // The read goes first, so what they apply waits for it.
+    refreshControlRanges([this]() {
+        updateState();
+        emit cameraConnected(m_cameraInfo);
+        enableStatusPush();
+    });
 }
 
-void CameraController::disconnectFromCamera()
+void CameraController::enableStatusPush()
 {
-    if (m_connected) {
-        // Release our device handle - this allows other apps to access the camera
-        m_device.reset();
-        m_connected = false;
-        m_cameraInfo.connected = false;
-        resetControlRanges();
+    // Both callbacks run on SDK threads, every two or three seconds. The
+    // token is cleared when this device is detached or the controller goes.
+    m_pushToken = std::make_shared<std::atomic<bool>>(true);
+    auto onStatus = [this, token = m_pushToken](const void *data) {
+        if (!data) {
+            return;
+        }
+        const Device::CameraStatus status = *static_cast<const Device::CameraStatus *>(data);
+        postIfAlive(token, [this, status]() {
+            handleStatusPush(status);
+        });
+    };
 
-        emit cameraDisconnected();
+    m_commands->post(QStringLiteral("Enable status push"), [device = m_device, onStatus]() {
+        device->setDevStatusCallbackFunc([onStatus](void *, const void *data) {
+            onStatus(data);
+        }, nullptr);
+        device->setFastDevStatusCallbackFunc([onStatus](void *, const void *data, const std::string &) {
+            onStatus(data);
+        }, nullptr);
+        device->enableDevStatusCallback(true);
+    });
+}
+
+void CameraController::handleStatusPush(const Device::CameraStatus &status)
+{
+    if (!m_connected) {
+        return;
     }
+
+    // Don't update from camera during settling period
+    if (isSettling()) {
+        return;
+    }
+
+    applyCameraStatus(status);
+    publishState();
 }
 
-CameraController::CameraState CameraController::getCurrentState()
+void CameraController::handleDeviceChanged(bool connected)
 {
-    if (m_connected && !isSettling()) {
-        updateState();
+    if (connected) {
+        auto dev_list = Devices::get().getDevList();
+        if (!dev_list.empty()) {
+            attachDevice(dev_list.front());
+        }
+    } else {
+        detachDevice();
+        emit cameraDisconnected();
     }
+}
+
+CameraController::CameraState CameraController::getCurrentState() const
+{
     // Return cached state during settling, actual state otherwise
     return isSettling() ? m_cachedState : m_currentState;
 }
 
+CameraCommandExecutor::Statistics CameraController::commandStatistics() const
+{
+    return m_commands->statistics();
+}
+
 bool CameraController::hasTiny2Capabilities() const
 {
     return isTiny2Family();
@@ -110,33 +339,27 @@ bool CameraController::enableAutoFraming(bool enabled)
     if (!m_connected) return false;
 
     if (enabled) {
-        // Step 1: Set MediaMode to AutoFrame
-        if (!executeCommand("Set MediaMode to AutoFrame", [this]() {
-            return m_device->cameraSetMediaModeU(Device::MediaModeAutoFrame);
-        })) {
-            return false;
-        }
-
-        // Step 2: Set auto-framing mode after a brief delay (non-blocking)
-        QTimer::singleShot(500, [this]() {
-            executeCommand("Set AutoFraming mode", [this]() {
-                return m_device->cameraSetAutoFramingModeU(Device::AutoFrmSingle, Device::AutoFrmUpperBody);
-            });
+        // Two steps: the framing mode only sticks once the media mode switch
+        // has been acknowledged, which the blocking U call already waits for
+        executeCommand(QStringLiteral("mediaMode"), "Enable AutoFraming", [](Device &device) {
+            int32_t ret = device.cameraSetMediaModeU(Device::MediaModeAutoFrame);
+            if (ret != 0) {
+                return ret;
+            }
+            return device.cameraSetAutoFramingModeU(Device::AutoFrmSingle, Device::AutoFrmUpperBody);
+        }, [this]() {
+            m_currentState.autoFramingEnabled = true;
+            publishState();
         });
-
-        m_currentState.autoFramingEnabled = true;
-        emit stateChanged(m_currentState);
-        return true;  // First command succeeded, second is pending
     } else {
-        bool success = executeCommand("Disable AutoFraming", [this]() {
-            return m_device->cameraSetMediaModeU(Device::MediaModeNormal);
-        });
-        if (success) {
+        executeCommand(QStringLiteral("mediaMode"), "Disable AutoFraming", [](Device &device) {
+            return device.cameraSetMediaModeU(Device::MediaModeNormal);
+        }, [this]() {
             m_currentState.autoFramingEnabled = false;
-            emit stateChanged(m_currentState);
-        }
-        return success;
+            publishState();
+        });
     }
+    return true;
 }
 
 bool CameraController::setAiMode(int mode, int subMode)
@@ -144,34 +367,28 @@ bool CameraController::setAiMode(int mode, int subMode)
     if (!m_connected) return false;
 
     auto workMode = static_cast<Device::AiWorkModeType>(mode);
-    bool success = executeCommand("Set AI Mode", [this, workMode, subMode]() {
-        return m_device->cameraSetAiModeU(workMode, subMode);
-    });
-
-    if (success) {
+    executeCommand(QStringLiteral("aiMode"), "Set AI Mode", [workMode, subMode](Device &device) {
+        return device.cameraSetAiModeU(workMode, subMode);
+    }, [this, mode, subMode]() {
         m_currentState.aiMode = mode;
         m_currentState.aiSubMode = subMode;
         m_currentState.autoFramingEnabled = (mode != Device::AiWorkModeNone);
-        emit stateChanged(m_currentState);
-    }
-
-    return success;
+        publishState();
+    });
+    return true;
 }
 
 bool CameraController::setAutoZoom(bool enabled)
 {
     if (!m_connected) return false;
 
-    bool success = executeCommand(enabled ? "Enable Auto Zoom" : "Disable Auto Zoom", [this, enabled]() {
-        return m_device->aiSetAiAutoZoomR(enabled);
-    });
-
-    if (success) {
+    executeCommand(QStringLiteral("autoZoom"), enabled ? "Enable Auto Zoom" : "Disable Auto Zoom", [enabled](Device &device) {
+        return device.aiSetAiAutoZoomR(enabled);
+    }, [this, enabled]() {
         m_currentState.autoZoomEnabled = enabled;
-        emit stateChanged(m_currentState);
-    }
-
-    return success;
+        publishState();
+    });
+    return true;
 }
 
 bool CameraController::setTrackSpeed(int speedMode)
@@ -179,32 +396,26 @@ bool CameraController::setTrackSpeed(int speedMode)
     if (!m_connected) return false;
 
     auto speed = static_cast<Device::AiTrackSpeedType>(speedMode);
-    bool success = executeCommand("Set Tracking Speed", [this, speed]() {
-        return m_device->aiSetTrackSpeedTypeR(speed);
-    });
-
-    if (success) {
+    executeCommand(QStringLiteral("trackSpeed"), "Set Tracking Speed", [speed](Device &device) {
+        return device.aiSetTrackSpeedTypeR(speed);
+    }, [this, speedMode]() {
         m_currentState.trackSpeedMode = speedMode;
-        emit stateChanged(m_currentState);
-    }
-
-    return success;
+        publishState();
+    });
+    return true;
 }
 
 bool CameraController::setAudioAutoGain(bool enabled)
 {
     if (!m_connected) return false;
 
-    bool success = executeCommand(enabled ? "Enable Audio Auto Gain" : "Disable Audio Auto Gain", [this, enabled]() {
-        return m_device->cameraSetAudioAutoGainU(enabled);
-    });
-
-    if (success) {
+    executeCommand(QStringLiteral("audioAutoGain"), enabled ? "Enable Audio Auto Gain" : "Disable Audio Auto Gain", [enabled](Device &device) {
+        return device.cameraSetAudioAutoGainU(enabled);
+    }, [this, enabled]() {
         m_currentState.audioAutoGainEnabled = enabled;
-        emit stateChanged(m_currentState);
-    }
-
-    return success;
+        publishState();
+    });
+    return true;
 }
 
 bool CameraController::setPanTilt(double pan, double tilt)
@@ -214,30 +425,32 @@ bool CameraController::setPanTilt(double pan, double tilt)
     // Clamp values
     pan = qBound(-1.0, pan, 1.0);
     tilt = qBound(-1.0, tilt, 1.0);
+    m_targetPan = pan;
+    m_targetTilt = tilt;
 
-    bool success = executeCommand("Set Pan/Tilt", [this, pan, tilt]() {
-        return m_device->cameraSetPanTiltAbsolute(pan, tilt);
-    });
-
-    if (success) {
+    executeCommand(QStringLiteral("panTilt"), "Set Pan/Tilt", [pan, tilt](Device &device) {
+        return device.cameraSetPanTiltAbsolute(pan, tilt);
+    }, [this, pan, tilt]() {
         m_currentState.pan = pan;
         m_currentState.tilt = tilt;
-        emit stateChanged(m_currentState);
-    }
-
-    return success;
+        publishState();
+    }, [this]() {
+        m_targetPan = m_currentState.pan;
+        m_targetTilt = m_currentState.tilt;
+    });
+    return true;
 }
 
 bool CameraController::adjustPan(double delta)
 {
-    double newPan = m_currentState.pan + delta;
-    return setPanTilt(newPan, m_currentState.tilt);
+    double newPan = m_targetPan + delta;
+    return setPanTilt(newPan, m_targetTilt);
 }
 
 bool CameraController::adjustTilt(double delta)
 {
-    double newTilt = m_currentState.tilt + delta;
-    return setPanTilt(m_currentState.pan, newTilt);
+    double newTilt = m_targetTilt + delta;
+    return setPanTilt(m_targetPan, newTilt);
 }
 
 bool CameraController::setZoom(double zoom)
@@ -247,16 +460,13 @@ bool CameraController::setZoom(double zoom)
     // Clamp to valid range (1.0 - 2.0)
     zoom = qBound(1.0, zoom, 2.0);
 
-    bool success = executeCommand("Set Zoom", [this, zoom]() {
-        return m_device->cameraSetZoomAbsoluteR(zoom);
-    });
-
-    if (success) {
+    executeCommand(QStringLiteral("zoom"), "Set Zoom", [zoom](Device &device) {
+        return device.cameraSetZoomAbsoluteR(zoom);
+    }, [this, zoom]() {
         m_currentState.zoom = zoom;
-        emit stateChanged(m_currentState);
-    }
-
-    return success;
+        publishState();
+    });
+    return true;
 }
 
 bool CameraController::centerView()
@@ -268,9 +478,13 @@ bool CameraController::setHDR(bool enabled)
 {
     if (!m_connected) return false;
 
-    return executeCommand(enabled ? "Enable HDR" : "Disable HDR", [this, enabled]() {
-        return m_device->cameraSetWdrR(enabled ? Device::DevWdrModeDol2TO1 : Device::DevWdrModeNone);
+    executeCommand(QStringLiteral("hdr"), enabled ? "Enable HDR" : "Disable HDR", [enabled](Device &device) {
+        return device.cameraSetWdrR(enabled ? Device::DevWdrModeDol2TO1 : Device::DevWdrModeNone);
+    }, [this, enabled]() {
+        m_currentState.hdrEnabled = enabled;
+        publishState();
     });
+    return true;
 }
 
 bool CameraController::setFOV(int fovMode)
@@ -285,27 +499,39 @@ bool CameraController::setFOV(int fovMode)
         default: return false;
     }
 
-    return executeCommand("Set FOV", [this, fov]() {
-        return m_device->cameraSetFovU(fov);
+    executeCommand(QStringLiteral("fov"), "Set FOV", [fov](Device &device) {
+        return device.cameraSetFovU(fov);
+    }, [this, fovMode]() {
+        m_currentState.fovMode = fovMode;
+        publishState();
     });
+    return true;
 }
 
 bool CameraController::setFaceAE(bool enabled)
 {
     if (!m_connected) return false;
 
-    return executeCommand(enabled ? "Enable Face AE" : "Disable Face AE", [this, enabled]() {
-        return m_device->cameraSetFaceAER(enabled);
+    executeCommand(QStringLiteral("faceAE"), enabled ? "Enable Face AE" : "Disable Face AE", [enabled](Device &device) {
+        return device.cameraSetFaceAER(enabled);
+    }, [this, enabled]() {
+        m_currentState.faceAEEnabled = enabled;
+        publishState();
     });
+    return true;
 }
 
 bool CameraController::setFaceFocus(bool enabled)
 {
     if (!m_connected) return false;
 
-    return executeCommand(enabled ? "Enable Face Focus" : "Disable Face Focus", [this, enabled]() {
-        return m_device->cameraSetFaceFocusR(enabled);
+    executeCommand(QStringLiteral("faceFocus"), enabled ? "Enable Face Focus" : "Disable Face Focus", [enabled](Device &device) {
+        return device.cameraSetFaceFocusR(enabled);
+    }, [this, enabled]() {
+        m_currentState.faceFocusEnabled = enabled;
+        publishState();
     });
+    return true;
 }
 
 bool CameraController::setBrightness(int value)
@@ -318,14 +544,13 @@ bool CameraController::setBrightness(int value)
     }
 
     int clamped = clampToRange(value, m_brightnessRange, 0, 255);
-    bool success = executeCommand("Set Brightness", [this, clamped]() {
-        return m_device->cameraSetImageBrightnessR(clamped);
-    });
-    if (success) {
+    executeCommand(QStringLiteral("brightness"), "Set Brightness", [clamped](Device &device) {
+        return device.cameraSetImageBrightnessR(clamped);
+    }, [this, clamped]() {
         m_currentState.brightness = clamped;
-        emit stateChanged(m_currentState);
-    }
-    return success;
+        publishState();
+    });
+    return true;
 }
 
 bool CameraController::setContrast(int value)
@@ -338,14 +563,13 @@ bool CameraController::setContrast(int value)
     }
 
     int clamped = clampToRange(value, m_contrastRange, 0, 255);
-    bool success = executeCommand("Set Contrast", [this, clamped]() {
-        return m_device->cameraSetImageContrastR(clamped);
-    });
-    if (success) {
+    executeCommand(QStringLiteral("contrast"), "Set Contrast", [clamped](Device &device) {
+        return device.cameraSetImageContrastR(clamped);
+    }, [this, clamped]() {
         m_currentState.contrast = clamped;
-        emit stateChanged(m_currentState);
-    }
-    return success;
+        publishState();
+    });
+    return true;
 }
 
 bool CameraController::setSaturation(int value)
@@ -358,14 +582,13 @@ bool CameraController::setSaturation(int value)
     }
 
     int clamped = clampToRange(value, m_saturationRange, 0, 255);
-    bool success = executeCommand("Set Saturation", [this, clamped]() {
-        return m_device->cameraSetImageSaturationR(clamped);
-    });
-    if (success) {
+    executeCommand(QStringLiteral("saturation"), "Set Saturation", [clamped](Device &device) {
+        return device.cameraSetImageSaturationR(clamped);
+    }, [this, clamped]() {
         m_currentState.saturation = clamped;
-        emit stateChanged(m_currentState);
-    }
-    return success;
+        publishState();
+    });
+    return true;
 }
 
 bool CameraController::setWhiteBalance(int mode)
@@ -383,53 +606,55 @@ bool CameraController::setWhiteBalance(int mode)
     if (mode == static_cast<int>(Device::DevWhiteBalanceAuto)) {
         m_whiteBalanceFallbackActive = false;
         m_fallbackWhiteBalanceMode = mode;
-        bool success = executeCommand("Set White Balance", [this]() {
-            return m_device->cameraSetWhiteBalanceR(Device::DevWhiteBalanceAuto, 0);
-        });
-        if (success) {
+        executeCommand(QStringLiteral("whiteBalance"), "Set White Balance", [](Device &device) {
+            return device.cameraSetWhiteBalanceR(Device::DevWhiteBalanceAuto, 0);
+        }, [this, mode]() {
             m_currentState.whiteBalance = mode;
             if (m_whiteBalanceKelvinRange.valid) {
                 m_currentState.whiteBalanceKelvin = clampToRange(m_whiteBalanceKelvinRange.defaultValue, m_whiteBalanceKelvinRange, 2000, 10000);
             }
-            emit stateChanged(m_currentState);
-        }
-        return success;
+            publishState();
+        });
+        return true;
     }
 
     auto wbType = static_cast<Device::DevWhiteBalanceType>(mode);
     bool attemptDirect = m_supportedWhiteBalanceTypes.empty() ||
         isWhiteBalanceTypeSupported(mode);
-    bool success = false;
-
-    if (attemptDirect) {
-        success = executeCommand("Set White Balance", [this, wbType]() {
-            return m_device->cameraSetWhiteBalanceR(wbType, 0);
-        });
-
-        if (success) {
-            Device::DevWhiteBalanceType readType;
-            int32_t readParam = 0;
-            if (m_device->cameraGetWhiteBalanceR(readType, readParam) == 0 && readType == wbType) {
-                m_whiteBalanceFallbackActive = false;
-                m_fallbackWhiteBalanceMode = mode;
-                m_currentState.whiteBalance = mode;
-                if (m_whiteBalanceKelvinRange.valid) {
-                    m_currentState.whiteBalanceKelvin = clampToRange(readParam, m_whiteBalanceKelvinRange, 2000, 10000);
-                }
-                emit stateChanged(m_currentState);
-                return true;
-            }
-        }
+    if (!attemptDirect) {
+        return applyWhiteBalanceFallback(mode);
     }
 
-    int kelvin = whiteBalancePresetToKelvin(mode);
-    if (kelvin > 0 && m_whiteBalanceKelvinRange.valid) {
-        m_whiteBalanceFallbackActive = true;
+    // Some models accept a preset without switching to it, so read it back
+    auto reading = std::make_shared<WhiteBalanceReading>();
+    auto fallBackUnlessSuperseded = [this, mode]() {
+        if (m_lastRequestedWhiteBalance == mode) {
+            applyWhiteBalanceFallback(mode);
+        }
+    };
+    executeCommand(QStringLiteral("whiteBalance"), "Set White Balance", [wbType, reading](Device &device) {
+        int32_t ret = device.cameraSetWhiteBalanceR(wbType, 0);
+        if (ret == 0) {
+            reading->valid = device.cameraGetWhiteBalanceR(reading->type, reading->param) == 0;
+        }
+        return ret;
+    }, [this, mode, wbType, reading, fallBackUnlessSuperseded]() {
+        if (m_lastRequestedWhiteBalance != mode) {
+            return;
+        }
+        if (!reading->valid || reading->type != wbType) {
+            fallBackUnlessSuperseded();
+            return;
+        }
+        m_whiteBalanceFallbackActive = false;
         m_fallbackWhiteBalanceMode = mode;
-        return applyManualWhiteBalance(kelvin, mode);
-    }
-
-    return success;
+        m_currentState.whiteBalance = mode;
+        if (m_whiteBalanceKelvinRange.valid) {
+            m_currentState.whiteBalanceKelvin = clampToRange(reading->param, m_whiteBalanceKelvinRange, 2000, 10000);
+        }
+        publishState();
+    }, fallBackUnlessSuperseded);
+    return true;
 }
 bool CameraController::setWhiteBalanceManual(int kelvin)
 {
@@ -441,14 +666,34 @@ bool CameraController::setWhiteBalanceManual(int kelvin)
     return applyManualWhiteBalance(kelvin, static_cast<int>(Device::DevWhiteBalanceManual));
 }
 
-bool CameraController::executeCommand(const QString &description, std::function<int32_t()> command)
+void CameraController::executeCommand(const QString &parameter, const QString &description,
+                                      std::function<int32_t(Device &)> command,
+                                      std::function<void()> onSuccess, std::function<void()> onFailure)
 {
-    int32_t ret = command();
-    if (ret != 0) {
-        emit commandFailed(description, ret);
-        return false;
+    if (!m_device) {
+        return;
     }
-    return true;
+
+    // The work holds its own reference, so a disconnect cannot pull the
+    // device out from under a running command
+    // Only the newest value of a parameter matters; a set still waiting in
+    // the queue is replaced rather than sent as well
+    auto result = std::make_shared<int32_t>(0);
+    m_commands->postCoalesced(parameter, description,
+        [device = m_device, command = std::move(command), result]() {
+            *result = command(*device);
+        },
+        [this, description, result, fields = fieldsForParameter(parameter),
+         onSuccess = std::move(onSuccess), onFailure = std::move(onFailure)]() {
+            if (*result != 0) {
+                m_failedFields |= fields;
+                emit commandFailed(description, *result);
+                if (onFailure) onFailure();
+                return;
+            }
+            m_failedFields &= ~fields;
+            if (onSuccess) onSuccess();
+        });
 }
 
 void CameraController::updateState()
@@ -460,8 +705,86 @@ void CameraController::updateState()
         return;
     }
 
-    auto status = m_device->cameraStatus();
+    // CameraStatus arrives by push afterwards; the image controls are not
+    // part of it on the Tiny and Meet models, so read them here
+    auto snapshot = std::make_shared<StatusSnapshot>();
+    m_stateReadPending = true;
+    m_commands->post(QStringLiteral("Read camera status"),
+        [device = m_device, snapshot]() {
+            snapshot->status = device->cameraStatus();
+            snapshot->brightnessValid = device->cameraGetImageBrightnessR(snapshot->brightness) == 0;
+            snapshot->contrastValid = device->cameraGetImageContrastR(snapshot->contrast) == 0;
+            snapshot->saturationValid = device->cameraGetImageSaturationR(snapshot->saturation) == 0;
+            snapshot->whiteBalanceValid = device->cameraGetWhiteBalanceR(
+                snapshot->whiteBalanceType, snapshot->whiteBalanceParam) == 0;
+        },
+        [this, snapshot]() {
+            m_stateReadPending = false;
+
+            // Settings applied while the read was queued win over what it saw
+            if (!m_connected || isSettling()) {
+                return;
+            }
+
+            applyCameraStatus(snapshot->status);
+            m_deviceStateKnown = true;
+
+            // Image controls - read current values from camera
+            // Note: auto mode flags are left alone - camera doesn't have concept of "auto" for these
+            if (snapshot->brightnessValid) {
+                m_currentState.brightness = clampToRange(snapshot->brightness, m_brightnessRange, 0, 255);
+            }
+            if (snapshot->contrastValid) {
+                m_currentState.contrast = clampToRange(snapshot->contrast, m_contrastRange, 0, 255);
+            }
+            if (snapshot->saturationValid) {
+                m_currentState.saturation = clampToRange(snapshot->saturation, m_saturationRange, 0, 255);
+            }
+            if (snapshot->whiteBalanceValid) {
+                const auto wbType = snapshot->whiteBalanceType;
+                m_currentState.whiteBalance = static_cast<int>(wbType);
+                if (wbType == Device::DevWhiteBalanceManual) {
+                    m_currentState.whiteBalanceKelvin = clampToRange(snapshot->whiteBalanceParam, m_whiteBalanceKelvinRange, 2000, 10000);
+                } else if (m_whiteBalanceKelvinRange.valid) {
+                    m_currentState.whiteBalanceKelvin = clampToRange(m_whiteBalanceKelvinRange.defaultValue, m_whiteBalanceKelvinRange, 2000, 10000);
+                }
+            }
+
+            if (m_whiteBalanceFallbackActive) {
+                m_currentState.whiteBalance = m_fallbackWhiteBalanceMode;
+            } else {
+                m_lastRequestedWhiteBalance = m_currentState.whiteBalance;
+            }
+
+            publishState();
+
+            // A batch held back for this read can now be diffed against it
+            if (m_hasDeferredState) {
+                m_hasDeferredState = false;
+                applyState(m_deferredState);
+            }
+        });
+}
+
+void CameraController::publishState(StateFields force)
+{
+    StateFields changed = force;
+    if (!m_statePublished) {
+        changed = AllStateFields;
+    } else {
+        changed |= changedFields(m_publishedState, m_currentState);
+    }
+    if (!changed) {
+        return;
+    }
+
+    m_publishedState = m_currentState;
+    m_statePublished = true;
+    emit stateChanged(m_currentState, changed);
+}
 
+void CameraController::applyCameraStatus(const Device::CameraStatus &status)
+{
     m_currentState.aiMode = status.tiny.ai_mode;
     m_currentState.aiSubMode = status.tiny.ai_sub_mode;
     m_currentState.zoomRatio = status.tiny.zoom_ratio;
@@ -474,54 +797,115 @@ void CameraController::updateState()
     m_currentState.autoFramingEnabled = (m_currentState.aiMode != Device::AiWorkModeNone);
     m_currentState.trackSpeedMode = status.tiny.ai_tracker_speed;
     m_currentState.audioAutoGainEnabled = status.tiny.audio_auto_gain;
+}
 
-    // Image controls - read current values from camera
-    // Note: Preserve auto mode flags - camera doesn't have concept of "auto" for these
-    bool preservedBrightnessAuto = m_currentState.brightnessAuto;
-    bool preservedContrastAuto = m_currentState.contrastAuto;
-    bool preservedSaturationAuto = m_currentState.saturationAuto;
+void CameraController::applyState(const CameraState &target)
+{
+    if (!m_connected) return;
 
-    int32_t brightness, contrast, saturation;
-    Device::DevWhiteBalanceType wbType;
-    int32_t wbParam;
+    // Before the first read is back, this would resend every field and the
+    // read would then be dropped for settling; the read applies it instead
+    if (m_stateReadPending) {
+        m_deferredState = target;
+        m_hasDeferredState = true;
+        return;
+    }
 
-    if (m_device->cameraGetImageBrightnessR(brightness) == 0) {
-        m_currentState.brightness = clampToRange(brightness, m_brightnessRange, 0, 255);
+    // The auto flags only live here; the camera has no notion of them
+    m_currentState.brightnessAuto = target.brightnessAuto;
+    m_currentState.contrastAuto = target.contrastAuto;
+    m_currentState.saturationAuto = target.saturationAuto;
+
+    // Send only what differs from the device, or everything before its
+    // state has been read
+    const bool sendsAll = !m_deviceStateKnown;
+    StateFields changed = sendsAll ? StateFields(AllStateFields)
+                                   : changedFields(m_currentState, target);
+    changed &= PersistedStateFields;
+
+    // Block status updates and report the intended state until the device
+    // has acknowledged every command of this batch
+    const quint64 batch = ++m_batchSerial;
+    m_cachedState = target;
+    m_settling = true;
+
+    // Dependency order: the media mode decides whether AI modes apply at
+    // all, and framing settles before PTZ and image controls
+    if (changed & AutoFramingField) {
+        enableAutoFraming(target.autoFramingEnabled);
     }
-    if (m_device->cameraGetImageContrastR(contrast) == 0) {
-        m_currentState.contrast = clampToRange(contrast, m_contrastRange, 0, 255);
+    if (isTiny2Family()) {
+        if (changed & (AiModeField | AiSubModeField)) {
+            setAiMode(target.aiMode, target.aiSubMode);
+        }
+        if (changed & AutoZoomField) {
+            setAutoZoom(target.autoZoomEnabled);
+        }
+        if (changed & TrackSpeedField) {
+            setTrackSpeed(target.trackSpeedMode);
+        }
+        if (changed & AudioAutoGainField) {
+            setAudioAutoGain(target.audioAutoGainEnabled);
+        }
     }
-    if (m_device->cameraGetImageSaturationR(saturation) == 0) {
-        m_currentState.saturation = clampToRange(saturation, m_saturationRange, 0, 255);
+    if (changed & FovField) {
+        setFOV(target.fovMode);
     }
-    if (m_device->cameraGetWhiteBalanceR(wbType, wbParam) == 0) {
-        m_currentState.whiteBalance = static_cast<int>(wbType);
-        if (wbType == Device::DevWhiteBalanceManual) {
-            m_currentState.whiteBalanceKelvin = clampToRange(wbParam, m_whiteBalanceKelvinRange, 2000, 10000);
-        } else if (m_whiteBalanceKelvinRange.valid) {
-            m_currentState.whiteBalanceKelvin = clampToRange(m_whiteBalanceKelvinRange.defaultValue, m_whiteBalanceKelvinRange, 2000, 10000);
-        }
+    if (changed & HdrField) {
+        setHDR(target.hdrEnabled);
     }
-
-    // Restore auto mode flags (not stored in camera)
-    m_currentState.brightnessAuto = preservedBrightnessAuto;
-    m_currentState.contrastAuto = preservedContrastAuto;
-    m_currentState.saturationAuto = preservedSaturationAuto;
-
-    if (m_whiteBalanceFallbackActive) {
-        m_currentState.whiteBalance = m_fallbackWhiteBalanceMode;
-    } else {
-        m_lastRequestedWhiteBalance = m_currentState.whiteBalance;
+    if (changed & FaceAEField) {
+        setFaceAE(target.faceAEEnabled);
+    }
+    if (changed & FaceFocusField) {
+        setFaceFocus(target.faceFocusEnabled);
+    }
+    if (changed & ZoomField) {
+        setZoom(target.zoom);
+    }
+    if (changed & (PanField | TiltField)) {
+        setPanTilt(target.pan, target.tilt);
     }
 
-    emit stateChanged(m_currentState);
-}
+    // Image controls
+    if (changed & (BrightnessField | BrightnessAutoField)) {
+        setBrightness(target.brightness);
+    }
+    if (changed & (ContrastField | ContrastAutoField)) {
+        setContrast(target.contrast);
+    }
+    if (changed & (SaturationField | SaturationAutoField)) {
+        setSaturation(target.saturation);
+    }
+    if (target.whiteBalance == static_cast<int>(Device::DevWhiteBalanceManual)) {
+        if (changed & (WhiteBalanceField | WhiteBalanceKelvinField)) {
+            setWhiteBalanceManual(target.whiteBalanceKelvin);
+        }
+    } else if (changed & WhiteBalanceField) {
+        setWhiteBalance(target.whiteBalance);
+    }
 
-void CameraController::beginSettling(int durationMs)
-{
-    // Cache the current intended state
-    m_cachedState = m_currentState;
-    m_settlingTimer->start(durationMs);
+    // Commands run in order, so this completes once the device has answered
+    // all of the above. Ask for a fresh status fetch on the way, so the next
+    // push shows the new settings rather than ones read before the batch.
+    m_commands->post(QStringLiteral("Confirm settings"),
+        [device = m_device]() {
+            device->nextRefreshDevStatus();
+            device->fastNextRefreshDevStatus();
+        },
+        [this, batch, sendsAll]() {
+            if (batch != m_batchSerial) {
+                return;
+            }
+            // Every field has been set, and those that took are recorded;
+            // failed ones still differ from the next target and get resent
+            if (sendsAll) {
+                m_deviceStateKnown = true;
+            }
+            // Widgets ignore updates while settling, so give them everything
+            m_settling = false;
+            publishState(AllStateFields);
+        });
 }
 
 bool CameraController::loadConfig(std::vector<Config::ValidationError> &errors)
@@ -542,79 +926,40 @@ void CameraController::applyConfigToCamera()
 
     auto settings = m_config.getSettings();
 
-    // Initialize auto mode flags from config
-    m_currentState.brightnessAuto = settings.brightnessAuto;
-    m_currentState.contrastAuto = settings.contrastAuto;
-    m_currentState.saturationAuto = settings.saturationAuto;
-
-    // Apply all settings to the camera
-    enableAutoFraming(settings.faceTracking);
-    setHDR(settings.hdr);
-    setFOV(settings.fov);
-    setFaceAE(settings.faceAE);
-    setFaceFocus(settings.faceFocus);
-    setZoom(settings.zoom);
-    setPanTilt(settings.pan, settings.tilt);
-
-    if (isTiny2Family()) {
-        setAiMode(settings.aiMode, settings.aiSubMode);
-        setAutoZoom(settings.autoZoom);
-        setTrackSpeed(settings.trackSpeed);
-        setAudioAutoGain(settings.audioAutoGain);
-    }
+    CameraState target = m_currentState;
+    target.autoFramingEnabled = settings.faceTracking;
+    target.hdrEnabled = settings.hdr;
+    target.fovMode = settings.fov;
+    target.faceAEEnabled = settings.faceAE;
+    target.faceFocusEnabled = settings.faceFocus;
+    target.zoom = settings.zoom;
+    target.pan = settings.pan;
+    target.tilt = settings.tilt;
+    target.aiMode = settings.aiMode;
+    target.aiSubMode = settings.aiSubMode;
+    target.autoZoomEnabled = settings.autoZoom;
+    target.trackSpeedMode = settings.trackSpeed;
+    target.audioAutoGainEnabled = settings.audioAutoGain;
 
     // Image controls
-    setBrightness(settings.brightness);
-    setContrast(settings.contrast);
-    setSaturation(settings.saturation);
-    if (settings.whiteBalance == static_cast<int>(Device::DevWhiteBalanceManual)) {
-        setWhiteBalanceManual(settings.whiteBalanceKelvin);
-    } else {
-        setWhiteBalance(settings.whiteBalance);
-    }
+    target.brightnessAuto = settings.brightnessAuto;
+    target.brightness = settings.brightness;
+    target.contrastAuto = settings.contrastAuto;
+    target.contrast = settings.contrast;
+    target.saturationAuto = settings.saturationAuto;
+    target.saturation = settings.saturation;
+    target.whiteBalance = settings.whiteBalance;
+    target.whiteBalanceKelvin = settings.whiteBalanceKelvin;
+
+    applyState(target);
 
     emit configLoaded();
 }
 
 void CameraController::applyCurrentStateToCamera(const CameraState &uiState)
 {
-    if (!m_connected) return;
-
-    // Update current state with UI state (including auto mode flags)
-    m_currentState.brightnessAuto = uiState.brightnessAuto;
-    m_currentState.contrastAuto = uiState.contrastAuto;
-    m_currentState.saturationAuto = uiState.saturationAuto;
-
-    // Cache the intended state
-    m_cachedState = uiState;
-
-    // Begin settling period - block status updates for 2 seconds
-    beginSettling(2000);
-
     // Apply the current UI state to camera (respects user changes)
-    enableAutoFraming(uiState.autoFramingEnabled);
-    if (isTiny2Family()) {
-        setAiMode(uiState.aiMode, uiState.aiSubMode);
-        setAutoZoom(uiState.autoZoomEnabled);
-        setTrackSpeed(uiState.trackSpeedMode);
-        setAudioAutoGain(uiState.audioAutoGainEnabled);
-    }
-    setHDR(uiState.hdrEnabled);
-    setFOV(uiState.fovMode);
-    setFaceAE(uiState.faceAEEnabled);
-    setFaceFocus(uiState.faceFocusEnabled);
-    setZoom(uiState.zoom);
-    setPanTilt(uiState.pan, uiState.tilt);
-
-    // Image controls
-    setBrightness(uiState.brightness);
-    setContrast(uiState.contrast);
-    setSaturation(uiState.saturation);
-    if (uiState.whiteBalance == static_cast<int>(Device::DevWhiteBalanceManual)) {
-        setWhiteBalanceManual(uiState.whiteBalanceKelvin);
-    } else {
-        setWhiteBalance(uiState.whiteBalance);
-    }
+    applyState(uiState);
 }
 
 void CameraController::saveCurrentStateToConfig()
@@ -622,30 +967,43 @@ void CameraController::saveCurrentStateToConfig()
     // Get current settings to preserve app settings (like startMinimized)
     Config::CameraSettings settings = m_config.getSettings();
 
+    // Keep the saved value of anything this camera did not take: settings it
+    // is never sent, and ones whose last command failed. The device reports
+    // its own value for those, which is not what the user asked for.
+    StateFields kept = m_failedFields;
+    if (!isTiny2Family()) {
+        kept |= Tiny2OnlyStateFields;
+    }
+    auto update = [kept](auto &setting, const auto &value, StateFields fields) {
+        if (!(kept & fields)) {
+            setting = value;
+        }
+    };
+
     // Update only camera-related settings from current state
-    settings.faceTracking = m_currentState.autoFramingEnabled;
-    settings.hdr = m_currentState.hdrEnabled;
-    settings.fov = m_currentState.fovMode;
-    settings.faceAE = m_currentState.faceAEEnabled;
-    settings.faceFocus = m_currentState.faceFocusEnabled;
-    settings.zoom = m_currentState.zoom;
-    settings.pan = m_currentState.pan;
-    settings.tilt = m_currentState.tilt;
-    settings.aiMode = m_currentState.aiMode;
-    settings.aiSubMode = m_currentState.aiSubMode;
-    settings.autoZoom = m_currentState.autoZoomEnabled;
-    settings.trackSpeed = m_currentState.trackSpeedMode;
-    settings.audioAutoGain = m_currentState.audioAutoGainEnabled;
+    update(settings.faceTracking, m_currentState.autoFramingEnabled, AutoFramingField);
+    update(settings.hdr, m_currentState.hdrEnabled, HdrField);
+    update(settings.fov, m_currentState.fovMode, FovField);
+    update(settings.faceAE, m_currentState.faceAEEnabled, FaceAEField);
+    update(settings.faceFocus, m_currentState.faceFocusEnabled, FaceFocusField);
+    update(settings.zoom, m_currentState.zoom, ZoomField);
+    update(settings.pan, m_currentState.pan, PanField);
+    update(settings.tilt, m_currentState.tilt, TiltField);
+    update(settings.aiMode, m_currentState.aiMode, AiModeField);
+    update(settings.aiSubMode, m_currentState.aiSubMode, AiSubModeField);
+    update(settings.autoZoom, m_currentState.autoZoomEnabled, AutoZoomField);
+    update(settings.trackSpeed, m_currentState.trackSpeedMode, TrackSpeedField);
+    update(settings.audioAutoGain, m_currentState.audioAutoGainEnabled, AudioAutoGainField);
 
     // Image controls
-    settings.brightnessAuto = m_currentState.brightnessAuto;
-    settings.brightness = m_currentState.brightness;
-    settings.contrastAuto = m_currentState.contrastAuto;
-    settings.contrast = m_currentState.contrast;
-    settings.saturationAuto = m_currentState.saturationAuto;
-    settings.saturation = m_currentState.saturation;
-    settings.whiteBalance = m_currentState.whiteBalance;
-    settings.whiteBalanceKelvin = m_currentState.whiteBalanceKelvin;
+    update(settings.brightnessAuto, m_currentState.brightnessAuto, BrightnessAutoField);
+    update(settings.brightness, m_currentState.brightness, BrightnessField);
+    update(settings.contrastAuto, m_currentState.contrastAuto, ContrastAutoField);
+    update(settings.contrast, m_currentState.contrast, ContrastField);
+    update(settings.saturationAuto, m_currentState.saturationAuto, SaturationAutoField);
+    update(settings.saturation, m_currentState.saturation, SaturationField);
+    update(settings.whiteBalance, m_currentState.whiteBalance, WhiteBalanceField);
+    update(settings.whiteBalanceKelvin, m_currentState.whiteBalanceKelvin, WhiteBalanceKelvinField);
 
     m_config.setSettings(settings);
 }
@@ -657,48 +1015,61 @@ bool CameraController::isTiny2Family() const
            m_cameraInfo.productType == ObsbotProdTinySE;
 }
 
-void CameraController::refreshControlRanges()
+void CameraController::refreshControlRanges(std::function<void()> onReady)
 {
     if (!m_device) {
         resetControlRanges();
+        if (onReady) onReady();
         return;
     }
 
-    auto fetchRange = [this](int32_t (Device::*getter)(Device::UvcParamRange &), ParamRange &target) {
-        Device::UvcParamRange sdkRange{};
-        if ((m_device.get()->*getter)(sdkRange) == 0) {
-            target.min = sdkRange.min_;
-            target.max = sdkRange.max_;
-            target.step = sdkRange.step_ == 0 ? 1 : sdkRange.step_;
-            target.defaultValue = sdkRange.default_;
-            target.valid = true;
-        } else {
-            target = {};
-        }
-    };
-
-    fetchRange(&Device::cameraGetRangeImageBrightnessR, m_brightnessRange);
-    fetchRange(&Device::cameraGetRangeImageContrastR, m_contrastRange);
-    fetchRange(&Device::cameraGetRangeImageSaturationR, m_saturationRange);
-    fetchRange(&Device::cameraGetRangeWhiteBalanceR, m_whiteBalanceKelvinRange);
+    auto ranges = std::make_shared<ControlRanges>();
+    m_commands->post(QStringLiteral("Read control ranges"),
+        [device = m_device, ranges]() {
+            auto fetchRange = [&device](int32_t (Device::*getter)(Device::UvcParamRange &), ParamRange &target) {
+                Device::UvcParamRange sdkRange{};
+                if ((device.get()->*getter)(sdkRange) == 0) {
+                    target.min = sdkRange.min_;
+                    target.max = sdkRange.max_;
+                    target.step = sdkRange.step_ == 0 ? 1 : sdkRange.step_;
+                    target.defaultValue = sdkRange.default_;
+                    target.valid = true;
+                } else {
+                    target = {};
+                }
+            };
+
+            fetchRange(&Device::cameraGetRangeImageBrightnessR, ranges->brightness);
+            fetchRange(&Device::cameraGetRangeImageContrastR, ranges->contrast);
+            fetchRange(&Device::cameraGetRangeImageSaturationR, ranges->saturation);
+            fetchRange(&Device::cameraGetRangeWhiteBalanceR, ranges->whiteBalanceKelvin);
+
+            std::vector<int32_t> wbList;
+            int32_t wbMin = 0;
+            int32_t wbMax = 0;
+            if (device->cameraGetWhiteBalanceListR(wbList, wbMin, wbMax) == 0) {
+                ranges->whiteBalanceTypes.assign(wbList.begin(), wbList.end());
+            }
+        },
+        [this, ranges, onReady = std::move(onReady)]() {
+            m_brightnessRange = ranges->brightness;
+            m_contrastRange = ranges->contrast;
+            m_saturationRange = ranges->saturation;
+            m_whiteBalanceKelvinRange = ranges->whiteBalanceKelvin;
+            m_supportedWhiteBalanceTypes = ranges->whiteBalanceTypes;
 
-    m_supportedWhiteBalanceTypes.clear();
-    std::vector<int32_t> wbList;
-    int32_t wbMin = 0;
-    int32_t wbMax = 0;
-    if (m_device->cameraGetWhiteBalanceListR(wbList, wbMin, wbMax) == 0) {
-        m_supportedWhiteBalanceTypes.assign(wbList.begin(), wbList.end());
-    }
+            if (m_whiteBalanceKelvinRange.valid) {
+                int clampedCurrent = clampToRange(
+                    m_currentState.whiteBalanceKelvin == 0 ? m_whiteBalanceKelvinRange.defaultValue : m_currentState.whiteBalanceKelvin,
+                    m_whiteBalanceKelvinRange, 2000, 10000);
+                m_currentState.whiteBalanceKelvin = clampedCurrent;
+                m_cachedState.whiteBalanceKelvin = clampToRange(
+                    m_cachedState.whiteBalanceKelvin == 0 ? m_whiteBalanceKelvinRange.defaultValue : m_cachedState.whiteBalanceKelvin,
+                    m_whiteBalanceKelvinRange, 2000, 10000);
+            }
 
-    if (m_whiteBalanceKelvinRange.valid) {
-        int clampedCurrent = clampToRange(
-            m_currentState.whiteBalanceKelvin == 0 ? m_whiteBalanceKelvinRange.defaultValue : m_currentState.whiteBalanceKelvin,
-            m_whiteBalanceKelvinRange, 2000, 10000);
-        m_currentState.whiteBalanceKelvin = clampedCurrent;
-        m_cachedState.whiteBalanceKelvin = clampToRange(
-            m_cachedState.whiteBalanceKelvin == 0 ? m_whiteBalanceKelvinRange.defaultValue : m_cachedState.whiteBalanceKelvin,
-            m_whiteBalanceKelvinRange, 2000, 10000);
-    }
+            if (onReady) onReady();
+        });
 }
 
 void CameraController::resetControlRanges()
@@ -771,18 +1142,28 @@ int CameraController::whiteBalancePresetToKelvin(int mode) const
 bool CameraController::applyManualWhiteBalance(int kelvin, int displayMode)
 {
     int clamped = clampToRange(kelvin, m_whiteBalanceKelvinRange, 2000, 10000);
-    bool success = executeCommand("Set White Balance (Manual)", [this, clamped]() {
-        return m_device->cameraSetWhiteBalanceR(Device::DevWhiteBalanceManual, clamped);
-    });
-
-    if (success) {
+    executeCommand(QStringLiteral("whiteBalance"), "Set White Balance (Manual)", [clamped](Device &device) {
+        return device.cameraSetWhiteBalanceR(Device::DevWhiteBalanceManual, clamped);
+    }, [this, clamped, displayMode]() {
         m_lastRequestedWhiteBalance = displayMode;
         m_currentState.whiteBalance = displayMode;
         m_currentState.whiteBalanceKelvin = clamped;
-        emit stateChanged(m_currentState);
+        publishState();
+    });
+    return true;
+}
+
+bool CameraController::applyWhiteBalanceFallback(int mode)
+{
+    // Emulate a preset the camera lacks with its colour temperature
+    int kelvin = whiteBalancePresetToKelvin(mode);
+    if (kelvin <= 0 || !m_whiteBalanceKelvinRange.valid) {
+        return false;
     }
 
-    return success;
+    m_whiteBalanceFallbackActive = true;
+    m_fallbackWhiteBalanceMode = mode;
+    return applyManualWhiteBalance(kelvin, mode);
 }
 
 bool CameraController::isWhiteBalanceTypeSupported(int mode) const
@@ -2,11 +2,12 @@
 #define CAMERACONTROLLER_H
 
 #include <QObject>
-#include <QTimer>
+#include <atomic>
 #include <memory>
 #include <functional>
 #include <vector>
 #include <dev/devs.hpp>
+#include "CameraCommandExecutor.h"
 #include "Config.h"
 
 /**
@@ -14,6 +15,11 @@
  *
  * This class encapsulates the OBSBOT SDK and provides a clean Qt-friendly
  * interface for controlling the camera.
+ *
+ * SDK calls never run on the GUI thread: setters and state refreshes are
+ * queued on a CameraCommandExecutor and complete asynchronously. A setter
+ * returns false only when the command cannot be sent; its outcome arrives
+ * later as stateChanged or commandFailed, both emitted on the GUI thread.
  */
 class CameraController : public QObject
 {
@@ -64,6 +70,41 @@ public:
         int devStatus;
     };
 
+    // One bit per CameraState field, reported with stateChanged
+    enum StateField : quint32 {
+        AutoFramingField        = 1u << 0,
+        AiModeField             = 1u << 1,
+        AiSubModeField          = 1u << 2,
+        AutoZoomField           = 1u << 3,
+        TrackSpeedField         = 1u << 4,
+        AudioAutoGainField      = 1u << 5,
+        PanField                = 1u << 6,
+        TiltField               = 1u << 7,
+        ZoomField               = 1u << 8,
+        HdrField                = 1u << 9,
+        FovField                = 1u << 10,
+        FaceAEField             = 1u << 11,
+        FaceFocusField          = 1u << 12,
+        AutoFocusField          = 1u << 13,
+        BrightnessAutoField     = 1u << 14,
+        BrightnessField         = 1u << 15,
+        ContrastAutoField       = 1u << 16,
+        ContrastField           = 1u << 17,
+        SaturationAutoField     = 1u << 18,
+        SaturationField         = 1u << 19,
+        WhiteBalanceField       = 1u << 20,
+        WhiteBalanceKelvinField = 1u << 21,
+        ZoomRatioField          = 1u << 22,
+        DevStatusField          = 1u << 23,
+        AllStateFields          = (1u << 24) - 1,
+        // Fields saveConfig() writes; the rest are read-only status
+        PersistedStateFields    = AllStateFields & ~(AutoFocusField | ZoomRatioField | DevStatusField),
+        // Only sent to the Tiny 2 family; other models report defaults
+        Tiny2OnlyStateFields    = AiModeField | AiSubModeField | AutoZoomField |
+                                  TrackSpeedField | AudioAutoGainField
+    };
+    Q_DECLARE_FLAGS(StateFields, StateField)
+
     struct ParamRange {
         int min = 0;
         int max = 0;
@@ -81,9 +122,11 @@ public:
     void connectToCamera();
     void disconnectFromCamera();
 
-    // State
-    CameraState getCurrentState();
+    // State; the last known state, kept current by the SDK's status push
+    CameraState getCurrentState() const;
     bool hasTiny2Capabilities() const;
+    // Commands sent to the camera versus replaced by a newer set while queued
+    CameraCommandExecutor::Statistics commandStatistics() const;
 
     // Tracking controls
     bool enableAutoFraming(bool enabled);
@@ -120,11 +163,14 @@ public:
     bool saveConfig();
     void applyConfigToCamera();  // Apply loaded config settings to camera
     void applyCurrentStateToCamera(const CameraState &uiState);  // Apply UI state to camera
+    // Sends the fields that differ from the device, in dependency order,
+    // and settles until the device has acknowledged all of them. Right
+    // after connecting, it waits for the first read of the device.
+    void applyState(const CameraState &target);
     Config& getConfig() { return m_config; }
 
-    // Settling state
-    bool isSettling() const { return m_settlingTimer && m_settlingTimer->isActive(); }
-    void beginSettling(int durationMs = 2000);  // Start settling period
+    // Settling state: a batch from applyState() is still being applied
+    bool isSettling() const { return m_settling; }
 
     // Ranges
     ParamRange getBrightnessRange() const { return m_brightnessRange; }
@@ -136,7 +182,8 @@ public:
 signals:
     void cameraConnected(const CameraInfo &info);
     void cameraDisconnected();
-    void stateChanged(const CameraState &state);
+    // Emitted only when something changed; changed names the fields that did
+    void stateChanged(const CameraState &state, CameraController::StateFields changed);
     void commandFailed(const QString &description, int errorCode);
     void configLoaded();  // Emitted after config is successfully loaded
 
@@ -144,10 +191,24 @@ private:
     std::shared_ptr<Device> m_device;
     bool m_connected;
     CameraInfo m_cameraInfo;
+    CameraCommandExecutor *m_commands;
+    // Checked before SDK callbacks reach this object: m_alive until it is
+    // destroyed, m_pushToken until the device it was enabled for is detached
+    std::shared_ptr<std::atomic<bool>> m_alive;
+    std::shared_ptr<std::atomic<bool>> m_pushToken;
+    bool m_devChangedRegistered;
     CameraState m_currentState;
+    CameraState m_publishedState;  // As last sent with stateChanged
+    bool m_statePublished;
     CameraState m_cachedState;  // Cache intended state during settling
     Config m_config;
-    QTimer *m_settlingTimer;  // Timer for settling period after config apply
+    bool m_deviceStateKnown;  // m_currentState has been read from this device
+    bool m_stateReadPending;  // updateState()'s read has not completed yet
+    bool m_hasDeferredState;  // applyState() is waiting for that read
+    CameraState m_deferredState;
+    StateFields m_failedFields;  // Last command for these failed; saveConfig() keeps their old value
+    bool m_settling;
+    quint64 m_batchSerial;    // Identifies the latest applyState() batch
     ParamRange m_brightnessRange;
     ParamRange m_contrastRange;
     ParamRange m_saturationRange;
@@ -156,18 +217,33 @@ private:
     int m_lastRequestedWhiteBalance;
     bool m_whiteBalanceFallbackActive;
     int m_fallbackWhiteBalanceMode;
+    double m_targetPan;   // Last requested position, so repeated adjusts add up
+    double m_targetTilt;  // before the device confirms
     bool isTiny2Family() const;
 
     // Helper
-    bool executeCommand(const QString &description, std::function<int32_t()> command);
-    void updateState();
+    void attachDevice(const std::shared_ptr<Device> &device);
+    void detachDevice();  // Stops the status push and releases the device
+    void handleDeviceChanged(bool connected);
+    void enableStatusPush();
+    void handleStatusPush(const Device::CameraStatus &status);
+    // Sets of the same parameter (a key such as "zoom") are coalesced
+    void executeCommand(const QString &parameter, const QString &description,
+                        std::function<int32_t(Device &)> command,
+                        std::function<void()> onSuccess = {}, std::function<void()> onFailure = {});
+    void publishState(StateFields force = {});
+    void updateState();  // Full read, including fields the status push lacks
+    void applyCameraStatus(const Device::CameraStatus &status);
     void saveCurrentStateToConfig();  // Update config with current camera state
-    void refreshControlRanges();
+    void refreshControlRanges(std::function<void()> onReady = {});
     void resetControlRanges();
     int clampToRange(int value, const ParamRange &range, int fallbackMin, int fallbackMax) const;
     int whiteBalancePresetToKelvin(int mode) const;
     bool applyManualWhiteBalance(int kelvin, int displayMode);
+    bool applyWhiteBalanceFallback(int mode);
     bool isWhiteBalanceTypeSupported(int mode) const;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(CameraController::StateFields)
+
 #endif // CAMERACONTROLLER_H
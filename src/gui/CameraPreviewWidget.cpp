@@ -1,7 +1,9 @@
 #include "CameraPreviewWidget.h"
 
 #include "FilterPreviewWidget.h"
-#include "VirtualCameraStreamer.h"
+#include "OffscreenEffectsEngine.h"
+#include "V4l2CaptureSource.h"
+#include "VirtualCameraOutputs.h"
 
 #include <QCamera>
 #include <QCameraDevice>
@@ -64,12 +66,17 @@ CameraPreviewWidget::CameraPreviewWidget(QWidget *parent)
     , m_camera(nullptr)
     , m_captureSession(nullptr)
     , m_videoSink(nullptr)
+    , m_directCapture(nullptr)
     , m_filterPreviewWidget(nullptr)
     , m_formatCombo(nullptr)
     , m_statusLabel(nullptr)
     , m_controlRow(nullptr)
-    , m_virtualCameraStreamer(nullptr)
+    , m_virtualCameraOutputs(nullptr)
+    , m_effectsPipeline(nullptr)
     , m_selectedFormatId(QStringLiteral("auto"))
+    , m_captureBackend(CaptureBackend::QtMultimedia)
+    , m_captureBufferCount(4)
+    , m_previewQuality(PreviewQuality::Display)
     , m_previewEnabled(false)
     , m_isApplyingFormat(false)
 {
@@ -114,12 +121,25 @@ void CameraPreviewWidget::setupUI()
     m_filterPreviewWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     layout->addWidget(m_filterPreviewWidget, 1);
 
-    connect(m_filterPreviewWidget, &FilterPreviewWidget::processedFrameReady,
-            this, [this](const QImage &image) {
-                if (m_virtualCameraStreamer) {
-                    m_virtualCameraStreamer->onProcessedFrameReady(image);
+    // Effects run on their own thread at the pipeline's pace: the virtual
+    // camera keeps its frame rate while the preview is hidden or the window
+    // is in the tray, and the preview only samples the latest result
+    m_effectsPipeline = new OffscreenEffectsEngine(this);
+    m_filterPreviewWidget->setDisplaySource(m_effectsPipeline);
+    connect(m_effectsPipeline, &OffscreenEffectsEngine::processedFrameReady,
+            this, [this](const QImage &image, qint64 captureTimeUs) {
+                if (m_virtualCameraOutputs) {
+                    m_virtualCameraOutputs->onProcessedFrameReady(image, captureTimeUs);
                 }
             });
+    connect(m_effectsPipeline, &OffscreenEffectsEngine::packedFrameReady,
+            this, [this](const PackedFrame &frame) {
+                if (m_virtualCameraOutputs) {
+                    m_virtualCameraOutputs->onPackedFrameReady(frame);
+                }
+            });
+    connect(m_effectsPipeline, &OffscreenEffectsEngine::errorOccurred,
+            this, &CameraPreviewWidget::updateStatus);
 }
 
 bool CameraPreviewWidget::isPreviewEnabled() const
@@ -179,13 +199,64 @@ void CameraPreviewWidget::setControlsVisible(bool visible)
     }
 }
 
-void CameraPreviewWidget::setVirtualCameraStreamer(VirtualCameraStreamer *streamer)
+void CameraPreviewWidget::setCaptureBackend(CaptureBackend backend, const QString &devicePath,
+                                            int bufferCount)
+{
+    const QString path = devicePath.trimmed();
+    if (backend == m_captureBackend && path == m_captureDevicePath &&
+        bufferCount == m_captureBufferCount) {
+        return;
+    }
+
+    m_captureBackend = backend;
+    m_captureDevicePath = path;
+    m_captureBufferCount = bufferCount;
+
+    if (m_previewEnabled) {
+        stopPreview();
+        startPreview();
+    }
+}
+
+void CameraPreviewWidget::setPreviewQuality(PreviewQuality quality)
+{
+    m_previewQuality = quality;
+    if (m_filterPreviewWidget) {
+        m_filterPreviewWidget->setDisplaySizedRendering(quality == PreviewQuality::Display);
+    }
+}
+
+void CameraPreviewWidget::setVirtualCameraOutputs(VirtualCameraOutputs *outputs)
+{
+    if (m_virtualCameraOutputs == outputs) {
+        return;
+    }
+
+    m_virtualCameraOutputs = outputs;
+}
+
+void CameraPreviewWidget::setVirtualCameraGpuPacking(bool enabled, const QSize &targetSize)
 {
-    if (m_virtualCameraStreamer == streamer) {
+    if (!m_effectsPipeline) {
         return;
     }
+    m_effectsPipeline->setGpuPacking(enabled, targetSize);
+}
 
-    m_virtualCameraStreamer = streamer;
+void CameraPreviewWidget::setVirtualCameraReadbackLatency(int frames)
+{
+    if (!m_effectsPipeline) {
+        return;
+    }
+    m_effectsPipeline->setReadbackLatency(frames);
+}
+
+void CameraPreviewWidget::setVirtualCameraFrameRate(int fps)
+{
+    if (!m_effectsPipeline) {
+        return;
+    }
+    m_effectsPipeline->setTargetFrameRate(fps);
 }
 
 void CameraPreviewWidget::setVideoEffects(const FilterPreviewWidget::VideoEffectsSettings &settings)
@@ -194,6 +265,9 @@ void CameraPreviewWidget::setVideoEffects(const FilterPreviewWidget::VideoEffect
         return;
     }
     m_filterPreviewWidget->setVideoEffects(settings);
+    if (m_effectsPipeline) {
+        m_effectsPipeline->setVideoEffects(settings);
+    }
 }
 
 FilterPreviewWidget::VideoEffectsSettings CameraPreviewWidget::videoEffects() const
@@ -212,6 +286,14 @@ void CameraPreviewWidget::startPreview()
 
     stopPreview();
 
+    if (m_captureBackend == CaptureBackend::V4l2) {
+        if (startDirectCapture()) {
+            m_previewEnabled = true;
+            emit previewStateChanged(true);
+        }
+        return;
+    }
+
     if (!initializeCamera()) {
         return;
     }
@@ -234,6 +316,10 @@ void CameraPreviewWidget::startPreview()
 
 void CameraPreviewWidget::stopPreview()
 {
+    if (m_directCapture) {
+        m_directCapture->stop();
+    }
+
     if (m_videoSink) {
         disconnect(m_videoSink, nullptr, this, nullptr);
         delete m_videoSink;
@@ -295,13 +381,110 @@ bool CameraPreviewWidget::initializeCamera()
     return true;
 }
 
+bool CameraPreviewWidget::startDirectCapture()
+{
+    // Formats are still listed through QtMultimedia, which does not open
+    // the device; only the capture itself bypasses it
+    const QCameraDevice device = resolveCameraDevice();
+    if (!device.isNull()) {
+        refreshFormatOptions(device);
+    }
+
+    QString devicePath = m_captureDevicePath;
+    if (devicePath.isEmpty()) {
+        devicePath = m_requestedDeviceId.startsWith(QStringLiteral("/dev/"))
+            ? m_requestedDeviceId
+            : QString::fromUtf8(device.id());
+    }
+    if (!devicePath.startsWith(QStringLiteral("/dev/"))) {
+        const QString message = tr("No compatible camera detected");
+        emit previewFailed(message);
+        updateStatus(message);
+        return false;
+    }
+
+    QCameraFormat format = findFormatById(m_selectedFormatId);
+    if (format.isNull()) {
+        format = chooseDefaultFormat();
+    }
+
+    V4l2CaptureSource::Settings settings;
+    settings.devicePath = devicePath;
+    settings.resolution = format.resolution();
+    settings.frameRate = format.isNull() ? 0 : static_cast<int>(std::round(format.maxFrameRate()));
+    settings.preferMjpeg = format.isNull() || isJpegFormat(format);
+    settings.bufferCount = m_captureBufferCount;
+
+    if (!m_directCapture) {
+        m_directCapture = new V4l2CaptureSource(this);
+        connect(m_directCapture, &V4l2CaptureSource::frameReady,
+                this, &CameraPreviewWidget::processCapturedFrame);
+        connect(m_directCapture, &V4l2CaptureSource::started,
+                this, &CameraPreviewWidget::onDirectCaptureStarted);
+        connect(m_directCapture, &V4l2CaptureSource::errorOccurred,
+                this, &CameraPreviewWidget::onDirectCaptureError);
+    }
+
+    updateStatus(tr("Opening %1...").arg(devicePath));
+    m_directCapture->start(settings);
+    return true;
+}
+
+void CameraPreviewWidget::onDirectCaptureStarted(const QSize &size, const QString &description)
+{
+    if (!m_previewEnabled) {
+        return;
+    }
+
+    updateStatus(tr("Preview running (%1, direct V4L2)").arg(description));
+    emit previewStarted();
+    if (size.isValid() && size.height() > 0) {
+        emit aspectRatioChanged(static_cast<double>(size.width()) / static_cast<double>(size.height()));
+    }
+}
+
+void CameraPreviewWidget::onDirectCaptureError(const QString &message)
+{
+    emit previewFailed(message);
+    stopPreview();
+    updateStatus(tr("Camera error: %1").arg(message));
+}
+
 void CameraPreviewWidget::handleIncomingFrame(const QVideoFrame &frame)
+{
+    processCapturedFrame(frame, 0);
+}
+
+void CameraPreviewWidget::processCapturedFrame(const QVideoFrame &frame, qint64 captureTimeUs)
 {
     if (!m_filterPreviewWidget) {
         return;
     }
 
-    m_filterPreviewWidget->updateVideoFrame(frame);
+    const bool previewVisible = m_filterPreviewWidget->isVisible();
+    const bool streaming = m_virtualCameraOutputs && m_virtualCameraOutputs->isEnabled();
+    const bool pipelineAvailable = m_effectsPipeline && m_effectsPipeline->isAvailable();
+
+    // The preview renders frames itself only when it cannot sample the
+    // pipeline's output; nothing is processed for it while it is hidden
+    if (previewVisible && !(pipelineAvailable && m_effectsPipeline->isDisplayAvailable())) {
+        m_filterPreviewWidget->updateVideoFrame(frame);
+    }
+    if (pipelineAvailable) {
+        m_effectsPipeline->setReadbackEnabled(streaming);
+        // The preview samples a copy at its own size; without a virtual
+        // camera reading back full frames, the effects run at that size too
+        const QSize displaySize = m_previewQuality == PreviewQuality::Display
+            ? m_filterPreviewWidget->displayPixelSize()
+            : QSize();
+        const QSize renderLimit = streaming ? QSize() : displaySize;
+        m_effectsPipeline->setDisplaySize(displaySize);
+        m_effectsPipeline->setMaxDecodeSize(renderLimit);
+        m_effectsPipeline->setMaxRenderSize(renderLimit);
+        if (streaming || (previewVisible && m_effectsPipeline->isDisplayAvailable())) {
+            m_effectsPipeline->submitFrame(frame, captureTimeUs);
+        }
+    }
 
     if (frame.isValid() && frame.width() > 0 && frame.height() > 0) {
         emit aspectRatioChanged(static_cast<double>(frame.width()) /
@@ -12,15 +12,22 @@ class QLabel;
 class QMediaCaptureSession;
 class QVideoSink;
 class QWidget;
-class VirtualCameraStreamer;
+class OffscreenEffectsEngine;
+class V4l2CaptureSource;
+class VirtualCameraOutputs;
 
 /**
  * @brief Camera preview widget with enable/disable control
  *
  * Features:
  * - Starts disabled by default
- * - Auto-disables when window is minimized or hidden
+ * - Auto-disables when window is minimized or hidden, unless the virtual
+ *   camera is streaming (effects render offscreen, without the preview)
+ * - Processes frames on an effects thread at the camera's or a configured
+ *   rate; the preview only displays the latest processed frame
  * - Opens camera in shared mode (doesn't block other apps)
+ * - Can capture straight from V4L2 instead of QtMultimedia, for control
+ *   over buffering and the raw MJPEG/YUYV frames
  * - Allows user to review effects of camera settings
  */
 class CameraPreviewWidget : public QWidget
@@ -28,6 +35,16 @@ class CameraPreviewWidget : public QWidget
     Q_OBJECT
 
 public:
+    enum class CaptureBackend {
+        QtMultimedia,
+        V4l2
+    };
+
+    enum class PreviewQuality {
+        Display,  // Preview at its own size; effects too while no virtual camera streams
+        Full      // Everything at the camera resolution
+    };
+
     explicit CameraPreviewWidget(QWidget *parent = nullptr);
     ~CameraPreviewWidget();
 
@@ -38,7 +55,13 @@ public:
     QString preferredFormatId() const { return m_selectedFormatId; }
     void setPreferredFormatId(const QString &formatId);
     void setControlsVisible(bool visible);
-    void setVirtualCameraStreamer(VirtualCameraStreamer *streamer);
+    // An empty devicePath captures from the preview camera's own node
+    void setCaptureBackend(CaptureBackend backend, const QString &devicePath, int bufferCount);
+    void setPreviewQuality(PreviewQuality quality);
+    void setVirtualCameraOutputs(VirtualCameraOutputs *outputs);
+    void setVirtualCameraGpuPacking(bool enabled, const QSize &targetSize);
+    void setVirtualCameraReadbackLatency(int frames);
+    void setVirtualCameraFrameRate(int fps);  // 0 follows the camera
     void setVideoEffects(const FilterPreviewWidget::VideoEffectsSettings &settings);
     FilterPreviewWidget::VideoEffectsSettings videoEffects() const;
 
@@ -53,6 +76,8 @@ private slots:
     void onCameraError(QCamera::Error error);
     void onFormatSelectionChanged(int index);
     void onCameraActiveChanged(bool active);
+    void onDirectCaptureStarted(const QSize &size, const QString &description);
+    void onDirectCaptureError(const QString &message);
 
 private:
     void setupUI();
@@ -60,6 +85,8 @@ private:
     void startPreview();
     void stopPreview();
     void handleIncomingFrame(const QVideoFrame &frame);
+    void processCapturedFrame(const QVideoFrame &frame, qint64 captureTimeUs);
+    bool startDirectCapture();
     QCameraFormat findFormatById(const QString &id) const;
     QCameraDevice resolveCameraDevice() const;
     void refreshFormatOptions(const QCameraDevice &device);
@@ -73,14 +100,20 @@ private:
     QCamera *m_camera;
     QMediaCaptureSession *m_captureSession;
     QVideoSink *m_videoSink;
+    V4l2CaptureSource *m_directCapture;
     FilterPreviewWidget *m_filterPreviewWidget;
     QComboBox *m_formatCombo;
     QLabel *m_statusLabel;
     QWidget *m_controlRow;
-    VirtualCameraStreamer *m_virtualCameraStreamer;
+    VirtualCameraOutputs *m_virtualCameraOutputs;
+    OffscreenEffectsEngine *m_effectsPipeline;
     QString m_selectedFormatId;
     QString m_requestedDeviceId;
     QList<QCameraFormat> m_availableFormats;
+    CaptureBackend m_captureBackend;
+    QString m_captureDevicePath;
+    int m_captureBufferCount;
+    PreviewQuality m_previewQuality;
 
     bool m_previewEnabled;
     bool m_isApplyingFormat;
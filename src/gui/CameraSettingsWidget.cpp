@@ -12,6 +12,11 @@ CameraSettingsWidget::CameraSettingsWidget(CameraController *controller, QWidget
     // Create debounce timer for command completion
     m_commandTimer = new QTimer(this);
     m_commandTimer->setSingleShot(true);
+    // Updates are only sent on change, so catch up on any skipped meanwhile
+    connect(m_commandTimer, &QTimer::timeout, this, [this]() {
+        m_userInitiated = false;
+        updateFromState(m_controller->getCurrentState());
+    });
     QVBoxLayout *layout = new QVBoxLayout(this);
     layout->setContentsMargins(8, 14, 8, 14);
     layout->setSpacing(14);
@@ -255,7 +260,8 @@ void CameraSettingsWidget::onWhiteBalanceKelvinChanged(int value)
     m_commandTimer->start(1000);
 }
 
-void CameraSettingsWidget::updateFromState(const CameraController::CameraState &state)
+void CameraSettingsWidget::updateFromState(const CameraController::CameraState &state,
+                                           CameraController::StateFields changed)
 {
     applyControlRanges();
 
@@ -264,46 +270,53 @@ void CameraSettingsWidget::updateFromState(const CameraController::CameraState &
     bool isSettling = m_controller->isSettling();
 
     if (!m_userInitiated && !commandInFlight && !isSettling) {
-        if (m_hdrCheckBox->isChecked() != state.hdrEnabled) {
+        if ((changed & CameraController::HdrField) &&
+            m_hdrCheckBox->isChecked() != state.hdrEnabled) {
             m_hdrCheckBox->blockSignals(true);
             m_hdrCheckBox->setChecked(state.hdrEnabled);
             m_hdrCheckBox->blockSignals(false);
         }
 
-        if (m_fovComboBox->currentIndex() != state.fovMode) {
+        if ((changed & CameraController::FovField) &&
+            m_fovComboBox->currentIndex() != state.fovMode) {
             m_fovComboBox->blockSignals(true);
             m_fovComboBox->setCurrentIndex(state.fovMode);
             m_fovComboBox->blockSignals(false);
         }
 
-        if (m_faceAECheckBox->isChecked() != state.faceAEEnabled) {
+        if ((changed & CameraController::FaceAEField) &&
+            m_faceAECheckBox->isChecked() != state.faceAEEnabled) {
             m_faceAECheckBox->blockSignals(true);
             m_faceAECheckBox->setChecked(state.faceAEEnabled);
             m_faceAECheckBox->blockSignals(false);
         }
 
-        if (m_faceFocusCheckBox->isChecked() != state.faceFocusEnabled) {
+        if ((changed & CameraController::FaceFocusField) &&
+            m_faceFocusCheckBox->isChecked() != state.faceFocusEnabled) {
             m_faceFocusCheckBox->blockSignals(true);
             m_faceFocusCheckBox->setChecked(state.faceFocusEnabled);
             m_faceFocusCheckBox->blockSignals(false);
         }
 
         // Image controls - update auto checkboxes
-        if (m_brightnessAutoCheckBox->isChecked() != state.brightnessAuto) {
+        if ((changed & CameraController::BrightnessAutoField) &&
+            m_brightnessAutoCheckBox->isChecked() != state.brightnessAuto) {
             m_brightnessAutoCheckBox->blockSignals(true);
             m_brightnessAutoCheckBox->setChecked(state.brightnessAuto);
             m_brightnessAutoCheckBox->blockSignals(false);
             m_brightnessSlider->setEnabled(!state.brightnessAuto);
         }
 
-        if (m_contrastAutoCheckBox->isChecked() != state.contrastAuto) {
+        if ((changed & CameraController::ContrastAutoField) &&
+            m_contrastAutoCheckBox->isChecked() != state.contrastAuto) {
             m_contrastAutoCheckBox->blockSignals(true);
             m_contrastAutoCheckBox->setChecked(state.contrastAuto);
             m_contrastAutoCheckBox->blockSignals(false);
             m_contrastSlider->setEnabled(!state.contrastAuto);
         }
 
-        if (m_saturationAutoCheckBox->isChecked() != state.saturationAuto) {
+        if ((changed & CameraController::SaturationAutoField) &&
+            m_saturationAutoCheckBox->isChecked() != state.saturationAuto) {
             m_saturationAutoCheckBox->blockSignals(true);
             m_saturationAutoCheckBox->setChecked(state.saturationAuto);
             m_saturationAutoCheckBox->blockSignals(false);
@@ -314,19 +327,22 @@ void CameraSettingsWidget::updateFromState(const CameraController::CameraState &
     // Always update slider values when in auto mode (to show polled values)
     // When not in auto mode, only update if not user-initiated
     if (!m_userInitiated && !commandInFlight && !isSettling) {
-        if (m_brightnessSlider->value() != state.brightness) {
+        if ((changed & CameraController::BrightnessField) &&
+            m_brightnessSlider->value() != state.brightness) {
             m_brightnessSlider->blockSignals(true);
             m_brightnessSlider->setValue(state.brightness);
             m_brightnessSlider->blockSignals(false);
         }
 
-        if (m_contrastSlider->value() != state.contrast) {
+        if ((changed & CameraController::ContrastField) &&
+            m_contrastSlider->value() != state.contrast) {
             m_contrastSlider->blockSignals(true);
             m_contrastSlider->setValue(state.contrast);
             m_contrastSlider->blockSignals(false);
         }
 
-        if (m_saturationSlider->value() != state.saturation) {
+        if ((changed & CameraController::SaturationField) &&
+            m_saturationSlider->value() != state.saturation) {
             m_saturationSlider->blockSignals(true);
             m_saturationSlider->setValue(state.saturation);
             m_saturationSlider->blockSignals(false);
@@ -334,16 +350,20 @@ void CameraSettingsWidget::updateFromState(const CameraController::CameraState &
     }
 
     int desiredWbIndex = m_whiteBalanceComboBox->findData(state.whiteBalance);
-    if (!m_userInitiated && !commandInFlight && !isSettling && desiredWbIndex >= 0 &&
+    if ((changed & CameraController::WhiteBalanceField) &&
+        !m_userInitiated && !commandInFlight && !isSettling && desiredWbIndex >= 0 &&
         m_whiteBalanceComboBox->currentIndex() != desiredWbIndex) {
         m_whiteBalanceComboBox->blockSignals(true);
         m_whiteBalanceComboBox->setCurrentIndex(desiredWbIndex);
         m_whiteBalanceComboBox->blockSignals(false);
     }
 
-    updateWhiteBalanceControls(state.whiteBalance);
+    if (changed & CameraController::WhiteBalanceField) {
+        updateWhiteBalanceControls(state.whiteBalance);
+    }
 
-    if (!m_userInitiated && !commandInFlight && !isSettling) {
+    if ((changed & CameraController::WhiteBalanceKelvinField) &&
+        !m_userInitiated && !commandInFlight && !isSettling) {
         int clampedKelvin = std::clamp(state.whiteBalanceKelvin,
             m_whiteBalanceKelvinSlider->minimum(), m_whiteBalanceKelvinSlider->maximum());
         if (m_whiteBalanceKelvinSlider->value() != clampedKelvin) {
@@ -22,7 +22,9 @@ class CameraSettingsWidget : public QWidget
 public:
     explicit CameraSettingsWidget(CameraController *controller, QWidget *parent = nullptr);
 
-    void updateFromState(const CameraController::CameraState &state);
+    // Only the controls for the changed fields are touched
+    void updateFromState(const CameraController::CameraState &state,
+                         CameraController::StateFields changed = CameraController::AllStateFields);
 
     // Getters for current UI state
     bool isHDREnabled() const { return m_hdrCheckBox->isChecked(); }
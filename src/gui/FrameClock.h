@@ -0,0 +1,72 @@
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+#include <algorithm>
+#include <time.h>
+
+/**
+ * @brief Monotonic timestamps for frames moving through the pipeline.
+ *
+ * Reads CLOCK_MONOTONIC, the clock V4L2 buffer timestamps are defined on,
+ * so a capture time taken here can be handed to consumers unchanged.
+ */
+namespace FrameClock {
+
+inline qint64 nowUs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<qint64>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Deadlines for a clock ticking at a fixed frame rate.
+ *
+ * Ticks are scheduled against absolute deadlines counted from start(), so
+ * millisecond timer rounding does not drift the average rate. When more
+ * than a frame behind (suspend, long stall) it starts over instead of
+ * firing a burst of catch-up ticks. Drives a single-shot QTimer: start()
+ * once, then restart the timer with nextDelayMs() on every tick.
+ */
+class TickSchedule
+{
+public:
+    void start(int frameRate)
+    {
+        m_frameRate = std::max(0, frameRate);
+        m_ticks = 0;
+        m_epoch.start();
+    }
+
+    int frameRate() const { return m_frameRate; }
+
+    // Milliseconds until the next tick is due
+    int nextDelayMs()
+    {
+        if (m_frameRate <= 0) {
+            return 0;
+        }
+
+        constexpr qint64 kNanosecondsPerSecond = 1000000000;
+        const qint64 period = kNanosecondsPerSecond / m_frameRate;
+        ++m_ticks;
+        qint64 remaining = m_ticks * kNanosecondsPerSecond / m_frameRate - m_epoch.nsecsElapsed();
+        if (remaining < -period) {
+            m_epoch.start();
+            m_ticks = 1;
+            remaining = period;
+        }
+        return static_cast<int>(std::max<qint64>(0, (remaining + 999999) / 1000000));
+    }
+
+private:
+    QElapsedTimer m_epoch;
+    qint64 m_ticks = 0;
+    int m_frameRate = 0;
+};
+
+} // namespace FrameClock
+
+#endif // FRAMECLOCK_H
@@ -0,0 +1,218 @@
+#include "FramePool.h"
+
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <iterator>
+#include <new>
+#include <utility>
+
+Q_LOGGING_CATEGORY(FramePoolLog, "obsbot.framepool")
+
+namespace {
+
+constexpr std::size_t kBufferAlignment = 64;
+
+// A few frames in flight per size covers readback latency plus the
+// virtual camera queue; anything beyond that is a burst or a stale size
+constexpr std::size_t kMaxIdleBuffersPerSize = 6;
+constexpr qint64 kMaxPooledBytes = 192ll * 1024 * 1024;
+
+} // namespace
+
+FrameBuffer::FrameBuffer(const FrameBuffer &other)
+    : m_block(other.m_block)
+{
+    if (m_block) {
+        m_block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameBuffer::FrameBuffer(FrameBuffer &&other) noexcept
+    : m_block(other.m_block)
+{
+    other.m_block = nullptr;
+}
+
+FrameBuffer &FrameBuffer::operator=(const FrameBuffer &other)
+{
+    if (m_block != other.m_block) {
+        FrameBuffer copy(other);
+        std::swap(m_block, copy.m_block);
+    }
+    return *this;
+}
+
+FrameBuffer &FrameBuffer::operator=(FrameBuffer &&other) noexcept
+{
+    if (this != &other) {
+        reset();
+        m_block = other.m_block;
+        other.m_block = nullptr;
+    }
+    return *this;
+}
+
+FrameBuffer::~FrameBuffer()
+{
+    reset();
+}
+
+void FrameBuffer::reset()
+{
+    // The last handle hands the block back; acq_rel orders every write
+    // through other handles before the pool sees it again
+    if (m_block && m_block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        FramePool::instance().release(m_block);
+    }
+    m_block = nullptr;
+}
+
+FramePool::Block *FramePool::allocateBlock(qsizetype bytes)
+{
+    void *memory = ::operator new(sizeof(Block) + static_cast<std::size_t>(bytes),
+                                  std::align_val_t(kBufferAlignment));
+    Block *block = new (memory) Block;
+    block->size = bytes;
+    return block;
+}
+
+void FramePool::freeBlock(Block *block)
+{
+    block->~Block();
+    ::operator delete(block, std::align_val_t(kBufferAlignment));
+}
+
+FramePool &FramePool::instance()
+{
+    // Never destroyed: handles may still be released by threads that
+    // outlive static destruction
+    static FramePool *pool = new FramePool();
+    return *pool;
+}
+
+FrameBuffer FramePool::acquire(qsizetype bytes)
+{
+    if (bytes <= 0) {
+        return FrameBuffer();
+    }
+
+    Block *block = nullptr;
+    bool allocated = false;
+    quint64 allocations = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_idle.find(bytes);
+        if (it != m_idle.end() && !it->second.empty()) {
+            block = it->second.back();
+            it->second.pop_back();
+            m_stats.bytesPooled -= bytes;
+            ++m_stats.reuses;
+        } else {
+            allocated = true;
+            allocations = ++m_stats.allocations;
+        }
+        m_stats.bytesInUse += bytes;
+    }
+
+    if (allocated) {
+        block = allocateBlock(bytes);
+        qCDebug(FramePoolLog) << "Allocated" << bytes << "byte frame buffer," << allocations << "so far";
+    }
+
+    block->refs.store(1, std::memory_order_relaxed);
+    return FrameBuffer(block);
+}
+
+QImage FramePool::acquireImage(const QSize &size, QImage::Format format)
+{
+    if (size.isEmpty() || format == QImage::Format_Invalid) {
+        return QImage();
+    }
+
+    const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+    const qsizetype bytesPerLine = ((static_cast<qsizetype>(size.width()) * depth + 31) / 32) * 4;
+    FrameBuffer buffer = acquire(bytesPerLine * size.height());
+    if (buffer.isNull()) {
+        return QImage();
+    }
+
+    // The image takes over the handle's reference until Qt calls the cleanup
+    uchar *bits = buffer.data();
+    Block *block = buffer.m_block;
+    buffer.m_block = nullptr;
+    return QImage(bits, size.width(), size.height(), bytesPerLine, format,
+                  releaseImageBuffer, block);
+}
+
+void FramePool::releaseImageBuffer(void *block)
+{
+    FrameBuffer adopted(static_cast<Block *>(block));
+}
+
+FramePool::Stats FramePool::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void FramePool::trim()
+{
+    std::unordered_map<qsizetype, std::vector<Block *>> idle;
+    {
+        QMutexLocker locker(&m_mutex);
+        idle.swap(m_idle);
+        m_stats.bytesPooled = 0;
+    }
+
+    for (auto &entry : idle) {
+        for (Block *block : entry.second) {
+            freeBlock(block);
+        }
+    }
+}
+
+void FramePool::release(Block *block)
+{
+    const qsizetype bytes = block->size;
+    std::vector<Block *> evicted;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.bytesInUse -= bytes;
+
+        std::vector<Block *> &idle = m_idle[bytes];
+        if (idle.size() < kMaxIdleBuffersPerSize) {
+            // Over budget: drop idle buffers of other sizes first, they are
+            // left over from a resolution that is no longer streaming
+            for (auto it = m_idle.begin();
+                 it != m_idle.end() && m_stats.bytesPooled + bytes > kMaxPooledBytes;) {
+                if (it->first == bytes) {
+                    ++it;
+                    continue;
+                }
+                while (!it->second.empty() && m_stats.bytesPooled + bytes > kMaxPooledBytes) {
+                    evicted.push_back(it->second.back());
+                    it->second.pop_back();
+                    m_stats.bytesPooled -= it->first;
+                    ++m_stats.discards;
+                }
+                it = it->second.empty() ? m_idle.erase(it) : std::next(it);
+            }
+
+            if (m_stats.bytesPooled + bytes <= kMaxPooledBytes) {
+                idle.push_back(block);
+                m_stats.bytesPooled += bytes;
+                block = nullptr;
+            }
+        }
+        if (block) {
+            ++m_stats.discards;
+        }
+    }
+
+    for (Block *buffer : evicted) {
+        freeBlock(buffer);
+    }
+    if (block) {
+        freeBlock(block);
+    }
+}
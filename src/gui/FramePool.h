@@ -0,0 +1,113 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QtGlobal>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Ref-counted handle to a pooled, frame-sized byte buffer.
+ *
+ * Copies share the buffer. It returns to FramePool when the last copy is
+ * destroyed, on whichever thread that happens. The reference count lives in
+ * a header in front of the pooled bytes, so handles themselves never touch
+ * the heap.
+ */
+class FrameBuffer
+{
+public:
+    FrameBuffer() = default;
+    FrameBuffer(const FrameBuffer &other);
+    FrameBuffer(FrameBuffer &&other) noexcept;
+    FrameBuffer &operator=(const FrameBuffer &other);
+    FrameBuffer &operator=(FrameBuffer &&other) noexcept;
+    ~FrameBuffer();
+
+    bool isNull() const { return !m_block; }
+    uchar *data() { return m_block ? m_block->bytes() : nullptr; }
+    const uchar *constData() const { return m_block ? m_block->bytes() : nullptr; }
+    qsizetype size() const { return m_block ? m_block->size : 0; }
+
+private:
+    friend class FramePool;
+
+    // Sits at the start of each pooled allocation, padded so the bytes
+    // after it keep the pool's 64-byte alignment
+    struct alignas(64) Block {
+        std::atomic<int> refs;
+        qsizetype size;
+
+        uchar *bytes() { return reinterpret_cast<uchar *>(this + 1); }
+    };
+    static_assert(sizeof(Block) == 64, "Pooled bytes must stay 64-byte aligned");
+
+    // Adopts a reference the caller already holds
+    explicit FrameBuffer(Block *block)
+        : m_block(block)
+    {
+    }
+
+    void reset();
+
+    Block *m_block = nullptr;
+};
+
+/**
+ * @brief Process-wide pool of frame buffers, keyed by byte size.
+ *
+ * The effects readback and the virtual camera draw their per-frame buffers
+ * from here and recycle them when the last handle goes away, so a stream at
+ * a fixed resolution stops allocating once the first few frames have been
+ * through. Buffers are 64-byte aligned for the SIMD converters. Thread-safe.
+ *
+ * stats() makes the steady state checkable: after warm-up, allocations
+ * should stay flat while reuses keep climbing. They count every heap
+ * allocation the pool makes; the only one left per frame is the small
+ * QImageData that Qt creates inside each QImage from acquireImage().
+ */
+class FramePool
+{
+public:
+    struct Stats {
+        quint64 allocations = 0;  // Buffers newly allocated
+        quint64 reuses = 0;       // Acquires served from idle buffers
+        quint64 discards = 0;     // Released buffers freed instead of kept
+        qint64 bytesInUse = 0;    // Held by live handles
+        qint64 bytesPooled = 0;   // Idle, waiting for reuse
+    };
+
+    static FramePool &instance();
+
+    FrameBuffer acquire(qsizetype bytes);
+
+    // An image whose pixels live in a pooled buffer. Rows are 4-byte
+    // aligned; the buffer is recycled once every QImage copy is gone.
+    QImage acquireImage(const QSize &size, QImage::Format format);
+
+    Stats stats() const;
+
+    // Free every idle buffer
+    void trim();
+
+private:
+    FramePool() = default;
+
+    friend class FrameBuffer;
+    using Block = FrameBuffer::Block;
+
+    static Block *allocateBlock(qsizetype bytes);
+    static void freeBlock(Block *block);
+    void release(Block *block);
+    // QImage cleanup callback; drops the image's reference
+    static void releaseImageBuffer(void *block);
+
+    mutable QMutex m_mutex;
+    std::unordered_map<qsizetype, std::vector<Block *>> m_idle;
+    Stats m_stats;
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,64 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free ring for handing frames from one thread to another.
+ *
+ * Exactly one thread may push and exactly one other thread may pop. Slots
+ * are allocated once with the ring; push() and pop() move values in and
+ * out, so handing over ref-counted frames neither locks nor allocates.
+ * A full ring rejects the push and leaves the decision to drop to the
+ * producer. Wakeups are up to the owner.
+ */
+template <typename T, std::size_t Capacity>
+class FrameRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "FrameRing capacity must be a power of two");
+
+public:
+    FrameRing() = default;
+    FrameRing(const FrameRing &) = delete;
+    FrameRing &operator=(const FrameRing &) = delete;
+
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    // Producer side; false when the consumer has not caught up
+    bool push(T value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+
+        m_slots[head & (Capacity - 1)] = std::move(value);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; the slot is left moved-from so references drop early
+    bool pop(T &value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        value = std::move(m_slots[tail & (Capacity - 1)]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> m_slots;
+    // Each index is written by one side only; keep them on separate cache lines
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+#endif // FRAMERING_H
@@ -0,0 +1,387 @@
+#include "FrameScaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OBSBOT_SCALER_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define OBSBOT_SCALER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr int kWeightBits = 14;
+constexpr int kWeightOne = 1 << kWeightBits;
+constexpr int kWeightRound = 1 << (kWeightBits - 1);
+
+// Slack after the filtered row so the SIMD horizontal pass can load a whole
+// tap pair past the last column; those bytes always meet a zero weight
+constexpr int kRowPadding = 16;
+
+inline uint8_t clampToByte(int value)
+{
+    return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+double triangle(double x)
+{
+    x = std::abs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+// Vertical pass: out[x] = sum(weights[k] * rows[k][x]) over the tap rows.
+// Weights fit in 15 bits, so every kernel accumulates exactly like this one.
+void filterColumnsScalar(const uint8_t *const *rows, const int16_t *weights, int taps,
+                         uint8_t *out, int x, int bytes)
+{
+    for (; x < bytes; ++x) {
+        int sum = kWeightRound;
+        for (int k = 0; k < taps; ++k) {
+            sum += weights[k] * rows[k][x];
+        }
+        out[x] = clampToByte(sum >> kWeightBits);
+    }
+}
+
+// Horizontal pass over RGB888 pixels
+void filterRowScalar(const uint8_t *row, const int *first, const int *count,
+                     const int16_t *weights, int weightStride, int firstColumn,
+                     uint8_t *dst, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        const uint8_t *p = row + (first[x] - firstColumn) * 3;
+        const int16_t *w = weights + static_cast<size_t>(x) * weightStride;
+        int r = kWeightRound;
+        int g = kWeightRound;
+        int b = kWeightRound;
+        for (int k = 0; k < count[x]; ++k) {
+            r += w[k] * p[k * 3 + 0];
+            g += w[k] * p[k * 3 + 1];
+            b += w[k] * p[k * 3 + 2];
+        }
+        dst[x * 3 + 0] = clampToByte(r >> kWeightBits);
+        dst[x * 3 + 1] = clampToByte(g >> kWeightBits);
+        dst[x * 3 + 2] = clampToByte(b >> kWeightBits);
+    }
+}
+
+#if defined(OBSBOT_SCALER_X86)
+
+// Taps are processed in pairs: bytes from two rows (or two pixels) are
+// interleaved into 16-bit lanes and multiplied by a weight pair with madd,
+// which yields the same 32-bit sums as the scalar loop. An odd last tap is
+// paired with itself under a zero weight.
+
+inline int weightPair(const int16_t *weights, int k, int taps)
+{
+    const int second = k + 1 < taps ? weights[k + 1] : 0;
+    return static_cast<uint16_t>(weights[k]) | (second << 16);
+}
+
+__attribute__((target("sse4.1")))
+void filterColumnsSse41(const uint8_t *const *rows, const int16_t *weights, int taps,
+                        uint8_t *out, int x, int bytes)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(kWeightRound);
+
+    for (; x + 16 <= bytes; x += 16) {
+        __m128i acc0 = round;
+        __m128i acc1 = round;
+        __m128i acc2 = round;
+        __m128i acc3 = round;
+        for (int k = 0; k < taps; k += 2) {
+            const uint8_t *second = k + 1 < taps ? rows[k + 1] : rows[k];
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + x));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(second + x));
+            const __m128i w = _mm_set1_epi32(weightPair(weights, k, taps));
+
+            const __m128i aLo = _mm_unpacklo_epi8(a, zero);
+            const __m128i aHi = _mm_unpackhi_epi8(a, zero);
+            const __m128i bLo = _mm_unpacklo_epi8(b, zero);
+            const __m128i bHi = _mm_unpackhi_epi8(b, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(aLo, bLo), w));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(aLo, bLo), w));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(aHi, bHi), w));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(aHi, bHi), w));
+        }
+
+        const __m128i lo = _mm_packs_epi32(_mm_srai_epi32(acc0, kWeightBits), _mm_srai_epi32(acc1, kWeightBits));
+        const __m128i hi = _mm_packs_epi32(_mm_srai_epi32(acc2, kWeightBits), _mm_srai_epi32(acc3, kWeightBits));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(lo, hi));
+    }
+
+    filterColumnsScalar(rows, weights, taps, out, x, bytes);
+}
+
+__attribute__((target("avx2")))
+void filterColumnsAvx2(const uint8_t *const *rows, const int16_t *weights, int taps,
+                       uint8_t *out, int bytes)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(kWeightRound);
+
+    int x = 0;
+    for (; x + 32 <= bytes; x += 32) {
+        __m256i acc0 = round;
+        __m256i acc1 = round;
+        __m256i acc2 = round;
+        __m256i acc3 = round;
+        for (int k = 0; k < taps; k += 2) {
+            const uint8_t *second = k + 1 < taps ? rows[k + 1] : rows[k];
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k] + x));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(second + x));
+            const __m256i w = _mm256_set1_epi32(weightPair(weights, k, taps));
+
+            // The unpacks shuffle within 128-bit lanes; the in-lane packs
+            // below undo that, so bytes come out in order
+            const __m256i aLo = _mm256_unpacklo_epi8(a, zero);
+            const __m256i aHi = _mm256_unpackhi_epi8(a, zero);
+            const __m256i bLo = _mm256_unpacklo_epi8(b, zero);
+            const __m256i bHi = _mm256_unpackhi_epi8(b, zero);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(aLo, bLo), w));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(aLo, bLo), w));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(aHi, bHi), w));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(aHi, bHi), w));
+        }
+
+        const __m256i lo = _mm256_packs_epi32(_mm256_srai_epi32(acc0, kWeightBits),
+                                              _mm256_srai_epi32(acc1, kWeightBits));
+        const __m256i hi = _mm256_packs_epi32(_mm256_srai_epi32(acc2, kWeightBits),
+                                              _mm256_srai_epi32(acc3, kWeightBits));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), _mm256_packus_epi16(lo, hi));
+    }
+
+    filterColumnsSse41(rows, weights, taps, out, x, bytes);
+}
+
+// Shared by the SSE4.1 and AVX2 backends; one output pixel per iteration
+// is already bound by the tap loads
+__attribute__((target("sse4.1")))
+void filterRowSse41(const uint8_t *row, const int *first, const int *count,
+                    const int16_t *weights, int weightStride, int firstColumn,
+                    uint8_t *dst, int width)
+{
+    // Two RGB pixels -> [r0 r1 g0 g1 b0 b1 0 0] as 16-bit lanes
+    const __m128i pairPixels = _mm_setr_epi8(0, 3, 1, 4, 2, 5, -1, -1,
+                                             -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i round = _mm_set1_epi32(kWeightRound);
+
+    for (int x = 0; x < width; ++x) {
+        const uint8_t *p = row + (first[x] - firstColumn) * 3;
+        const int16_t *w = weights + static_cast<size_t>(x) * weightStride;
+        __m128i acc = round;
+        for (int k = 0; k < count[x]; k += 2) {
+            const __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + k * 3));
+            const __m128i lanes = _mm_cvtepu8_epi16(_mm_shuffle_epi8(pixels, pairPixels));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(lanes, _mm_set1_epi32(weightPair(w, k, count[x]))));
+        }
+
+        const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(acc, kWeightBits), _mm_setzero_si128());
+        const uint32_t rgb = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(packed, packed)));
+        std::memcpy(dst + x * 3, &rgb, 3);
+    }
+}
+
+#endif // OBSBOT_SCALER_X86
+
+#if defined(OBSBOT_SCALER_NEON)
+
+void filterColumnsNeon(const uint8_t *const *rows, const int16_t *weights, int taps,
+                       uint8_t *out, int bytes)
+{
+    int x = 0;
+    for (; x + 8 <= bytes; x += 8) {
+        int32x4_t accLo = vdupq_n_s32(kWeightRound);
+        int32x4_t accHi = vdupq_n_s32(kWeightRound);
+        for (int k = 0; k < taps; ++k) {
+            const int16x8_t v = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(rows[k] + x)));
+            accLo = vmlal_n_s16(accLo, vget_low_s16(v), weights[k]);
+            accHi = vmlal_n_s16(accHi, vget_high_s16(v), weights[k]);
+        }
+
+        const int16x8_t narrowed = vcombine_s16(vqmovn_s32(vshrq_n_s32(accLo, kWeightBits)),
+                                                vqmovn_s32(vshrq_n_s32(accHi, kWeightBits)));
+        vst1_u8(out + x, vqmovun_s16(narrowed));
+    }
+
+    filterColumnsScalar(rows, weights, taps, out, x, bytes);
+}
+
+#endif // OBSBOT_SCALER_NEON
+
+void filterColumns(YuvConverter::Backend backend, const uint8_t *const *rows,
+                   const int16_t *weights, int taps, uint8_t *out, int bytes)
+{
+    switch (backend) {
+#if defined(OBSBOT_SCALER_X86)
+    case YuvConverter::Backend::Avx2:
+        filterColumnsAvx2(rows, weights, taps, out, bytes);
+        return;
+    case YuvConverter::Backend::Sse41:
+        filterColumnsSse41(rows, weights, taps, out, 0, bytes);
+        return;
+#endif
+#if defined(OBSBOT_SCALER_NEON)
+    case YuvConverter::Backend::Neon:
+        filterColumnsNeon(rows, weights, taps, out, bytes);
+        return;
+#endif
+    default:
+        filterColumnsScalar(rows, weights, taps, out, 0, bytes);
+        return;
+    }
+}
+
+void filterRow(YuvConverter::Backend backend, const uint8_t *row, const int *first, const int *count,
+               const int16_t *weights, int weightStride, int firstColumn, uint8_t *dst, int width)
+{
+    switch (backend) {
+#if defined(OBSBOT_SCALER_X86)
+    case YuvConverter::Backend::Avx2:
+    case YuvConverter::Backend::Sse41:
+        filterRowSse41(row, first, count, weights, weightStride, firstColumn, dst, width);
+        return;
+#endif
+    default:
+        filterRowScalar(row, first, count, weights, weightStride, firstColumn, dst, width);
+        return;
+    }
+}
+
+} // namespace
+
+void FrameScaler::configure(const QSize &sourceSize, const QSize &targetSize, Fit fit)
+{
+    if (sourceSize == m_sourceSize && targetSize == m_targetSize && fit == m_fit) {
+        return;
+    }
+
+    m_sourceSize = sourceSize;
+    m_targetSize = targetSize;
+    m_fit = fit;
+
+    // Cropping scales to cover the target, like Qt::KeepAspectRatioByExpanding,
+    // and keeps the centre
+    const QSize scaledSize = fit == Fit::Crop && !sourceSize.isEmpty()
+        ? sourceSize.scaled(targetSize, Qt::KeepAspectRatioByExpanding)
+        : targetSize;
+    m_horizontal = computeTaps(sourceSize.width(), scaledSize.width(), targetSize.width());
+    m_vertical = computeTaps(sourceSize.height(), scaledSize.height(), targetSize.height());
+
+    m_firstColumn = 0;
+    m_endColumn = 0;
+    if (!m_horizontal.first.empty()) {
+        m_firstColumn = m_horizontal.first.front();
+        for (size_t x = 0; x < m_horizontal.first.size(); ++x) {
+            m_firstColumn = std::min(m_firstColumn, m_horizontal.first[x]);
+            m_endColumn = std::max(m_endColumn, m_horizontal.first[x] + m_horizontal.count[x]);
+        }
+    }
+}
+
+FrameScaler::FilterTaps FrameScaler::computeTaps(int sourceLength, int scaledLength, int targetLength)
+{
+    FilterTaps taps;
+    if (sourceLength <= 0 || scaledLength <= 0 || targetLength <= 0) {
+        return taps;
+    }
+
+    const double scale = static_cast<double>(sourceLength) / scaledLength;
+    const double filterScale = std::max(1.0, scale);
+    const double support = filterScale;
+    // Target pixel i sits at i + offset in the scaled image
+    const int offset = std::max(0, (scaledLength - targetLength) / 2);
+
+    const int maxTaps = static_cast<int>(std::ceil(support)) * 2 + 1;
+    taps.stride = (maxTaps + 1) & ~1;
+    taps.first.resize(targetLength);
+    taps.count.resize(targetLength);
+    taps.weights.assign(static_cast<size_t>(targetLength) * taps.stride, 0);
+
+    std::vector<double> weights(maxTaps);
+    for (int i = 0; i < targetLength; ++i) {
+        const double center = (i + offset + 0.5) * scale;
+        const int first = std::max(0, static_cast<int>(center - support + 0.5));
+        const int end = std::min(sourceLength, static_cast<int>(center + support + 0.5));
+        const int count = std::max(0, std::min(end - first, maxTaps));
+
+        double total = 0.0;
+        for (int k = 0; k < count; ++k) {
+            weights[k] = triangle((first + k + 0.5 - center) / filterScale);
+            total += weights[k];
+        }
+
+        // Quantize, then put the rounding error on the largest tap so each
+        // output pixel keeps unit gain
+        int16_t *fixed = taps.weights.data() + static_cast<size_t>(i) * taps.stride;
+        int sum = 0;
+        int largest = 0;
+        for (int k = 0; k < count; ++k) {
+            fixed[k] = static_cast<int16_t>(std::lround(total > 0.0 ? weights[k] / total * kWeightOne : 0.0));
+            sum += fixed[k];
+            if (fixed[k] > fixed[largest]) {
+                largest = k;
+            }
+        }
+        if (count > 0) {
+            fixed[largest] = static_cast<int16_t>(fixed[largest] + kWeightOne - sum);
+        }
+
+        taps.first[i] = first;
+        taps.count[i] = count;
+    }
+
+    return taps;
+}
+
+void FrameScaler::scaleRows(const uint8_t *src, int srcStride,
+                            uint8_t *dst, int dstStride,
+                            int firstRow, int endRow) const
+{
+    scaleRows(YuvConverter::activeBackend(), src, srcStride, dst, dstStride, firstRow, endRow);
+}
+
+void FrameScaler::scaleRows(YuvConverter::Backend backend,
+                            const uint8_t *src, int srcStride,
+                            uint8_t *dst, int dstStride,
+                            int firstRow, int endRow) const
+{
+    const int targetWidth = m_targetSize.width();
+    const int columnBytes = (m_endColumn - m_firstColumn) * 3;
+    endRow = std::min(endRow, m_targetSize.height());
+    if (!src || !dst || targetWidth <= 0 || columnBytes <= 0) {
+        return;
+    }
+
+    if (!YuvConverter::isBackendSupported(backend)) {
+        backend = YuvConverter::Backend::Scalar;
+    }
+
+    // Per thread, reused across frames
+    thread_local std::vector<uint8_t> row;
+    thread_local std::vector<const uint8_t *> tapRows;
+    row.resize(static_cast<size_t>(columnBytes) + m_horizontal.stride * 3 + kRowPadding);
+    tapRows.resize(m_vertical.stride);
+
+    const uint8_t *srcColumns = src + m_firstColumn * 3;
+    for (int y = firstRow; y < endRow; ++y) {
+        // Vertical pass over the source columns this output uses
+        const int count = m_vertical.count[y];
+        for (int k = 0; k < count; ++k) {
+            tapRows[k] = srcColumns + static_cast<size_t>(m_vertical.first[y] + k) * srcStride;
+        }
+        filterColumns(backend, tapRows.data(),
+                      m_vertical.weights.data() + static_cast<size_t>(y) * m_vertical.stride,
+                      count, row.data(), columnBytes);
+
+        // Horizontal pass straight into the destination row
+        filterRow(backend, row.data(), m_horizontal.first.data(), m_horizontal.count.data(),
+                  m_horizontal.weights.data(), m_horizontal.stride, m_firstColumn,
+                  dst + static_cast<size_t>(y) * dstStride, targetWidth);
+    }
+}
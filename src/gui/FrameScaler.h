@@ -0,0 +1,75 @@
+#ifndef FRAMESCALER_H
+#define FRAMESCALER_H
+
+#include "YuvConverter.h"
+
+#include <QSize>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Separable RGB888 resampler for fixed source/target size pairs.
+ *
+ * Uses a triangle (bilinear) filter that widens with the downscale ratio, so
+ * large reductions average every source pixel instead of skipping rows like
+ * plain bilinear sampling. Filter taps and the crop window are fixed-point
+ * and only rebuilt when the sizes change; the virtual camera streams at a
+ * constant size pair, so in practice they are computed once.
+ *
+ * With Fit::Crop the image is scaled to cover the target and centre-cropped
+ * in the same pass, and only the source columns that reach the output are
+ * filtered. The inner loops use the SIMD backend picked by YuvConverter and
+ * give the same bytes as the scalar path. Every output row is computed
+ * independently, so scaleRows() may be called concurrently for disjoint
+ * row ranges and the result does not depend on how rows are split.
+ */
+class FrameScaler
+{
+public:
+    enum class Fit {
+        Stretch,  // Ignore the aspect ratio
+        Crop      // Keep the aspect ratio, cover the target and crop the centre
+    };
+
+    FrameScaler() = default;
+
+    // Cheap when nothing changed
+    void configure(const QSize &sourceSize, const QSize &targetSize, Fit fit = Fit::Stretch);
+
+    QSize sourceSize() const { return m_sourceSize; }
+    QSize targetSize() const { return m_targetSize; }
+
+    // Writes target rows [firstRow, endRow) of the scaled image
+    void scaleRows(const uint8_t *src, int srcStride,
+                   uint8_t *dst, int dstStride,
+                   int firstRow, int endRow) const;
+    // Same with an explicit backend (falls back to scalar if unsupported)
+    void scaleRows(YuvConverter::Backend backend,
+                   const uint8_t *src, int srcStride,
+                   uint8_t *dst, int dstStride,
+                   int firstRow, int endRow) const;
+
+private:
+    // Per output pixel: first source index, tap count and weights. Entries
+    // are padded to an even number of taps with zero weights for the SIMD
+    // kernels, which work on tap pairs.
+    struct FilterTaps {
+        std::vector<int> first;
+        std::vector<int> count;
+        std::vector<int16_t> weights;
+        int stride = 0;
+    };
+
+    static FilterTaps computeTaps(int sourceLength, int scaledLength, int targetLength);
+
+    QSize m_sourceSize;
+    QSize m_targetSize;
+    Fit m_fit = Fit::Stretch;
+    FilterTaps m_horizontal;
+    FilterTaps m_vertical;
+    // Source columns read by the horizontal taps
+    int m_firstColumn = 0;
+    int m_endColumn = 0;
+};
+
+#endif // FRAMESCALER_H
@@ -1,5 +1,6 @@
 #include "MainWindow.h"
 #include "PreviewWindow.h"
+#include "VirtualCameraOutputs.h"
 #include "VirtualCameraStreamer.h"
 #include "VirtualCameraSetupDialog.h"
 
@@ -221,6 +222,7 @@ QString describeVirtualCameraServiceState(ServiceInstallState state)
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
+    , m_saveTimer(nullptr)
     , m_previewStateBeforeMinimize(false)
     , m_previewDetached(false)
     , m_widthLocked(false)
@@ -233,7 +235,7 @@ MainWindow::MainWindow(QWidget *parent)
     , m_virtualCameraStatusLabel(nullptr)
     , m_virtualCameraSetupButton(nullptr)
     , m_effectsWidget(nullptr)
-    , m_virtualCameraStreamer(nullptr)
+    , m_virtualCameraOutputs(nullptr)
     , m_isApplyingStyle(false)
     , m_virtualCameraErrorNotified(false)
     , m_virtualCameraAvailable(false)
@@ -244,6 +246,14 @@ MainWindow::MainWindow(QWidget *parent)
     // Create controller
     m_controller = new CameraController(this);
 
+    // A slider drag or a status push changes state many times a second;
+    // write the config once things have been quiet for a moment
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(1500);
+    connect(m_saveTimer, &QTimer::timeout,
+            this, &MainWindow::onStateChangedSaveConfig);
+
     // Connect signals
     connect(m_controller, &CameraController::cameraConnected,
             this, &MainWindow::onCameraConnected);
@@ -254,8 +264,8 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_controller, &CameraController::commandFailed,
             this, &MainWindow::onCommandFailed);
 
-    m_virtualCameraStreamer = new VirtualCameraStreamer(this);
-    connect(m_virtualCameraStreamer, &VirtualCameraStreamer::errorOccurred,
+    m_virtualCameraOutputs = new VirtualCameraOutputs(this);
+    connect(m_virtualCameraOutputs, &VirtualCameraOutputs::errorOccurred,
             this, &MainWindow::onVirtualCameraError);
 
     setupUI();
@@ -274,19 +284,15 @@ MainWindow::MainWindow(QWidget *parent)
         });
     }
 
-    // Start connecting to camera
+    // Start connecting to camera; status then follows the controller's stateChanged
     m_controller->connectToCamera();
-
-    // Update status periodically
-    m_statusTimer = new QTimer(this);
-    connect(m_statusTimer, &QTimer::timeout, this, &MainWindow::updateStatus);
-    m_statusTimer->start(2000);
 }
 
 MainWindow::~MainWindow()
 {
-    // Save config on exit
-    if (m_controller->isConnected()) {
+    // Save config on exit, including a change still waiting for the timer
+    if (m_controller->isConnected() || m_saveTimer->isActive()) {
+        m_saveTimer->stop();
         m_controller->saveConfig();
     }
 }
@@ -337,7 +343,7 @@ void MainWindow::setupUI()
     previewLayout->addWidget(m_previewStack, 1);
 
     m_previewWidget = new CameraPreviewWidget();
-    m_previewWidget->setVirtualCameraStreamer(m_virtualCameraStreamer);
+    m_previewWidget->setVirtualCameraOutputs(m_virtualCameraOutputs);
     m_previewWidget->setControlsVisible(true);
     m_previewWidget->setMinimumSize(320, 240);
 
@@ -974,12 +980,9 @@ void MainWindow::onCameraConnected(const CameraController::CameraInfo &info)
     m_cameraWarningLabel->setVisible(false);
     m_cameraWarningLabel->setText("");
 
-    // Apply current UI state to camera asynchronously (respects user changes before connection)
-    // Use a short delay to let the connection stabilize
-    QTimer::singleShot(100, this, [this]() {
-        auto uiState = getUIState();
-        m_controller->applyCurrentStateToCamera(uiState);
-    });
+    // Apply current UI state to camera (respects user changes before connection).
+    // The controller holds it until its first read of the device is back.
+    m_controller->applyCurrentStateToCamera(getUIState());
 
     updateStatus();
 
@@ -1013,11 +1016,23 @@ void MainWindow::onCameraDisconnected()
     }
 }
 
-void MainWindow::onStateChanged(const CameraController::CameraState &state)
+void MainWindow::onStateChanged(const CameraController::CameraState &state,
+                                CameraController::StateFields changed)
 {
-    // Update all widgets with new state
-    m_trackingWidget->updateFromState(state);
-    m_settingsWidget->updateFromState(state);
+    // Update the widgets showing what changed
+    m_trackingWidget->updateFromState(state, changed);
+    m_settingsWidget->updateFromState(state, changed);
+
+    const CameraController::StateFields statusFields = CameraController::AiModeField |
+        CameraController::ZoomRatioField | CameraController::HdrField |
+        CameraController::FaceAEField | CameraController::AutoFocusField;
+    if (changed & statusFields) {
+        updateStatus();
+    }
+
+    if ((changed & CameraController::PersistedStateFields) && !m_controller->isSettling()) {
+        m_saveTimer->start();
+    }
 }
 
 void MainWindow::onCommandFailed(const QString &description, int errorCode)
@@ -1104,14 +1119,13 @@ void MainWindow::updateVirtualCameraAvailability(const QString &devicePath)
 
 void MainWindow::updateVirtualCameraStreamerState()
 {
-    if (!m_virtualCameraStreamer) {
+    if (!m_virtualCameraOutputs) {
         return;
     }
 
     const QString devicePath = currentVirtualCameraDevicePath();
 
     updateVirtualCameraAvailability(devicePath);
-    m_virtualCameraStreamer->setDevicePath(devicePath);
 
     QString resolutionKey;
     if (m_virtualCameraResolutionCombo && m_virtualCameraResolutionCombo->currentIndex() >= 0) {
@@ -1121,12 +1135,52 @@ void MainWindow::updateVirtualCameraStreamerState()
         resolutionKey = QString::fromStdString(m_controller->getConfig().getSettings().virtualCameraResolution);
     }
     const QSize forcedSize = resolutionSizeForKey(resolutionKey);
-    m_virtualCameraStreamer->setForcedResolution(forcedSize);
+
+    const auto settings = m_controller->getConfig().getSettings();
+    const VirtualCameraStreamer::OutputFormat outputFormat =
+        VirtualCameraStreamer::outputFormatForKey(QString::fromStdString(settings.virtualCameraFormat));
+
+    // The primary device comes first; extra sinks only come from the config file
+    QList<VirtualCameraOutputs::Sink> sinks;
+    VirtualCameraOutputs::Sink primarySink;
+    primarySink.devicePath = devicePath;
+    primarySink.forcedResolution = forcedSize;
+    primarySink.format = outputFormat;
+    sinks.append(primarySink);
+
+    std::vector<Config::VirtualCameraSink> extraSinks;
+    std::string sinkError;
+    if (Config::parseVirtualCameraSinks(settings.virtualCameraExtraSinks, extraSinks, sinkError)) {
+        for (const Config::VirtualCameraSink &extra : extraSinks) {
+            VirtualCameraOutputs::Sink sink;
+            sink.devicePath = QString::fromStdString(extra.device);
+            sink.forcedResolution = resolutionSizeForKey(QString::fromStdString(extra.resolution));
+            sink.format = VirtualCameraStreamer::outputFormatForKey(QString::fromStdString(extra.format));
+            if (sink.devicePath != devicePath) {
+                sinks.append(sink);
+            }
+        }
+    }
+
+    m_virtualCameraOutputs->setSinks(sinks);
+    m_virtualCameraOutputs->setThreadCount(settings.virtualCameraThreads);
+    m_virtualCameraOutputs->setOutputFrameRate(settings.virtualCameraOutputFps);
 
     const bool userRequested = m_virtualCameraCheckbox && m_virtualCameraCheckbox->isChecked();
     const bool previewActive = m_previewWidget && m_previewWidget->isPreviewEnabled();
     const bool enableOutput = userRequested && previewActive && m_virtualCameraAvailable;
-    m_virtualCameraStreamer->setEnabled(enableOutput);
+    m_virtualCameraOutputs->setEnabled(enableOutput);
+
+    if (m_previewWidget) {
+        // The GPU packing pass only produces YUYV at one size, so it is
+        // only used when the primary device is the only sink
+        const bool gpuPacking = enableOutput && settings.virtualCameraGpuConversion &&
+                                outputFormat == VirtualCameraStreamer::OutputFormat::Yuyv &&
+                                sinks.size() == 1;
+        m_previewWidget->setVirtualCameraGpuPacking(gpuPacking, forcedSize);
+        m_previewWidget->setVirtualCameraReadbackLatency(settings.virtualCameraReadbackLatency);
+        m_previewWidget->setVirtualCameraFrameRate(settings.virtualCameraFps);
+    }
 }
 
 void MainWindow::loadConfiguration()
@@ -1159,6 +1213,16 @@ void MainWindow::loadConfiguration()
     m_settingsWidget->setSaturation(settings.saturation);
     m_settingsWidget->setWhiteBalance(settings.whiteBalance);
     m_previewWidget->setPreferredFormatId(QString::fromStdString(settings.previewFormat));
+    m_previewWidget->setPreviewQuality(settings.previewQuality == "full"
+                                           ? CameraPreviewWidget::PreviewQuality::Full
+                                           : CameraPreviewWidget::PreviewQuality::Display);
+    const QString captureDevice = settings.captureDevice == "auto"
+        ? QString()
+        : QString::fromStdString(settings.captureDevice);
+    m_previewWidget->setCaptureBackend(settings.captureBackend == "v4l2"
+                                           ? CameraPreviewWidget::CaptureBackend::V4l2
+                                           : CameraPreviewWidget::CaptureBackend::QtMultimedia,
+                                       captureDevice, settings.captureBuffers);
 
     std::array<PTZControlWidget::PresetState, 3> presetStates{};
     for (int i = 0; i < 3; ++i) {
@@ -1257,7 +1321,7 @@ void MainWindow::handleConfigErrors(const std::vector<Config::ValidationError> &
 
 void MainWindow::onStateChangedSaveConfig()
 {
-    // Debounced auto-save - only save if config saving is enabled
+    // Debounced by m_saveTimer - only save if config saving is enabled
     // This prevents saving during transitional states
     if (m_controller->getConfig().isSavingEnabled()) {
         m_controller->saveConfig();
@@ -1309,14 +1373,7 @@ void MainWindow::changeEvent(QEvent *event)
 
         if (windowState() & Qt::WindowMinimized) {
             // Window is being minimized
-
-            // Save preview state
-            m_previewStateBeforeMinimize = m_previewWidget->isPreviewEnabled();
-
-            // Disable preview if it's on
-            if (m_previewStateBeforeMinimize) {
-                m_previewToggleButton->setChecked(false);
-            }
+            suspendPreviewWhileHidden();
 
             // Disconnect from camera to free resources
             m_controller->disconnectFromCamera();
@@ -1337,6 +1394,19 @@ void MainWindow::changeEvent(QEvent *event)
     }
 }
 
+void MainWindow::suspendPreviewWhileHidden()
+{
+    // Save preview state
+    m_previewStateBeforeMinimize = m_previewWidget->isPreviewEnabled();
+
+    // Disable preview if it's on, unless the virtual camera is streaming from
+    // it: that output renders offscreen and must survive the window going away
+    const bool virtualCameraLive = m_virtualCameraOutputs && m_virtualCameraOutputs->isEnabled();
+    if (m_previewStateBeforeMinimize && !virtualCameraLive) {
+        m_previewToggleButton->setChecked(false);
+    }
+}
+
 void MainWindow::resizeEvent(QResizeEvent *event)
 {
     if (!m_previewDetached && !m_widthLocked) {
@@ -1514,13 +1584,7 @@ void MainWindow::onTrayIconActivated(QSystemTrayIcon::ActivationReason reason)
 void MainWindow::onShowHideAction()
 {
     if (isVisible()) {
-        // Save preview state
-        m_previewStateBeforeMinimize = m_previewWidget->isPreviewEnabled();
-
-        // Disable preview if it's on
-        if (m_previewStateBeforeMinimize) {
-            m_previewToggleButton->setChecked(false);
-        }
+        suspendPreviewWhileHidden();
 
         // Disconnect from camera to free resources
         m_controller->disconnectFromCamera();
@@ -1561,13 +1625,7 @@ void MainWindow::closeEvent(QCloseEvent *event)
     if (settings.startMinimized && m_trayIcon && m_trayIcon->isVisible()) {
         std::cout << "[MainWindow] closeEvent: Minimizing to tray" << std::endl;
         // Minimize to tray instead of closing
-        // Save preview state
-        m_previewStateBeforeMinimize = m_previewWidget->isPreviewEnabled();
-
-        // Disable preview if it's on
-        if (m_previewStateBeforeMinimize) {
-            m_previewToggleButton->setChecked(false);
-        }
+        suspendPreviewWhileHidden();
 
         // Disconnect from camera to free resources
         m_controller->disconnectFromCamera();
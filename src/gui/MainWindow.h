@@ -24,7 +24,7 @@ class QFrame;
 class QWidget;
 class QLineEdit;
 class QComboBox;
-class VirtualCameraStreamer;
+class VirtualCameraOutputs;
 
 /**
  * @brief Main application window
@@ -42,7 +42,7 @@ public:
 private slots:
     void onCameraConnected(const CameraController::CameraInfo &info);
     void onCameraDisconnected();
-    void onStateChanged(const CameraController::CameraState &state);
+    void onStateChanged(const CameraController::CameraState &state, CameraController::StateFields changed);
     void onCommandFailed(const QString &description, int errorCode);
     void updateStatus();
     void onStateChangedSaveConfig();
@@ -80,9 +80,11 @@ private:
     QString currentVirtualCameraDevicePath() const;
     void updateVirtualCameraAvailability(const QString &devicePath);
     void updateVirtualCameraStreamerState();
+    void suspendPreviewWhileHidden();
 
     // Controller
     CameraController *m_controller;
+    QTimer *m_saveTimer;  // Single shot; restarted on each persisted change
 
     // UI
     QPushButton *m_previewToggleButton;
@@ -114,10 +116,7 @@ private:
     VideoEffectsWidget *m_effectsWidget;
     CameraPreviewWidget *m_previewWidget;
     PreviewWindow *m_previewWindow;
-    VirtualCameraStreamer *m_virtualCameraStreamer;
-
-    // Status timer
-    QTimer *m_statusTimer;
+    VirtualCameraOutputs *m_virtualCameraOutputs;
 
     // Track preview state before minimize
     bool m_previewStateBeforeMinimize;
@@ -0,0 +1,243 @@
+#include "MjpegDecoder.h"
+
+#include <QLoggingCategory>
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <vector>
+
+#include <jpeglib.h>
+
+namespace {
+
+Q_LOGGING_CATEGORY(MjpegLog, "obsbot.mjpeg")
+
+// Plane rows are padded to whole DCT blocks anyway; keep them and the planes
+// aligned so uploads and any later SIMD pass read aligned memory
+constexpr int kRowAlignment = 16;
+constexpr size_t kPlaneAlignment = 64;
+
+struct ErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+};
+
+void handleError(j_common_ptr cinfo)
+{
+    char message[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, message);
+    qCDebug(MjpegLog) << "MJPEG decode failed:" << message;
+    longjmp(reinterpret_cast<ErrorManager *>(cinfo->err)->jump, 1);
+}
+
+void handleMessage(j_common_ptr cinfo)
+{
+    // Warnings such as stray bytes before a marker are routine for webcams
+    char message[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, message);
+    qCDebug(MjpegLog) << message;
+}
+
+int scaledBlockSize(const jpeg_component_info &component)
+{
+#if JPEG_LIB_VERSION >= 70
+    return component.DCT_v_scaled_size;
+#else
+    return component.DCT_scaled_size;
+#endif
+}
+
+int minScaledBlockSize(const jpeg_decompress_struct &cinfo)
+{
+#if JPEG_LIB_VERSION >= 70
+    return cinfo.min_DCT_v_scaled_size;
+#else
+    return cinfo.min_DCT_scaled_size;
+#endif
+}
+
+int alignUp(int value, int alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Largest IDCT reduction whose output still covers maxSize
+int scaleDenominator(int width, int height, const QSize &maxSize)
+{
+    if (!maxSize.isValid()) {
+        return 1;
+    }
+
+    int denominator = 1;
+    while (denominator < 8) {
+        const int next = denominator * 2;
+        if ((width + next - 1) / next < maxSize.width() ||
+            (height + next - 1) / next < maxSize.height()) {
+            break;
+        }
+        denominator = next;
+    }
+    return denominator;
+}
+
+} // namespace
+
+// libjpeg reports errors by longjmp, so the functions that call into it only
+// hold plain data on the stack; everything with a destructor lives outside
+struct MjpegDecoder::State {
+    jpeg_decompress_struct cinfo;
+    ErrorManager error;
+    std::array<std::vector<JSAMPROW>, 3> rows;
+
+    State()
+    {
+        cinfo.err = jpeg_std_error(&error.base);
+        error.base.error_exit = handleError;
+        error.base.output_message = handleMessage;
+        jpeg_create_decompress(&cinfo);
+    }
+
+    ~State()
+    {
+        jpeg_destroy_decompress(&cinfo);
+    }
+
+    bool start(const uchar *data, size_t size, const QSize &maxSize)
+    {
+        if (setjmp(error.jump)) {
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+
+        jpeg_mem_src(&cinfo, const_cast<uchar *>(data), static_cast<unsigned long>(size));
+        if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+        if (!hasPlanarLayout()) {
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+
+        cinfo.raw_data_out = TRUE;
+        cinfo.dct_method = JDCT_IFAST;
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = static_cast<unsigned int>(
+            scaleDenominator(static_cast<int>(cinfo.image_width),
+                             static_cast<int>(cinfo.image_height), maxSize));
+        jpeg_start_decompress(&cinfo);
+        return true;
+    }
+
+    bool hasPlanarLayout() const
+    {
+        if (cinfo.num_components != 3 || cinfo.jpeg_color_space != JCS_YCbCr) {
+            return false;
+        }
+        const jpeg_component_info &luma = cinfo.comp_info[0];
+        if (luma.h_samp_factor > 2 || luma.v_samp_factor > 2) {
+            return false;
+        }
+        for (int i = 1; i < 3; ++i) {
+            if (cinfo.comp_info[i].h_samp_factor != 1 || cinfo.comp_info[i].v_samp_factor != 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Rows one jpeg_read_raw_data() call writes for a component
+    int rowsPerPass(int component) const
+    {
+        const jpeg_component_info &info = cinfo.comp_info[component];
+        return info.v_samp_factor * scaledBlockSize(info);
+    }
+
+    // The IDCT writes whole blocks, so rows are padded past the visible width
+    int planeStride(int component) const
+    {
+        const jpeg_component_info &info = cinfo.comp_info[component];
+        return alignUp(static_cast<int>(info.width_in_blocks) * scaledBlockSize(info), kRowAlignment);
+    }
+
+    int planeRows(int component) const
+    {
+        return static_cast<int>(cinfo.total_iMCU_rows) * rowsPerPass(component);
+    }
+
+    bool readPlanes(uchar *base, const size_t *offsets, const int *strides)
+    {
+        if (setjmp(error.jump)) {
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+
+        JSAMPARRAY planes[3];
+        for (int i = 0; i < 3; ++i) {
+            planes[i] = rows[static_cast<size_t>(i)].data();
+        }
+
+        const int linesPerPass = cinfo.max_v_samp_factor * minScaledBlockSize(cinfo);
+        for (JDIMENSION row = 0; row < cinfo.total_iMCU_rows; ++row) {
+            for (int i = 0; i < 3; ++i) {
+                const int passRows = rowsPerPass(i);
+                uchar *first = base + offsets[i] +
+                               static_cast<size_t>(row) * static_cast<size_t>(passRows) *
+                                   static_cast<size_t>(strides[i]);
+                for (int r = 0; r < passRows; ++r) {
+                    planes[i][r] = first + static_cast<size_t>(r) * static_cast<size_t>(strides[i]);
+                }
+            }
+            if (jpeg_read_raw_data(&cinfo, planes, static_cast<JDIMENSION>(linesPerPass)) == 0) {
+                // Suspension cannot happen with a memory source; treat it as corrupt
+                jpeg_abort_decompress(&cinfo);
+                return false;
+            }
+        }
+
+        jpeg_finish_decompress(&cinfo);
+        return true;
+    }
+};
+
+MjpegDecoder::MjpegDecoder()
+    : m_state(std::make_unique<State>())
+{
+}
+
+MjpegDecoder::~MjpegDecoder() = default;
+
+MjpegDecoder::Frame MjpegDecoder::decode(const uchar *data, size_t size, const QSize &maxSize)
+{
+    if (!data || size == 0 || !m_state->start(data, size, maxSize)) {
+        return Frame();
+    }
+
+    const jpeg_decompress_struct &cinfo = m_state->cinfo;
+    Frame frame;
+    frame.size = QSize(static_cast<int>(cinfo.output_width), static_cast<int>(cinfo.output_height));
+    frame.chromaSize = QSize(static_cast<int>(cinfo.comp_info[1].downsampled_width),
+                             static_cast<int>(cinfo.comp_info[1].downsampled_height));
+
+    size_t totalBytes = 0;
+    for (int i = 0; i < 3; ++i) {
+        const size_t index = static_cast<size_t>(i);
+        frame.stride[index] = m_state->planeStride(i);
+        frame.offset[index] = totalBytes;
+        const size_t planeBytes = static_cast<size_t>(frame.stride[index]) *
+                                  static_cast<size_t>(m_state->planeRows(i));
+        totalBytes += (planeBytes + kPlaneAlignment - 1) / kPlaneAlignment * kPlaneAlignment;
+        m_state->rows[index].resize(static_cast<size_t>(m_state->rowsPerPass(i)));
+    }
+
+    frame.data = FramePool::instance().acquire(static_cast<qsizetype>(totalBytes));
+    if (frame.data.isNull()) {
+        jpeg_abort_decompress(&m_state->cinfo);
+        return Frame();
+    }
+
+    if (!m_state->readPlanes(frame.data.data(), frame.offset.data(), frame.stride.data())) {
+        return Frame();
+    }
+    return frame;
+}
@@ -0,0 +1,55 @@
+#ifndef MJPEGDECODER_H
+#define MJPEGDECODER_H
+
+#include <QSize>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include "FramePool.h"
+
+/**
+ * @brief Decodes camera MJPEG frames straight to planar YCbCr with libjpeg-turbo.
+ *
+ * The decoder skips colour conversion and upsampling altogether: it reads
+ * the raw Y, Cb and Cr planes out of the IDCT into one pooled buffer, ready
+ * to be uploaded as textures and converted in the effects shader. When a
+ * maximum size is given, the IDCT itself scales by 1/2, 1/4 or 1/8 as long
+ * as the result still covers it, which is far cheaper than decoding the
+ * full frame and scaling afterwards.
+ *
+ * Only 3-component YCbCr JPEGs with chroma subsampled at most 2x in each
+ * direction are handled, which covers UVC cameras; decode() returns
+ * a null frame for anything else and for data libjpeg rejects, so the
+ * caller can fall back to Qt. The chroma planes may come out larger than
+ * the subsampling suggests when the IDCT scales chroma up for free, so
+ * consumers should go by chromaSize. Not thread-safe; the libjpeg state is
+ * reused between frames.
+ */
+class MjpegDecoder
+{
+public:
+    struct Frame {
+        QSize size;                       // Luma size after DCT scaling
+        QSize chromaSize;                 // Size of the Cb and Cr planes
+        FrameBuffer data;                 // All three planes, pooled
+        std::array<size_t, 3> offset{};   // Start of each plane in data
+        std::array<int, 3> stride{};      // Bytes per row of each plane
+
+        bool isNull() const { return data.isNull() || size.isEmpty(); }
+        const uchar *plane(int index) const { return data.constData() + offset[static_cast<size_t>(index)]; }
+    };
+
+    MjpegDecoder();
+    ~MjpegDecoder();
+    MjpegDecoder(const MjpegDecoder &) = delete;
+    MjpegDecoder &operator=(const MjpegDecoder &) = delete;
+
+    // An invalid maxSize decodes at full resolution
+    Frame decode(const uchar *data, size_t size, const QSize &maxSize = QSize());
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+};
+
+#endif // MJPEGDECODER_H
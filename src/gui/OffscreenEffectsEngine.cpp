@@ -0,0 +1,695 @@
+#include "OffscreenEffectsEngine.h"
+
+#include "FrameClock.h"
+
+#include <QLoggingCategory>
+#include <QMetaObject>
+#include <QMetaType>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QSurfaceFormat>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <array>
+
+Q_LOGGING_CATEGORY(OffscreenEffectsLog, "obsbot.effects")
+
+namespace {
+
+// The effect shaders target GLSL 330 core
+QSurfaceFormat offscreenFormat()
+{
+    QSurfaceFormat format;
+    format.setRenderableType(QSurfaceFormat::OpenGL);
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    return format;
+}
+
+} // namespace
+
+// Hands processed frames from the worker's context to the preview widget's.
+// The textures and sync objects belong to the global share group; the mutex
+// only guards which slot is published and which one the widget is sampling.
+// The worker never writes either of those, so three slots always leave it
+// one to render into.
+class DisplayFrameExchange
+{
+public:
+    enum class Sharing {
+        Unknown,     // Worker not initialized yet
+        Shared,
+        Unavailable
+    };
+
+    struct Slot {
+        GLuint texture = 0;
+        QSize size;
+        GLsync renderFence = nullptr;   // Worker's copy into the texture
+        GLsync displayFence = nullptr;  // Widget's last draw from the texture
+    };
+
+    static constexpr int kSlotCount = 3;
+
+    QMutex mutex;
+    std::array<Slot, kSlotCount> displaySlots;
+    int published = -1;
+    int displayed = -1;
+    Sharing sharing = Sharing::Unknown;
+};
+
+class OffscreenEffectsWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    OffscreenEffectsWorker(QOffscreenSurface *surface, DisplayFrameExchange *exchange)
+        : m_surface(surface)
+        , m_exchange(exchange)
+        , m_context(nullptr)
+        , m_engine(new VideoEffectsEngine(this))
+        , m_clock(nullptr)
+        , m_targetFrameRate(0)
+        , m_pendingCaptureTimeUs(0)
+        , m_frameDriven(true)
+        , m_renderScheduled(false)
+        , m_ready(false)
+    {
+        connect(m_engine, &VideoEffectsEngine::processedFrameReady,
+                this, &OffscreenEffectsWorker::processedFrameReady);
+        connect(m_engine, &VideoEffectsEngine::packedFrameReady,
+                this, &OffscreenEffectsWorker::packedFrameReady);
+    }
+
+    ~OffscreenEffectsWorker() override
+    {
+        shutdown();
+    }
+
+    // Called from the GUI thread. A frame that has not been rendered yet is
+    // replaced rather than queued behind, so a slow GPU drops frames instead
+    // of building up latency. With a target frame rate the clock picks the
+    // frame up on its next tick.
+    void queueFrame(const QVideoFrame &frame, qint64 captureTimeUs)
+    {
+        QMutexLocker locker(&m_frameMutex);
+        m_pendingFrame = frame;
+        m_pendingCaptureTimeUs = captureTimeUs;
+        if (!m_frameDriven || m_renderScheduled) {
+            return;
+        }
+        m_renderScheduled = true;
+        locker.unlock();
+
+        QMetaObject::invokeMethod(this, &OffscreenEffectsWorker::renderPendingFrame, Qt::QueuedConnection);
+    }
+
+public slots:
+    void initialize()
+    {
+        // Share with the preview widget so it can sample our output directly
+        QOpenGLContext *shareContext = QOpenGLContext::globalShareContext();
+
+        m_context = new QOpenGLContext(this);
+        m_context->setFormat(m_surface->format());
+        m_context->setShareContext(shareContext);
+        if (!m_context->create()) {
+            emit initializationFailed(tr("Could not create an OpenGL context for video effects"));
+            return;
+        }
+        if (!m_context->makeCurrent(m_surface)) {
+            emit initializationFailed(tr("Could not activate the OpenGL context for video effects"));
+            return;
+        }
+        if (!m_engine->initialize()) {
+            m_context->doneCurrent();
+            emit initializationFailed(tr("Could not initialize the video effects pipeline"));
+            return;
+        }
+
+        const bool shared = shareContext && m_context->shareContext();
+        if (!shared) {
+            qCWarning(OffscreenEffectsLog) << "Offscreen effects context is not shared with the preview;"
+                                           << "the preview renders its own frames";
+        }
+        {
+            QMutexLocker locker(&m_exchange->mutex);
+            m_exchange->sharing = shared ? DisplayFrameExchange::Sharing::Shared
+                                         : DisplayFrameExchange::Sharing::Unavailable;
+        }
+
+        m_clock = new QTimer(this);
+        m_clock->setSingleShot(true);
+        m_clock->setTimerType(Qt::PreciseTimer);
+        connect(m_clock, &QTimer::timeout, this, &OffscreenEffectsWorker::processClockTick);
+
+        m_ready = true;
+        restartClock();
+        qCDebug(OffscreenEffectsLog) << "Offscreen effects renderer:"
+                                     << reinterpret_cast<const char *>(
+                                            m_context->functions()->glGetString(GL_RENDERER));
+    }
+
+    void shutdown()
+    {
+        m_ready = false;
+        if (m_clock) {
+            m_clock->stop();
+        }
+        if (!m_context) {
+            return;
+        }
+
+        std::array<GLsync, DisplayFrameExchange::kSlotCount * 2> fences{};
+        {
+            QMutexLocker locker(&m_exchange->mutex);
+            for (int i = 0; i < DisplayFrameExchange::kSlotCount; ++i) {
+                DisplayFrameExchange::Slot &slot = m_exchange->displaySlots[i];
+                fences[i * 2] = slot.renderFence;
+                fences[i * 2 + 1] = slot.displayFence;
+                slot = DisplayFrameExchange::Slot();
+            }
+            m_exchange->published = -1;
+            m_exchange->displayed = -1;
+            m_exchange->sharing = DisplayFrameExchange::Sharing::Unavailable;
+        }
+
+        if (m_context->makeCurrent(m_surface)) {
+            QOpenGLExtraFunctions *gl = m_context->extraFunctions();
+            for (GLsync fence : fences) {
+                if (fence) {
+                    gl->glDeleteSync(fence);
+                }
+            }
+            for (auto &framebuffer : m_displayFramebuffers) {
+                framebuffer.reset();
+            }
+            m_engine->cleanup();
+            m_context->doneCurrent();
+        }
+        for (auto &framebuffer : m_displayFramebuffers) {
+            framebuffer.reset();
+        }
+        delete m_context;
+        m_context = nullptr;
+    }
+
+    void setReadbackEnabled(bool enabled)
+    {
+        m_engine->setReadbackEnabled(enabled);
+    }
+
+    void setVideoEffects(const VideoEffectsEngine::VideoEffectsSettings &settings)
+    {
+        m_engine->setVideoEffects(settings);
+    }
+
+    void setGpuPacking(bool enabled, const QSize &targetSize)
+    {
+        m_engine->setGpuPacking(enabled, targetSize);
+    }
+
+    void setReadbackLatency(int frames)
+    {
+        m_engine->setReadbackLatency(frames);
+    }
+
+    void setMaxDecodeSize(const QSize &size)
+    {
+        m_engine->setMaxDecodeSize(size);
+    }
+
+    void setMaxRenderSize(const QSize &size)
+    {
+        m_engine->setMaxRenderSize(size);
+    }
+
+    void setDisplaySize(const QSize &size)
+    {
+        m_displaySize = size;
+    }
+
+    void setTargetFrameRate(int fps)
+    {
+        {
+            QMutexLocker locker(&m_frameMutex);
+            m_frameDriven = fps <= 0;
+        }
+        m_targetFrameRate = std::max(0, fps);
+        restartClock();
+    }
+
+signals:
+    void processedFrameReady(const QImage &frame, qint64 captureTimeUs);
+    void packedFrameReady(const PackedFrame &frame);
+    void displayFrameReady();
+    void initializationFailed(const QString &message);
+
+private:
+    QVideoFrame takePendingFrame(qint64 &captureTimeUs)
+    {
+        QMutexLocker locker(&m_frameMutex);
+        QVideoFrame frame = m_pendingFrame;
+        captureTimeUs = m_pendingCaptureTimeUs;
+        m_pendingFrame = QVideoFrame();
+        m_renderScheduled = false;
+        return frame;
+    }
+
+    void renderPendingFrame()
+    {
+        qint64 captureTimeUs = 0;
+        const QVideoFrame frame = takePendingFrame(captureTimeUs);
+        if (frame.isValid()) {
+            renderFrame(frame, captureTimeUs);
+        }
+    }
+
+    void renderFrame(const QVideoFrame &frame, qint64 captureTimeUs)
+    {
+        if (!m_ready) {
+            return;
+        }
+
+        // The context only ever lives on this thread, so it stays current
+        // between frames and this is cheap
+        if (!m_context->makeCurrent(m_surface)) {
+            qCWarning(OffscreenEffectsLog) << "Failed to make offscreen effects context current";
+            return;
+        }
+
+        m_engine->setFrame(frame, captureTimeUs);
+        if (m_engine->render()) {
+            publishDisplayFrame();
+        }
+    }
+
+    // Copy the new output into a slot the widget is not reading and publish
+    // it. Both sides only queue GPU-side waits on each other's fences.
+    void publishDisplayFrame()
+    {
+        int index = -1;
+        GLsync displayFence = nullptr;
+        GLsync renderFence = nullptr;
+        {
+            QMutexLocker locker(&m_exchange->mutex);
+            if (m_exchange->sharing != DisplayFrameExchange::Sharing::Shared) {
+                return;
+            }
+            for (int i = 0; i < DisplayFrameExchange::kSlotCount; ++i) {
+                if (i != m_exchange->published && i != m_exchange->displayed) {
+                    index = i;
+                    break;
+                }
+            }
+            DisplayFrameExchange::Slot &slot = m_exchange->displaySlots[index];
+            std::swap(displayFence, slot.displayFence);
+            std::swap(renderFence, slot.renderFence);
+        }
+
+        QOpenGLExtraFunctions *gl = m_context->extraFunctions();
+        if (displayFence) {
+            gl->glWaitSync(displayFence, 0, GL_TIMEOUT_IGNORED);
+            gl->glDeleteSync(displayFence);
+        }
+        if (renderFence) {
+            gl->glDeleteSync(renderFence);
+        }
+
+        std::unique_ptr<QOpenGLFramebufferObject> &framebuffer = m_displayFramebuffers[index];
+        if (!m_engine->copyOutput(framebuffer, m_displaySize)) {
+            return;
+        }
+        const GLsync fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // A fence only signals once its context has flushed it
+        gl->glFlush();
+
+        {
+            QMutexLocker locker(&m_exchange->mutex);
+            DisplayFrameExchange::Slot &slot = m_exchange->displaySlots[index];
+            slot.texture = framebuffer->texture();
+            slot.size = framebuffer->size();
+            slot.renderFence = fence;
+            m_exchange->published = index;
+        }
+        emit displayFrameReady();
+    }
+
+    void restartClock()
+    {
+        if (!m_clock) {
+            return;
+        }
+
+        m_clock->stop();
+        if (m_targetFrameRate <= 0) {
+            return;
+        }
+        m_clockSchedule.start(m_targetFrameRate);
+        m_clock->start(m_clockSchedule.nextDelayMs());
+    }
+
+    // A tick without a new frame does nothing: the virtual camera paces its
+    // own output and repeats frames itself, with the right timestamps
+    void processClockTick()
+    {
+        qint64 captureTimeUs = 0;
+        const QVideoFrame frame = takePendingFrame(captureTimeUs);
+        if (frame.isValid()) {
+            renderFrame(frame, captureTimeUs);
+        }
+        m_clock->start(m_clockSchedule.nextDelayMs());
+    }
+
+    QOffscreenSurface *m_surface;
+    DisplayFrameExchange *m_exchange;
+    QOpenGLContext *m_context;
+    VideoEffectsEngine *m_engine;
+    std::array<std::unique_ptr<QOpenGLFramebufferObject>, DisplayFrameExchange::kSlotCount> m_displayFramebuffers;
+    QSize m_displaySize;            // Display copies are shrunk to fit; invalid keeps the output size
+    QTimer *m_clock;
+    FrameClock::TickSchedule m_clockSchedule;
+    int m_targetFrameRate;
+    QMutex m_frameMutex;
+    QVideoFrame m_pendingFrame;
+    qint64 m_pendingCaptureTimeUs;
+    bool m_frameDriven;             // Guarded by m_frameMutex
+    bool m_renderScheduled;
+    bool m_ready;
+};
+
+OffscreenEffectsEngine::OffscreenEffectsEngine(QObject *parent)
+    : QObject(parent)
+    , m_effectSettings(VideoEffectsEngine::VideoEffectsSettings::defaults())
+    , m_readbackEnabled(false)
+    , m_gpuPackingEnabled(false)
+    , m_readbackLatency(1)
+    , m_targetFrameRate(0)
+    , m_displayExchange(std::make_unique<DisplayFrameExchange>())
+    , m_surface(nullptr)
+    , m_workerThread(nullptr)
+    , m_worker(nullptr)
+    , m_workerInitialized(false)
+    , m_workerFailed(false)
+{
+    qRegisterMetaType<PackedFrame>("PackedFrame");
+}
+
+OffscreenEffectsEngine::~OffscreenEffectsEngine()
+{
+    if (m_workerInitialized && m_workerThread && m_worker) {
+        QMetaObject::invokeMethod(m_worker, &OffscreenEffectsWorker::shutdown, Qt::BlockingQueuedConnection);
+        m_workerThread->quit();
+        m_workerThread->wait();
+        m_worker = nullptr;
+        m_workerThread = nullptr;
+        m_workerInitialized = false;
+    }
+
+    // Created on the GUI thread, so destroyed here too, after the context is gone
+    delete m_surface;
+    m_surface = nullptr;
+}
+
+void OffscreenEffectsEngine::setVideoEffects(const VideoEffectsEngine::VideoEffectsSettings &settings)
+{
+    if (m_effectSettings == settings) {
+        return;
+    }
+
+    m_effectSettings = settings;
+    if (!m_workerInitialized) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, settings]() {
+            worker->setVideoEffects(settings);
+        },
+        Qt::QueuedConnection);
+}
+
+void OffscreenEffectsEngine::setReadbackEnabled(bool enabled)
+{
+    if (m_readbackEnabled == enabled) {
+        return;
+    }
+
+    m_readbackEnabled = enabled;
+    if (!m_workerInitialized) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, enabled]() {
+            worker->setReadbackEnabled(enabled);
+        },
+        Qt::QueuedConnection);
+}
+
+void OffscreenEffectsEngine::setGpuPacking(bool enabled, const QSize &targetSize)
+{
+    m_gpuPackingEnabled = enabled;
+    m_packedTargetSize = targetSize;
+    if (!m_workerInitialized) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, enabled, targetSize]() {
+            worker->setGpuPacking(enabled, targetSize);
+        },
+        Qt::QueuedConnection);
+}
+
+void OffscreenEffectsEngine::setReadbackLatency(int frames)
+{
+    m_readbackLatency = frames;
+    if (!m_workerInitialized) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, frames]() {
+            worker->setReadbackLatency(frames);
+        },
+        Qt::QueuedConnection);
+}
+
+void OffscreenEffectsEngine::setMaxDecodeSize(const QSize &size)
+{
+    if (m_maxDecodeSize == size) {
+        return;
+    }
+
+    m_maxDecodeSize = size;
+    if (!m_workerInitialized) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, size]() {
+            worker->setMaxDecodeSize(size);
+        },
+        Qt::QueuedConnection);
+}
+
+void OffscreenEffectsEngine::setMaxRenderSize(const QSize &size)
+{
+    if (m_maxRenderSize == size) {
+        return;
+    }
+
+    m_maxRenderSize = size;
+    if (!m_workerInitialized) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, size]() {
+            worker->setMaxRenderSize(size);
+        },
+        Qt::QueuedConnection);
+}
+
+void OffscreenEffectsEngine::setDisplaySize(const QSize &size)
+{
+    if (m_displaySize == size) {
+        return;
+    }
+
+    m_displaySize = size;
+    if (!m_workerInitialized) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, size]() {
+            worker->setDisplaySize(size);
+        },
+        Qt::QueuedConnection);
+}
+
+void OffscreenEffectsEngine::setTargetFrameRate(int fps)
+{
+    if (m_targetFrameRate == fps) {
+        return;
+    }
+
+    m_targetFrameRate = fps;
+    if (!m_workerInitialized) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, fps]() {
+            worker->setTargetFrameRate(fps);
+        },
+        Qt::QueuedConnection);
+}
+
+void OffscreenEffectsEngine::submitFrame(const QVideoFrame &frame, qint64 captureTimeUs)
+{
+    if (!frame.isValid() || !ensureWorker()) {
+        return;
+    }
+
+    // The time travels with the frame to the virtual camera
+    m_worker->queueFrame(frame, captureTimeUs > 0 ? captureTimeUs : FrameClock::nowUs());
+}
+
+bool OffscreenEffectsEngine::isDisplayAvailable() const
+{
+    if (m_workerFailed) {
+        return false;
+    }
+
+    // Until the worker has created its context, assume sharing will work
+    QMutexLocker locker(&m_displayExchange->mutex);
+    return m_displayExchange->sharing != DisplayFrameExchange::Sharing::Unavailable;
+}
+
+bool OffscreenEffectsEngine::acquireDisplayFrame(GLuint &texture, QSize &size)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context || m_workerFailed) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_displayExchange->mutex);
+    if (m_displayExchange->sharing != DisplayFrameExchange::Sharing::Shared ||
+        m_displayExchange->published < 0) {
+        return false;
+    }
+
+    const DisplayFrameExchange::Slot &slot = m_displayExchange->displaySlots[m_displayExchange->published];
+    // Makes the GPU, not this thread, wait for the worker's copy
+    context->extraFunctions()->glWaitSync(slot.renderFence, 0, GL_TIMEOUT_IGNORED);
+    m_displayExchange->displayed = m_displayExchange->published;
+    texture = slot.texture;
+    size = slot.size;
+    return true;
+}
+
+void OffscreenEffectsEngine::releaseDisplayFrame()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context) {
+        return;
+    }
+
+    QMutexLocker locker(&m_displayExchange->mutex);
+    if (m_displayExchange->displayed < 0) {
+        return;
+    }
+
+    // The worker waits on this before it overwrites the texture
+    QOpenGLExtraFunctions *gl = context->extraFunctions();
+    DisplayFrameExchange::Slot &slot = m_displayExchange->displaySlots[m_displayExchange->displayed];
+    if (slot.displayFence) {
+        gl->glDeleteSync(slot.displayFence);
+    }
+    slot.displayFence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    gl->glFlush();
+    m_displayExchange->displayed = -1;
+}
+
+void OffscreenEffectsEngine::handleWorkerInitializationFailed(const QString &message)
+{
+    // The thread stays up until destruction; frames just stop going to it
+    m_workerFailed = true;
+    emit errorOccurred(message);
+}
+
+bool OffscreenEffectsEngine::ensureWorker()
+{
+    if (m_workerFailed) {
+        return false;
+    }
+    if (m_workerInitialized) {
+        return true;
+    }
+
+    if (!QOpenGLContext::supportsThreadedOpenGL()) {
+        m_workerFailed = true;
+        emit errorOccurred(tr("This OpenGL platform cannot render video effects on a worker thread"));
+        return false;
+    }
+
+    // QOffscreenSurface must be created on the GUI thread; the context that
+    // renders to it is created on the worker
+    m_surface = new QOffscreenSurface();
+    m_surface->setFormat(offscreenFormat());
+    m_surface->create();
+    if (!m_surface->isValid()) {
+        delete m_surface;
+        m_surface = nullptr;
+        m_workerFailed = true;
+        emit errorOccurred(tr("Could not create an offscreen surface for video effects"));
+        return false;
+    }
+
+    m_workerThread = new QThread(this);
+    m_worker = new OffscreenEffectsWorker(m_surface, m_displayExchange.get());
+    m_worker->moveToThread(m_workerThread);
+    connect(m_worker, &OffscreenEffectsWorker::processedFrameReady,
+            this, &OffscreenEffectsEngine::processedFrameReady);
+    connect(m_worker, &OffscreenEffectsWorker::packedFrameReady,
+            this, &OffscreenEffectsEngine::packedFrameReady);
+    connect(m_worker, &OffscreenEffectsWorker::displayFrameReady,
+            this, &OffscreenEffectsEngine::displayFrameReady);
+    connect(m_worker, &OffscreenEffectsWorker::initializationFailed,
+            this, &OffscreenEffectsEngine::handleWorkerInitializationFailed);
+    connect(m_workerThread, &QThread::finished,
+            m_worker, &QObject::deleteLater);
+
+    m_workerThread->setObjectName(QStringLiteral("OffscreenEffects"));
+    m_workerThread->start();
+    m_workerInitialized = true;
+
+    const VideoEffectsEngine::VideoEffectsSettings settingsCopy = m_effectSettings;
+    const bool readbackCopy = m_readbackEnabled;
+    const bool packingCopy = m_gpuPackingEnabled;
+    const QSize targetSizeCopy = m_packedTargetSize;
+    const int latencyCopy = m_readbackLatency;
+    const QSize decodeSizeCopy = m_maxDecodeSize;
+    const QSize renderSizeCopy = m_maxRenderSize;
+    const QSize displaySizeCopy = m_displaySize;
+    const int frameRateCopy = m_targetFrameRate;
+
+    QMetaObject::invokeMethod(m_worker, &OffscreenEffectsWorker::initialize, Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, settingsCopy, readbackCopy, packingCopy, targetSizeCopy, latencyCopy,
+         decodeSizeCopy, renderSizeCopy, displaySizeCopy, frameRateCopy]() {
+            worker->setVideoEffects(settingsCopy);
+            worker->setReadbackEnabled(readbackCopy);
+            worker->setGpuPacking(packingCopy, targetSizeCopy);
+            worker->setReadbackLatency(latencyCopy);
+            worker->setMaxDecodeSize(decodeSizeCopy);
+            worker->setMaxRenderSize(renderSizeCopy);
+            worker->setDisplaySize(displaySizeCopy);
+            worker->setTargetFrameRate(frameRateCopy);
+        },
+        Qt::QueuedConnection);
+    return true;
+}
+
+#include "OffscreenEffectsEngine.moc"
@@ -0,0 +1,108 @@
+#ifndef OFFSCREENEFFECTSENGINE_H
+#define OFFSCREENEFFECTSENGINE_H
+
+#include <QObject>
+#include <QImage>
+#include <QOpenGLFunctions>
+#include <QSize>
+#include <QString>
+#include <QVideoFrame>
+#include <memory>
+#include "PackedFrame.h"
+#include "VideoEffectsEngine.h"
+
+class QOffscreenSurface;
+class QThread;
+class OffscreenEffectsWorker;
+class DisplayFrameExchange;
+
+/**
+ * @brief Runs the video effects pipeline on its own thread, without a window.
+ *
+ * The worker owns a private OpenGL 3.3 core context on a QOffscreenSurface
+ * and drives a VideoEffectsEngine. It is the pipeline for both outputs:
+ * processed frames are read back for the virtual camera, and the preview
+ * widget samples the latest result through a texture shared with its own
+ * context (Qt::AA_ShareOpenGLContexts), so neither output waits on the other
+ * or on widget repaints. Any platform with offscreen GL works, including
+ * surfaceless EGL on Mesa llvmpipe.
+ *
+ * By default every captured frame is processed as soon as the worker is
+ * free, and only the newest frame is kept when rendering falls behind. With
+ * a target frame rate the worker runs its own clock instead: each tick
+ * processes the newest frame, if one arrived since the last tick. Repeating
+ * frames to hold an output rate is left to the consumer.
+ */
+class OffscreenEffectsEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OffscreenEffectsEngine(QObject *parent = nullptr);
+    ~OffscreenEffectsEngine() override;
+
+    void setVideoEffects(const VideoEffectsEngine::VideoEffectsSettings &settings);
+    void setReadbackEnabled(bool enabled);
+    void setGpuPacking(bool enabled, const QSize &targetSize);
+    void setReadbackLatency(int frames);
+
+    // Largest size MJPEG frames need to be decoded at; invalid decodes in full
+    void setMaxDecodeSize(const QSize &size);
+
+    // Largest size the effect passes run at (see VideoEffectsEngine); only
+    // safe to limit while nothing reads back full-resolution frames
+    void setMaxRenderSize(const QSize &size);
+
+    // Device-pixel size of the preview. Published display frames are
+    // shrunk to fit it; invalid publishes them at the rendered size.
+    void setDisplaySize(const QSize &size);
+
+    // Frames per second of the pipeline clock; 0 follows the camera
+    void setTargetFrameRate(int fps);
+
+    // Queue a camera frame for processing; starts the worker on first use.
+    // A captureTimeUs of 0 stamps the frame on arrival.
+    void submitFrame(const QVideoFrame &frame, qint64 captureTimeUs = 0);
+
+    // False once the worker failed to start; callers render frames themselves
+    bool isAvailable() const { return !m_workerFailed; }
+
+    // False when the worker's textures cannot be shared with the widget
+    bool isDisplayAvailable() const;
+
+    // Display side, called on the GUI thread with a context of the global
+    // share group current. A successful acquire must be paired with a
+    // release once the draw calls sampling the texture have been issued.
+    bool acquireDisplayFrame(GLuint &texture, QSize &size);
+    void releaseDisplayFrame();
+
+signals:
+    void processedFrameReady(const QImage &frame, qint64 captureTimeUs);
+    void packedFrameReady(const PackedFrame &frame);
+    void displayFrameReady();
+    void errorOccurred(const QString &message);
+
+private slots:
+    void handleWorkerInitializationFailed(const QString &message);
+
+private:
+    bool ensureWorker();
+
+    VideoEffectsEngine::VideoEffectsSettings m_effectSettings;
+    bool m_readbackEnabled;
+    bool m_gpuPackingEnabled;
+    QSize m_packedTargetSize;
+    int m_readbackLatency;
+    QSize m_maxDecodeSize;
+    QSize m_maxRenderSize;
+    QSize m_displaySize;
+    int m_targetFrameRate;
+    std::unique_ptr<DisplayFrameExchange> m_displayExchange;
+    QOffscreenSurface *m_surface;
+    QThread *m_workerThread;
+    OffscreenEffectsWorker *m_worker;
+    bool m_workerInitialized;
+    bool m_workerFailed;
+};
+
+#endif // OFFSCREENEFFECTSENGINE_H
@@ -0,0 +1,30 @@
+#ifndef PACKEDFRAME_H
+#define PACKEDFRAME_H
+
+#include <QMetaType>
+#include <QSize>
+#include "FramePool.h"
+
+/**
+ * @brief A frame that is already in a V4L2 output pixel layout.
+ *
+ * Produced by the GPU packing pass in VideoEffectsEngine so the virtual
+ * camera can skip its own scaling and colour conversion.
+ */
+struct PackedFrame {
+    enum class Format {
+        Yuyv
+    };
+
+    Format format = Format::Yuyv;
+    QSize size;          // Pixel dimensions of the frame
+    int stride = 0;      // Bytes per row in data
+    FrameBuffer data;    // Pooled; shared, not copied, between stages
+    qint64 captureTimeUs = 0;  // FrameClock time the camera frame entered the pipeline
+
+    bool isNull() const { return data.isNull() || size.isEmpty(); }
+};
+
+Q_DECLARE_METATYPE(PackedFrame)
+
+#endif // PACKEDFRAME_H
@@ -0,0 +1,71 @@
+#include "SharedConversion.h"
+
+#include <QMutexLocker>
+
+void SharedConversion::addSink(const QSize &resolution, VirtualCameraStreamer::OutputFormat format)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_entries[makeKey(resolution, kScaledStage)].sinks;
+    ++m_entries[makeKey(resolution, static_cast<int>(format))].sinks;
+}
+
+bool SharedConversion::sharesScaling(const QSize &resolution) const
+{
+    return isShared(makeKey(resolution, kScaledStage));
+}
+
+bool SharedConversion::sharesConversion(const QSize &resolution,
+                                        VirtualCameraStreamer::OutputFormat format) const
+{
+    return isShared(makeKey(resolution, static_cast<int>(format)));
+}
+
+QImage SharedConversion::scaledImage(const QSize &resolution, const std::function<QImage()> &compute)
+{
+    return share(makeKey(resolution, kScaledStage), &Entry::image, compute);
+}
+
+SharedConversion::Converted SharedConversion::convertedFrame(const QSize &resolution,
+                                                             VirtualCameraStreamer::OutputFormat format,
+                                                             const std::function<Converted()> &compute)
+{
+    return share(makeKey(resolution, static_cast<int>(format)), &Entry::converted, compute);
+}
+
+SharedConversion::Key SharedConversion::makeKey(const QSize &resolution, int stage)
+{
+    // All "match" sinks scale to the same (source) size
+    const QSize normalized = resolution.isValid() ? resolution : QSize();
+    return Key(normalized.width(), normalized.height(), stage);
+}
+
+bool SharedConversion::isShared(const Key &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_entries.find(key);
+    return it != m_entries.end() && it->second.sinks > 1;
+}
+
+template <typename Result>
+Result SharedConversion::share(const Key &key, Result Entry::*field, const std::function<Result()> &compute)
+{
+    QMutexLocker locker(&m_mutex);
+    Entry &entry = m_entries[key];
+    if (entry.claimed) {
+        while (!entry.ready) {
+            m_ready.wait(&m_mutex);
+        }
+        return entry.*field;
+    }
+
+    // Compute outside the lock so other stages and keys are not held up
+    entry.claimed = true;
+    locker.unlock();
+    const Result result = compute();
+    locker.relock();
+
+    entry.*field = result;
+    entry.ready = true;
+    m_ready.wakeAll();
+    return result;
+}
@@ -0,0 +1,81 @@
+#ifndef SHAREDCONVERSION_H
+#define SHAREDCONVERSION_H
+
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QWaitCondition>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <tuple>
+#include "FramePool.h"
+#include "VirtualCameraStreamer.h"
+
+/**
+ * @brief Scaled and converted versions of one processed frame, shared
+ * between virtual camera sinks.
+ *
+ * VirtualCameraOutputs creates one per frame and registers every sink's
+ * resolution and format with addSink() before handing it out. A stage is
+ * shared only when at least two sinks registered the same parameters; the
+ * first sink worker to ask computes the result on its own thread and the
+ * others wait for it instead of repeating the work. Results are published
+ * even when the computation fails (as null), so waiters never block on a
+ * stage that will not finish. Thread-safe once the sinks are registered.
+ */
+class SharedConversion
+{
+public:
+    // One frame in a sink's device layout
+    struct Converted {
+        FrameBuffer buffer;
+        size_t bytesUsed = 0;
+        int bytesPerLine = 0;   // Stride the frame was converted for
+
+        bool isNull() const { return buffer.isNull() || bytesUsed == 0; }
+    };
+
+    SharedConversion() = default;
+    SharedConversion(const SharedConversion &) = delete;
+    SharedConversion &operator=(const SharedConversion &) = delete;
+
+    // An invalid resolution follows the processed frame's size
+    void addSink(const QSize &resolution, VirtualCameraStreamer::OutputFormat format);
+
+    bool sharesScaling(const QSize &resolution) const;
+    bool sharesConversion(const QSize &resolution, VirtualCameraStreamer::OutputFormat format) const;
+
+    // RGB888 frame at the sink resolution; compute() runs at most once
+    QImage scaledImage(const QSize &resolution, const std::function<QImage()> &compute);
+
+    // Converted frame for the sink resolution and format; compute() runs at most once
+    Converted convertedFrame(const QSize &resolution, VirtualCameraStreamer::OutputFormat format,
+                             const std::function<Converted()> &compute);
+
+private:
+    // Width, height and output format; the scaling stage uses kScaledStage
+    using Key = std::tuple<int, int, int>;
+    static constexpr int kScaledStage = -1;
+
+    struct Entry {
+        int sinks = 0;
+        bool claimed = false;
+        bool ready = false;
+        QImage image;
+        Converted converted;
+    };
+
+    static Key makeKey(const QSize &resolution, int stage);
+    bool isShared(const Key &key) const;
+
+    // Computes the result for a shared key once and hands it to every caller
+    template <typename Result>
+    Result share(const Key &key, Result Entry::*field, const std::function<Result()> &compute);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_ready;
+    std::map<Key, Entry> m_entries;
+};
+
+#endif // SHAREDCONVERSION_H
@@ -0,0 +1,68 @@
+#include "SliceWorkerPool.h"
+
+#include <QSemaphore>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+// The effects renderer and the GUI need cores too
+constexpr int kMaxAutoThreads = 4;
+
+// Below this a band costs more to dispatch than to process
+constexpr int kMinRowsPerSlice = 64;
+
+} // namespace
+
+SliceWorkerPool::SliceWorkerPool(int threadCount)
+    : m_threadCount(1)
+{
+    setThreadCount(threadCount);
+}
+
+SliceWorkerPool::~SliceWorkerPool()
+{
+    m_pool.waitForDone();
+}
+
+void SliceWorkerPool::setThreadCount(int threadCount)
+{
+    if (threadCount <= 0) {
+        threadCount = std::clamp(QThread::idealThreadCount(), 1, kMaxAutoThreads);
+    }
+
+    m_threadCount = threadCount;
+    // The calling thread takes one band itself
+    m_pool.setMaxThreadCount(std::max(1, threadCount - 1));
+}
+
+void SliceWorkerPool::run(int rows, int rowAlignment, const std::function<void(int, int)> &fn)
+{
+    if (rows <= 0) {
+        return;
+    }
+
+    rowAlignment = std::max(1, rowAlignment);
+    const int slices = std::min(m_threadCount, rows / kMinRowsPerSlice);
+    if (slices <= 1) {
+        fn(0, rows);
+        return;
+    }
+
+    int sliceRows = (rows + slices - 1) / slices;
+    sliceRows = ((sliceRows + rowAlignment - 1) / rowAlignment) * rowAlignment;
+
+    QSemaphore finished;
+    int dispatched = 0;
+    for (int first = sliceRows; first < rows; first += sliceRows) {
+        const int end = std::min(rows, first + sliceRows);
+        m_pool.start([&fn, &finished, first, end]() {
+            fn(first, end);
+            finished.release();
+        });
+        ++dispatched;
+    }
+
+    fn(0, std::min(rows, sliceRows));
+    finished.acquire(dispatched);
+}
@@ -0,0 +1,34 @@
+#ifndef SLICEWORKERPOOL_H
+#define SLICEWORKERPOOL_H
+
+#include <QThreadPool>
+#include <functional>
+
+/**
+ * @brief Runs per-frame image work as horizontal slices on a few threads.
+ *
+ * run() splits the rows of one frame into contiguous bands, hands all but
+ * the first to a private thread pool, processes the first on the calling
+ * thread and returns once every band is done. Frames are still handled one
+ * at a time by the caller, so frame order is unaffected.
+ */
+class SliceWorkerPool
+{
+public:
+    explicit SliceWorkerPool(int threadCount = 0);
+    ~SliceWorkerPool();
+
+    // Threads working on a frame, including the caller; 0 picks from the CPU count
+    void setThreadCount(int threadCount);
+    int threadCount() const { return m_threadCount; }
+
+    // Calls fn(firstRow, endRow) for each band of [0, rows). Band starts are
+    // multiples of rowAlignment; small frames run as a single band.
+    void run(int rows, int rowAlignment, const std::function<void(int, int)> &fn);
+
+private:
+    QThreadPool m_pool;
+    int m_threadCount;
+};
+
+#endif // SLICEWORKERPOOL_H
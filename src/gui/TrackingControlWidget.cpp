@@ -10,6 +10,11 @@ TrackingControlWidget::TrackingControlWidget(CameraController *controller, QWidg
     // Create debounce timer for command completion
     m_commandTimer = new QTimer(this);
     m_commandTimer->setSingleShot(true);
+    // Updates are only sent on change, so catch up on any skipped meanwhile
+    connect(m_commandTimer, &QTimer::timeout, this, [this]() {
+        m_userInitiated = false;
+        updateFromState(m_controller->getCurrentState());
+    });
     m_tiny2Capabilities = m_controller->hasTiny2Capabilities();
 
     QVBoxLayout *layout = new QVBoxLayout(this);
@@ -251,7 +256,8 @@ void TrackingControlWidget::onTrackingToggled(bool checked)
     m_commandTimer->start(1000);
 }
 
-void TrackingControlWidget::updateFromState(const CameraController::CameraState &state)
+void TrackingControlWidget::updateFromState(const CameraController::CameraState &state,
+                                            CameraController::StateFields changed)
 {
     // Only update if:
     // 1. State differs from what's shown AND
@@ -262,7 +268,8 @@ void TrackingControlWidget::updateFromState(const CameraController::CameraState
     bool commandInFlight = m_commandTimer->isActive();
     bool isSettling = m_controller->isSettling();
 
-    if (m_trackingCheckBox->isChecked() != shouldBeChecked && !m_userInitiated && !commandInFlight && !isSettling) {
+    if ((changed & CameraController::AiModeField) &&
+        m_trackingCheckBox->isChecked() != shouldBeChecked && !m_userInitiated && !commandInFlight && !isSettling) {
         m_trackingCheckBox->blockSignals(true);
         m_trackingCheckBox->setChecked(shouldBeChecked);
         m_trackingCheckBox->blockSignals(false);
@@ -276,7 +283,8 @@ void TrackingControlWidget::updateFromState(const CameraController::CameraState
 
     if (m_tiny2Capabilities && !m_userInitiated && !commandInFlight && !isSettling) {
         int modeIdx = m_modeCombo->findData(state.aiMode);
-        if (modeIdx >= 0 && m_modeCombo->currentIndex() != modeIdx) {
+        if ((changed & CameraController::AiModeField) &&
+            modeIdx >= 0 && m_modeCombo->currentIndex() != modeIdx) {
             m_modeCombo->blockSignals(true);
             m_modeCombo->setCurrentIndex(modeIdx);
             m_modeCombo->blockSignals(false);
@@ -284,7 +292,8 @@ void TrackingControlWidget::updateFromState(const CameraController::CameraState
 
         updateTiny2Visibility();
 
-        if (state.aiMode == Device::AiWorkModeHuman) {
+        if (state.aiMode == Device::AiWorkModeHuman &&
+            (changed & (CameraController::AiModeField | CameraController::AiSubModeField))) {
             int subIdx = m_humanSubModeCombo->findData(state.aiSubMode);
             if (subIdx >= 0 && m_humanSubModeCombo->currentIndex() != subIdx) {
                 m_humanSubModeCombo->blockSignals(true);
@@ -293,32 +302,47 @@ void TrackingControlWidget::updateFromState(const CameraController::CameraState
             }
         }
 
-        if (m_autoZoomCheckBox->isChecked() != state.autoZoomEnabled) {
+        if ((changed & CameraController::AutoZoomField) &&
+            m_autoZoomCheckBox->isChecked() != state.autoZoomEnabled) {
             m_autoZoomCheckBox->blockSignals(true);
             m_autoZoomCheckBox->setChecked(state.autoZoomEnabled);
             m_autoZoomCheckBox->blockSignals(false);
         }
 
         int speedIdx = m_speedCombo->findData(state.trackSpeedMode);
-        if (speedIdx >= 0 && m_speedCombo->currentIndex() != speedIdx) {
+        if ((changed & CameraController::TrackSpeedField) &&
+            speedIdx >= 0 && m_speedCombo->currentIndex() != speedIdx) {
             m_speedCombo->blockSignals(true);
             m_speedCombo->setCurrentIndex(speedIdx);
             m_speedCombo->blockSignals(false);
         }
 
-        if (m_audioGainCheckBox->isChecked() != state.audioAutoGainEnabled) {
+        if ((changed & CameraController::AudioAutoGainField) &&
+            m_audioGainCheckBox->isChecked() != state.audioAutoGainEnabled) {
             m_audioGainCheckBox->blockSignals(true);
             m_audioGainCheckBox->setChecked(state.audioAutoGainEnabled);
             m_audioGainCheckBox->blockSignals(false);
         }
     }
 
+    // PTZ commands complete asynchronously; the label follows the confirmed position
+    if (changed & (CameraController::PanField | CameraController::TiltField)) {
+        updatePositionLabel(state.pan, state.tilt);
+    }
+
     // If command completed and timer expired, we can now accept state updates
     if (!commandInFlight && m_userInitiated) {
         m_userInitiated = false;
     }
 }
 
+void TrackingControlWidget::updatePositionLabel(double pan, double tilt)
+{
+    m_positionLabel->setText(QString("Position: Pan %1, Tilt %2")
+        .arg(pan, 0, 'f', 2)
+        .arg(tilt, 0, 'f', 2));
+}
+
 void TrackingControlWidget::onModeChanged(int index)
 {
     Q_UNUSED(index);
@@ -405,43 +429,26 @@ void TrackingControlWidget::updatePTZControlsState()
 void TrackingControlWidget::onPanLeftClicked()
 {
     m_controller->adjustPan(-0.05);
-    auto state = m_controller->getCurrentState();
-    m_positionLabel->setText(QString("Position: Pan %1, Tilt %2")
-        .arg(state.pan, 0, 'f', 2)
-        .arg(state.tilt, 0, 'f', 2));
 }
 
 void TrackingControlWidget::onPanRightClicked()
 {
     m_controller->adjustPan(0.05);
-    auto state = m_controller->getCurrentState();
-    m_positionLabel->setText(QString("Position: Pan %1, Tilt %2")
-        .arg(state.pan, 0, 'f', 2)
-        .arg(state.tilt, 0, 'f', 2));
 }
 
 void TrackingControlWidget::onTiltUpClicked()
 {
     m_controller->adjustTilt(0.05);
-    auto state = m_controller->getCurrentState();
-    m_positionLabel->setText(QString("Position: Pan %1, Tilt %2")
-        .arg(state.pan, 0, 'f', 2)
-        .arg(state.tilt, 0, 'f', 2));
 }
 
 void TrackingControlWidget::onTiltDownClicked()
 {
     m_controller->adjustTilt(-0.05);
-    auto state = m_controller->getCurrentState();
-    m_positionLabel->setText(QString("Position: Pan %1, Tilt %2")
-        .arg(state.pan, 0, 'f', 2)
-        .arg(state.tilt, 0, 'f', 2));
 }
 
 void TrackingControlWidget::onCenterClicked()
 {
     m_controller->centerView();
-    m_positionLabel->setText("Position: Pan 0.00, Tilt 0.00");
 }
 
 void TrackingControlWidget::onZoomChanged(int value)
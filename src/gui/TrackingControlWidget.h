@@ -25,7 +25,9 @@ class TrackingControlWidget : public QWidget
 public:
     explicit TrackingControlWidget(CameraController *controller, QWidget *parent = nullptr);
 
-    void updateFromState(const CameraController::CameraState &state);
+    // Only the controls for the changed fields are touched
+    void updateFromState(const CameraController::CameraState &state,
+                         CameraController::StateFields changed = CameraController::AllStateFields);
     bool isTrackingEnabled() const { return m_trackingCheckBox->isChecked(); }
     void setTrackingEnabled(bool enabled) {
         m_trackingCheckBox->blockSignals(true);
@@ -85,6 +87,7 @@ private:
 
     void updateTiny2Visibility();
     void updatePTZControlsState();
+    void updatePositionLabel(double pan, double tilt);
 };
 
 #endif // TRACKINGCONTROLWIDGET_H
@@ -0,0 +1,541 @@
+#include "V4l2CaptureSource.h"
+
+#include "FrameClock.h"
+
+#include <QByteArray>
+#include <QLoggingCategory>
+#include <QMetaObject>
+#include <QMetaType>
+#include <QSocketNotifier>
+#include <QThread>
+#include <QVideoFrameFormat>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+Q_LOGGING_CATEGORY(V4l2CaptureLog, "obsbot.capture")
+
+namespace {
+
+constexpr int kMinBufferCount = 2;
+constexpr int kMaxBufferCount = 16;
+// Frames handed to the receiving thread but not yet taken
+constexpr int kMaxFramesInFlight = 2;
+
+QString errnoString()
+{
+    return QString::fromLocal8Bit(strerror(errno));
+}
+
+int xioctl(int fd, unsigned long request, void *arg)
+{
+    int result;
+    do {
+        result = ioctl(fd, request, arg);
+    } while (result == -1 && errno == EINTR);
+    return result;
+}
+
+QVideoFrameFormat::PixelFormat videoFormatFor(uint32_t fourcc)
+{
+    switch (fourcc) {
+    case V4L2_PIX_FMT_MJPEG:
+    case V4L2_PIX_FMT_JPEG:
+        return QVideoFrameFormat::Format_Jpeg;
+    case V4L2_PIX_FMT_YUYV:
+        return QVideoFrameFormat::Format_YUYV;
+    case V4L2_PIX_FMT_NV12:
+        return QVideoFrameFormat::Format_NV12;
+    default:
+        return QVideoFrameFormat::Format_Invalid;
+    }
+}
+
+QString fourccName(uint32_t fourcc)
+{
+    const char name[] = {
+        static_cast<char>(fourcc & 0xff),
+        static_cast<char>((fourcc >> 8) & 0xff),
+        static_cast<char>((fourcc >> 16) & 0xff),
+        static_cast<char>((fourcc >> 24) & 0xff)
+    };
+    return QString::fromLatin1(name, 4).trimmed();
+}
+
+// Copies rows between buffers whose strides may differ
+void copyRows(uint8_t *dst, int dstStride, const uint8_t *src, int srcStride, int rowBytes, int rows)
+{
+    for (int y = 0; y < rows; ++y) {
+        memcpy(dst + static_cast<size_t>(y) * dstStride,
+               src + static_cast<size_t>(y) * srcStride,
+               static_cast<size_t>(rowBytes));
+    }
+}
+
+} // namespace
+
+class V4l2CaptureWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    V4l2CaptureWorker()
+        : m_fd(-1)
+        , m_notifier(nullptr)
+        , m_fourcc(0)
+        , m_pixelFormat(QVideoFrameFormat::Format_Invalid)
+        , m_bytesPerLine(0)
+        , m_streaming(false)
+        , m_framesInFlight(0)
+        , m_framesDropped(0)
+    {
+    }
+
+    ~V4l2CaptureWorker() override
+    {
+        stop();
+    }
+
+    // Called on the receiving thread once it has taken a frame
+    void frameConsumed()
+    {
+        m_framesInFlight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+public slots:
+    void start(const V4l2CaptureSource::Settings &settings)
+    {
+        stop();
+        m_settings = settings;
+
+        if (!openDevice() || !configureFormat() || !setupBuffers() || !startStreaming()) {
+            stop();
+            return;
+        }
+
+        m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated,
+                this, &V4l2CaptureWorker::readFrames);
+
+        const QString description = QStringLiteral("%1 × %2 %3, %4 buffers")
+            .arg(m_frameSize.width())
+            .arg(m_frameSize.height())
+            .arg(fourccName(m_fourcc))
+            .arg(m_buffers.size());
+        qCDebug(V4l2CaptureLog) << "Capturing from" << m_settings.devicePath << description;
+        emit started(m_frameSize, description);
+    }
+
+    void stop()
+    {
+        if (m_notifier) {
+            // May be called from the notifier's own activated() signal
+            m_notifier->setEnabled(false);
+            m_notifier->deleteLater();
+            m_notifier = nullptr;
+        }
+
+        if (m_fd != -1 && m_streaming) {
+            int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            xioctl(m_fd, VIDIOC_STREAMOFF, &type);
+        }
+        m_streaming = false;
+
+        for (const MappedBuffer &buffer : m_buffers) {
+            munmap(buffer.start, buffer.length);
+        }
+        if (m_fd != -1 && !m_buffers.empty()) {
+            struct v4l2_requestbuffers request;
+            memset(&request, 0, sizeof(request));
+            request.count = 0;
+            request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            request.memory = V4L2_MEMORY_MMAP;
+            xioctl(m_fd, VIDIOC_REQBUFS, &request);
+        }
+        m_buffers.clear();
+
+        if (m_fd != -1) {
+            ::close(m_fd);
+            m_fd = -1;
+            if (m_framesDropped > 0) {
+                qCDebug(V4l2CaptureLog) << "Dropped" << m_framesDropped << "frames the receiver did not keep up with";
+            }
+        }
+        m_framesDropped = 0;
+    }
+
+signals:
+    void frameReady(const QVideoFrame &frame, qint64 captureTimeUs);
+    void started(const QSize &size, const QString &description);
+    void errorOccurred(const QString &message);
+
+private:
+    struct MappedBuffer {
+        void *start;
+        size_t length;
+    };
+
+    bool openDevice()
+    {
+        const QByteArray path = m_settings.devicePath.toLocal8Bit();
+        m_fd = ::open(path.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (m_fd == -1) {
+            emit errorOccurred(tr("Cannot open camera device %1: %2")
+                .arg(m_settings.devicePath, errnoString()));
+            qCWarning(V4l2CaptureLog) << "Failed to open" << m_settings.devicePath << errnoString();
+            return false;
+        }
+
+        struct v4l2_capability capability;
+        memset(&capability, 0, sizeof(capability));
+        if (xioctl(m_fd, VIDIOC_QUERYCAP, &capability) == -1) {
+            emit errorOccurred(tr("%1 is not a V4L2 device").arg(m_settings.devicePath));
+            return false;
+        }
+
+        const uint32_t caps = (capability.capabilities & V4L2_CAP_DEVICE_CAPS)
+            ? capability.device_caps
+            : capability.capabilities;
+        if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+            emit errorOccurred(tr("%1 does not support streaming video capture")
+                .arg(m_settings.devicePath));
+            return false;
+        }
+        return true;
+    }
+
+    // Tries the preferred encodings in order and keeps the first the driver
+    // accepts. Drivers with a fixed format (v4l2loopback) report it back.
+    bool configureFormat()
+    {
+        struct v4l2_format current;
+        memset(&current, 0, sizeof(current));
+        current.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if (xioctl(m_fd, VIDIOC_G_FMT, &current) == -1) {
+            emit errorOccurred(tr("Failed to query camera format: %1").arg(errnoString()));
+            return false;
+        }
+
+        const std::vector<uint32_t> candidates = m_settings.preferMjpeg
+            ? std::vector<uint32_t>{V4L2_PIX_FMT_MJPEG, V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV12}
+            : std::vector<uint32_t>{V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_MJPEG};
+
+        for (uint32_t fourcc : candidates) {
+            struct v4l2_format format = current;
+            format.fmt.pix.pixelformat = fourcc;
+            format.fmt.pix.field = V4L2_FIELD_NONE;
+            if (m_settings.resolution.isValid()) {
+                format.fmt.pix.width = static_cast<uint32_t>(m_settings.resolution.width());
+                format.fmt.pix.height = static_cast<uint32_t>(m_settings.resolution.height());
+            }
+            if (xioctl(m_fd, VIDIOC_S_FMT, &format) == -1) {
+                if (errno == EBUSY) {
+                    emit errorOccurred(tr("Camera device %1 is busy").arg(m_settings.devicePath));
+                    return false;
+                }
+                continue;
+            }
+
+            const QVideoFrameFormat::PixelFormat pixelFormat = videoFormatFor(format.fmt.pix.pixelformat);
+            if (pixelFormat == QVideoFrameFormat::Format_Invalid) {
+                continue;
+            }
+
+            m_fourcc = format.fmt.pix.pixelformat;
+            m_pixelFormat = pixelFormat;
+            m_frameSize = QSize(static_cast<int>(format.fmt.pix.width), static_cast<int>(format.fmt.pix.height));
+            m_bytesPerLine = static_cast<int>(format.fmt.pix.bytesperline);
+            if (m_bytesPerLine <= 0 && pixelFormat != QVideoFrameFormat::Format_Jpeg) {
+                m_bytesPerLine = pixelFormat == QVideoFrameFormat::Format_YUYV
+                    ? m_frameSize.width() * 2
+                    : m_frameSize.width();
+            }
+            configureFrameRate();
+            return true;
+        }
+
+        emit errorOccurred(tr("%1 offers none of MJPEG, YUYV or NV12").arg(m_settings.devicePath));
+        return false;
+    }
+
+    void configureFrameRate()
+    {
+        if (m_settings.frameRate <= 0) {
+            return;
+        }
+
+        struct v4l2_streamparm parm;
+        memset(&parm, 0, sizeof(parm));
+        parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if (xioctl(m_fd, VIDIOC_G_PARM, &parm) == -1 ||
+            !(parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+            return;
+        }
+
+        parm.parm.capture.timeperframe.numerator = 1;
+        parm.parm.capture.timeperframe.denominator = static_cast<uint32_t>(m_settings.frameRate);
+        if (xioctl(m_fd, VIDIOC_S_PARM, &parm) == -1) {
+            qCDebug(V4l2CaptureLog) << "VIDIOC_S_PARM failed, keeping the device frame rate" << errnoString();
+        }
+    }
+
+    bool setupBuffers()
+    {
+        struct v4l2_requestbuffers request;
+        memset(&request, 0, sizeof(request));
+        request.count = static_cast<uint32_t>(std::clamp(m_settings.bufferCount, kMinBufferCount, kMaxBufferCount));
+        request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        request.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(m_fd, VIDIOC_REQBUFS, &request) == -1 || request.count == 0) {
+            emit errorOccurred(tr("Failed to allocate capture buffers: %1").arg(errnoString()));
+            return false;
+        }
+
+        for (uint32_t i = 0; i < request.count; ++i) {
+            struct v4l2_buffer buffer;
+            memset(&buffer, 0, sizeof(buffer));
+            buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            buffer.memory = V4L2_MEMORY_MMAP;
+            buffer.index = i;
+            if (xioctl(m_fd, VIDIOC_QUERYBUF, &buffer) == -1) {
+                emit errorOccurred(tr("Failed to query capture buffer: %1").arg(errnoString()));
+                return false;
+            }
+
+            void *start = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                               m_fd, buffer.m.offset);
+            if (start == MAP_FAILED) {
+                emit errorOccurred(tr("Failed to map capture buffer: %1").arg(errnoString()));
+                return false;
+            }
+            m_buffers.push_back({start, buffer.length});
+
+            if (xioctl(m_fd, VIDIOC_QBUF, &buffer) == -1) {
+                emit errorOccurred(tr("Failed to queue capture buffer: %1").arg(errnoString()));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool startStreaming()
+    {
+        int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if (xioctl(m_fd, VIDIOC_STREAMON, &type) == -1) {
+            emit errorOccurred(tr("Failed to start capture: %1").arg(errnoString()));
+            return false;
+        }
+        m_streaming = true;
+        return true;
+    }
+
+    void readFrames()
+    {
+        // Dequeue everything that is ready; buffers go back to the driver
+        // as soon as their contents are copied
+        while (m_fd != -1) {
+            struct v4l2_buffer buffer;
+            memset(&buffer, 0, sizeof(buffer));
+            buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            buffer.memory = V4L2_MEMORY_MMAP;
+            if (xioctl(m_fd, VIDIOC_DQBUF, &buffer) == -1) {
+                if (errno == EAGAIN) {
+                    return;
+                }
+                const QString message = tr("Camera capture failed: %1").arg(errnoString());
+                qCWarning(V4l2CaptureLog) << "VIDIOC_DQBUF failed" << errnoString();
+                stop();
+                emit errorOccurred(message);
+                return;
+            }
+
+            deliverBuffer(buffer);
+
+            if (xioctl(m_fd, VIDIOC_QBUF, &buffer) == -1) {
+                const QString message = tr("Camera capture failed: %1").arg(errnoString());
+                qCWarning(V4l2CaptureLog) << "VIDIOC_QBUF failed" << errnoString();
+                stop();
+                emit errorOccurred(message);
+                return;
+            }
+        }
+    }
+
+    void deliverBuffer(const struct v4l2_buffer &buffer)
+    {
+        if ((buffer.flags & V4L2_BUF_FLAG_ERROR) || buffer.bytesused == 0 ||
+            buffer.index >= m_buffers.size()) {
+            return;
+        }
+
+        if (m_framesInFlight.load(std::memory_order_relaxed) >= kMaxFramesInFlight) {
+            ++m_framesDropped;
+            return;
+        }
+
+        const MappedBuffer &mapped = m_buffers[buffer.index];
+        const size_t bytesUsed = std::min<size_t>(buffer.bytesused, mapped.length);
+        QVideoFrame frame = copyFrame(static_cast<const uint8_t *>(mapped.start), bytesUsed);
+        if (!frame.isValid()) {
+            return;
+        }
+
+        // Same clock as FrameClock, so latency is measured from the sensor
+        qint64 captureTimeUs = 0;
+        if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+            captureTimeUs = static_cast<qint64>(buffer.timestamp.tv_sec) * 1000000 + buffer.timestamp.tv_usec;
+        }
+        if (captureTimeUs <= 0) {
+            captureTimeUs = FrameClock::nowUs();
+        }
+
+        m_framesInFlight.fetch_add(1, std::memory_order_relaxed);
+        emit frameReady(frame, captureTimeUs);
+    }
+
+    QVideoFrame copyFrame(const uint8_t *data, size_t bytesUsed) const
+    {
+        QVideoFrame frame(QVideoFrameFormat(m_frameSize, m_pixelFormat));
+        if (!frame.map(QVideoFrame::WriteOnly)) {
+            qCWarning(V4l2CaptureLog) << "Failed to map a video frame for writing";
+            return QVideoFrame();
+        }
+
+        const int width = m_frameSize.width();
+        const int height = m_frameSize.height();
+        bool complete = true;
+        switch (m_pixelFormat) {
+        case QVideoFrameFormat::Format_YUYV:
+            complete = bytesUsed >= static_cast<size_t>(m_bytesPerLine) * height;
+            if (complete) {
+                copyRows(frame.bits(0), frame.bytesPerLine(0), data, m_bytesPerLine, width * 2, height);
+            }
+            break;
+        case QVideoFrameFormat::Format_NV12: {
+            const size_t lumaBytes = static_cast<size_t>(m_bytesPerLine) * height;
+            complete = bytesUsed >= lumaBytes + static_cast<size_t>(m_bytesPerLine) * ((height + 1) / 2);
+            if (complete) {
+                copyRows(frame.bits(0), frame.bytesPerLine(0), data, m_bytesPerLine, width, height);
+                copyRows(frame.bits(1), frame.bytesPerLine(1), data + lumaBytes, m_bytesPerLine,
+                         width, (height + 1) / 2);
+            }
+            break;
+        }
+        case QVideoFrameFormat::Format_Jpeg:
+        default:
+            // The decoder stops at the end-of-image marker, so padding is harmless
+            complete = bytesUsed <= static_cast<size_t>(frame.mappedBytes(0));
+            if (complete) {
+                memcpy(frame.bits(0), data, bytesUsed);
+            }
+            break;
+        }
+        frame.unmap();
+
+        if (!complete) {
+            qCDebug(V4l2CaptureLog) << "Discarding a truncated frame of" << bytesUsed << "bytes";
+            return QVideoFrame();
+        }
+        return frame;
+    }
+
+    V4l2CaptureSource::Settings m_settings;
+    int m_fd;
+    QSocketNotifier *m_notifier;
+    std::vector<MappedBuffer> m_buffers;
+    uint32_t m_fourcc;
+    QVideoFrameFormat::PixelFormat m_pixelFormat;
+    QSize m_frameSize;
+    int m_bytesPerLine;
+    bool m_streaming;
+    std::atomic<int> m_framesInFlight;
+    quint64 m_framesDropped;
+};
+
+V4l2CaptureSource::V4l2CaptureSource(QObject *parent)
+    : QObject(parent)
+    , m_workerThread(nullptr)
+    , m_worker(nullptr)
+    , m_active(false)
+{
+    qRegisterMetaType<QVideoFrame>("QVideoFrame");
+}
+
+V4l2CaptureSource::~V4l2CaptureSource()
+{
+    if (m_workerThread && m_worker) {
+        QMetaObject::invokeMethod(m_worker, &V4l2CaptureWorker::stop, Qt::BlockingQueuedConnection);
+        m_workerThread->quit();
+        m_workerThread->wait();
+        m_worker = nullptr;
+        m_workerThread = nullptr;
+    }
+}
+
+void V4l2CaptureSource::start(const Settings &settings)
+{
+    ensureWorker();
+    m_active = true;
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, settings]() {
+            worker->start(settings);
+        },
+        Qt::QueuedConnection);
+}
+
+void V4l2CaptureSource::stop()
+{
+    if (!m_worker) {
+        return;
+    }
+
+    m_active = false;
+    // The device must be free before the caller reopens it another way
+    QMetaObject::invokeMethod(m_worker, &V4l2CaptureWorker::stop, Qt::BlockingQueuedConnection);
+}
+
+void V4l2CaptureSource::handleWorkerFrame(const QVideoFrame &frame, qint64 captureTimeUs)
+{
+    m_worker->frameConsumed();
+    if (m_active) {
+        emit frameReady(frame, captureTimeUs);
+    }
+}
+
+void V4l2CaptureSource::handleWorkerError(const QString &message)
+{
+    m_active = false;
+    emit errorOccurred(message);
+}
+
+void V4l2CaptureSource::ensureWorker()
+{
+    if (m_worker) {
+        return;
+    }
+
+    m_workerThread = new QThread(this);
+    m_workerThread->setObjectName(QStringLiteral("V4l2Capture"));
+    m_worker = new V4l2CaptureWorker();
+    m_worker->moveToThread(m_workerThread);
+    connect(m_worker, &V4l2CaptureWorker::frameReady,
+            this, &V4l2CaptureSource::handleWorkerFrame);
+    connect(m_worker, &V4l2CaptureWorker::started,
+            this, &V4l2CaptureSource::started);
+    connect(m_worker, &V4l2CaptureWorker::errorOccurred,
+            this, &V4l2CaptureSource::handleWorkerError);
+    connect(m_workerThread, &QThread::finished,
+            m_worker, &QObject::deleteLater);
+    m_workerThread->start();
+}
+
+#include "V4l2CaptureSource.moc"
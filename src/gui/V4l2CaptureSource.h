@@ -0,0 +1,66 @@
+#ifndef V4L2CAPTURESOURCE_H
+#define V4L2CAPTURESOURCE_H
+
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QVideoFrame>
+
+class QThread;
+class V4l2CaptureWorker;
+
+/**
+ * @brief Captures straight from a V4L2 device, bypassing QtMultimedia.
+ *
+ * The worker thread opens the device, negotiates MJPEG, YUYV or NV12 at
+ * the requested size and rate, and streams through a ring of mmap'd
+ * buffers whose count is configurable. Each dequeued buffer is copied once
+ * into a QVideoFrame in the device's own pixel format and the buffer is
+ * requeued at once. YUYV and NV12 reach the effects pipeline untouched;
+ * MJPEG frames are decoded there. Frames carry the driver's monotonic
+ * capture timestamp when it provides one.
+ *
+ * At most a couple of frames are in flight to the receiving thread; when
+ * it falls behind, newer captures are dropped at the source instead of
+ * piling up in its event queue. Works with any capture node, including
+ * vivid and the capture side of v4l2loopback.
+ */
+class V4l2CaptureSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings {
+        QString devicePath;
+        QSize resolution;        // Invalid keeps the device's current size
+        int frameRate = 0;       // 0 keeps the device's current rate
+        bool preferMjpeg = true; // Otherwise YUYV/NV12 are tried first
+        int bufferCount = 4;     // mmap buffers requested from the driver
+    };
+
+    explicit V4l2CaptureSource(QObject *parent = nullptr);
+    ~V4l2CaptureSource() override;
+
+    void start(const Settings &settings);
+    // Returns once the device is closed
+    void stop();
+    bool isActive() const { return m_active; }
+
+signals:
+    void frameReady(const QVideoFrame &frame, qint64 captureTimeUs);
+    void started(const QSize &size, const QString &description);
+    void errorOccurred(const QString &message);
+
+private slots:
+    void handleWorkerFrame(const QVideoFrame &frame, qint64 captureTimeUs);
+    void handleWorkerError(const QString &message);
+
+private:
+    void ensureWorker();
+
+    QThread *m_workerThread;
+    V4l2CaptureWorker *m_worker;
+    bool m_active;
+};
+
+#endif // V4L2CAPTURESOURCE_H
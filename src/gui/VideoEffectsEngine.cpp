@@ -0,0 +1,1488 @@
+#include "VideoEffectsEngine.h"
+#include "FramePool.h"
+
+#include <QDebug>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QVector2D>
+#include <QVideoFrame>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+const char *kVertexShaderSource = R"(#version 330 core
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in vec2 a_texCoord;
+
+uniform vec2 u_scale;
+
+out vec2 v_texCoord;
+
+void main()
+{
+    vec2 scaledPos = vec2(a_position.x / u_scale.x, a_position.y / u_scale.y);
+    gl_Position = vec4(scaledPos, 0.0, 1.0);
+    v_texCoord = a_texCoord;
+}
+)";
+
+// Effects shader body. fragmentShaderVariant() prepends the #version line,
+// INPUT_FORMAT and one EFFECT_* define per active effect, so each variant
+// only contains the work the current settings need.
+const char *kFragmentShaderSource = R"(
+uniform sampler2D u_texture;
+uniform sampler2D u_plane1;
+uniform sampler2D u_plane2;
+uniform mat3 u_yuvMatrix;
+uniform vec3 u_yuvOffset;
+uniform sampler2D u_blurTexture;
+uniform sampler2D u_glowTexture;
+uniform vec2 u_texelSize;
+uniform float u_brightness;
+uniform float u_contrast;
+uniform float u_exposure;
+uniform float u_highlights;
+uniform float u_shadows;
+uniform float u_saturation;
+uniform float u_vibrance;
+uniform float u_temperature;
+uniform float u_tint;
+uniform float u_noise;
+uniform float u_blur;
+uniform float u_sharpen;
+uniform float u_glow;
+uniform float u_bloom;
+uniform float u_softFocus;
+uniform float u_duoToneIntensity;
+uniform vec3 u_duoToneShadow;
+uniform vec3 u_duoToneHighlight;
+uniform int u_horizontalFlip;
+
+in vec2 v_texCoord;
+out vec4 fragColor;
+
+float luminance(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+float random(vec2 co)
+{
+    return fract(sin(dot(co, vec2(12.9898, 78.233))) * 43758.5453);
+}
+
+// Fetches the camera pixel at uv as RGB, converting from the uploaded planes
+vec4 sampleSource(vec2 uv)
+{
+#if INPUT_FORMAT == 0
+    return texture(u_texture, uv);
+#else
+    vec3 yuv;
+    yuv.x = texture(u_texture, uv).r;
+#if INPUT_FORMAT == 1
+    // Chroma alternates U, V across each pixel pair; fetch both unfiltered
+    ivec2 size = textureSize(u_texture, 0);
+    ivec2 pos = clamp(ivec2(uv * vec2(size)), ivec2(0), size - 1);
+    int pairX = pos.x - (pos.x % 2);
+    yuv.y = texelFetch(u_texture, ivec2(pairX, pos.y), 0).g;
+    yuv.z = texelFetch(u_texture, ivec2(min(pairX + 1, size.x - 1), pos.y), 0).g;
+#elif INPUT_FORMAT == 2
+    yuv.yz = texture(u_plane1, uv).rg;
+#else
+    yuv.y = texture(u_plane1, uv).r;
+    yuv.z = texture(u_plane2, uv).r;
+#endif
+    return vec4(clamp(u_yuvMatrix * (yuv - u_yuvOffset), 0.0, 1.0), 1.0);
+#endif
+}
+
+void main()
+{
+    // Textures hold image rows top-down as uploaded, matching v_texCoord
+    vec2 uv = v_texCoord;
+    if (u_horizontalFlip == 1) {
+        uv.x = 1.0 - uv.x;
+    }
+
+    vec4 src = sampleSource(uv);
+    vec3 color = src.rgb;
+
+#ifdef EFFECT_SHARPEN
+    // Unsharp masking wants a tight kernel, so sharpen keeps its own 3x3
+    vec2 offsets[9] = vec2[](
+        vec2(-1.0, -1.0), vec2(0.0, -1.0), vec2(1.0, -1.0),
+        vec2(-1.0,  0.0), vec2(0.0,  0.0), vec2(1.0,  0.0),
+        vec2(-1.0,  1.0), vec2(0.0,  1.0), vec2(1.0,  1.0)
+    );
+    float kernel[9] = float[](1.0, 2.0, 1.0,
+                              2.0, 4.0, 2.0,
+                              1.0, 2.0, 1.0);
+    vec3 accum = vec3(0.0);
+    float weightSum = 0.0;
+    for (int i = 0; i < 9; ++i) {
+        vec2 sampleUv = uv + offsets[i] * u_texelSize;
+        vec3 sampleColor = sampleSource(clamp(sampleUv, vec2(0.0), vec2(1.0))).rgb;
+        accum += sampleColor * kernel[i];
+        weightSum += kernel[i];
+    }
+    vec3 sharpenBase = accum / weightSum;
+#endif
+
+    // The blur and glow passes already ran on the flipped frame
+#if defined(EFFECT_BLUR) || defined(EFFECT_SOFT_FOCUS)
+    vec3 blurColor = texture(u_blurTexture, v_texCoord).rgb;
+#endif
+#if defined(EFFECT_GLOW) || defined(EFFECT_BLOOM)
+    vec3 glowColor = texture(u_glowTexture, v_texCoord).rgb;
+#endif
+
+    // Basic adjustments
+#ifdef EFFECT_BRIGHTNESS
+    color += vec3(u_brightness);
+#endif
+#ifdef EFFECT_CONTRAST
+    color = (color - 0.5) * (1.0 + u_contrast) + 0.5;
+#endif
+#ifdef EFFECT_EXPOSURE
+    color *= pow(2.0, u_exposure);
+#endif
+
+#if defined(EFFECT_SHADOWS) || defined(EFFECT_HIGHLIGHTS)
+    float luma = luminance(color);
+#ifdef EFFECT_SHADOWS
+    float shadowMask = clamp((0.5 - luma) * 2.0, 0.0, 1.0);
+    color += vec3(u_shadows) * shadowMask;
+#endif
+#ifdef EFFECT_HIGHLIGHTS
+    float highlightMask = clamp((luma - 0.5) * 2.0, 0.0, 1.0);
+    color += vec3(u_highlights) * highlightMask;
+#endif
+#endif
+
+    // Color adjustments
+#if defined(EFFECT_SATURATION) || defined(EFFECT_VIBRANCE)
+    float newLuma = luminance(color);
+    vec3 gray = vec3(newLuma);
+#ifdef EFFECT_SATURATION
+    float satFactor = clamp(1.0 + u_saturation, 0.0, 2.0);
+    color = mix(gray, color, satFactor);
+#endif
+#ifdef EFFECT_VIBRANCE
+    float currentSat = length(color - gray);
+    float vibranceFactor = clamp(1.0 + u_vibrance * (1.0 - clamp(currentSat, 0.0, 1.0)), 0.0, 2.0);
+    color = mix(gray, color, vibranceFactor);
+#endif
+#endif
+
+#ifdef EFFECT_TEMPERATURE
+    color.r += u_temperature;
+    color.b -= u_temperature;
+#endif
+#ifdef EFFECT_TINT
+    color.g += u_tint;
+#endif
+
+    // Detail adjustments
+#ifdef EFFECT_BLUR
+    color = mix(color, blurColor, u_blur);
+#endif
+
+#ifdef EFFECT_SHARPEN
+    vec3 sharpened = color + (color - sharpenBase) * (u_sharpen * 1.5);
+    color = mix(color, sharpened, u_sharpen);
+#endif
+
+#ifdef EFFECT_SOFT_FOCUS
+    color = mix(color, blurColor, u_softFocus);
+#endif
+
+#ifdef EFFECT_GLOW
+    color += glowColor * (u_glow * 0.5);
+#endif
+
+#ifdef EFFECT_BLOOM
+    color = mix(color, max(color, glowColor), u_bloom);
+#endif
+
+#ifdef EFFECT_NOISE
+    float noiseVal = random(uv * 1000.0);
+    color += (noiseVal - 0.5) * u_noise;
+#endif
+
+#ifdef EFFECT_DUO_TONE
+    float tone = luminance(color);
+    vec3 duo = mix(u_duoToneShadow, u_duoToneHighlight, tone);
+    color = mix(color, duo, u_duoToneIntensity);
+#endif
+
+    color = clamp(color, 0.0, 1.0);
+    fragColor = vec4(color, src.a);
+}
+)";
+
+// Packs the processed frame into YUYV: each RGBA8 output texel holds one
+// Y0 U Y1 V macropixel, so the target is half the frame width. Uses the same
+// BT.601 integer math as YuvConverter, so unscaled output is bit-identical to
+// the CPU path. The source framebuffer is stored top row first.
+const char *kPackFragmentShaderSource = R"(#version 330 core
+uniform sampler2D u_source;
+uniform vec2 u_targetSize;
+uniform vec2 u_cropOffset;
+uniform vec2 u_cropScale;
+
+out vec4 fragColor;
+
+vec3 sampleRgb(float x, float y)
+{
+    vec2 pos = (vec2(x, y) + 0.5) / u_targetSize;
+    vec2 uv = u_cropOffset + pos * u_cropScale;
+    return floor(texture(u_source, uv).rgb * 255.0 + 0.5);
+}
+
+void main()
+{
+    float x0 = floor(gl_FragCoord.x) * 2.0;
+    float x1 = min(x0 + 1.0, u_targetSize.x - 1.0);
+    float y = floor(gl_FragCoord.y);
+
+    vec3 p0 = sampleRgb(x0, y);
+    vec3 p1 = sampleRgb(x1, y);
+
+    float y0 = floor((66.0 * p0.r + 129.0 * p0.g + 25.0 * p0.b + 128.0) / 256.0) + 16.0;
+    float y1 = floor((66.0 * p1.r + 129.0 * p1.g + 25.0 * p1.b + 128.0) / 256.0) + 16.0;
+    float u0 = floor((-38.0 * p0.r - 74.0 * p0.g + 112.0 * p0.b + 128.0) / 256.0) + 128.0;
+    float u1 = floor((-38.0 * p1.r - 74.0 * p1.g + 112.0 * p1.b + 128.0) / 256.0) + 128.0;
+    float v0 = floor((112.0 * p0.r - 94.0 * p0.g - 18.0 * p0.b + 128.0) / 256.0) + 128.0;
+    float v1 = floor((112.0 * p1.r - 94.0 * p1.g - 18.0 * p1.b + 128.0) / 256.0) + 128.0;
+
+    vec4 yuyv = vec4(y0, floor((u0 + u1) / 2.0), y1, floor((v0 + v1) / 2.0));
+    fragColor = clamp(yuyv, 0.0, 255.0) / 255.0;
+}
+)";
+
+// Plain texture copy: draws the finished frame for display and, through
+// linear filtering, box-downsamples the bloom chain by two per level
+const char *kCopyFragmentShaderSource = R"(#version 330 core
+uniform sampler2D u_source;
+
+in vec2 v_texCoord;
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = texture(u_source, v_texCoord);
+}
+)";
+
+// One axis of a separable Gaussian. Taps past the centre sit between two
+// texels so a single linear fetch weighs both; the array size must match
+// kMaxBlurTaps.
+const char *kBlurFragmentShaderSource = R"(#version 330 core
+uniform sampler2D u_source;
+uniform vec2 u_direction;
+uniform int u_tapCount;
+uniform float u_offsets[33];
+uniform float u_weights[33];
+
+in vec2 v_texCoord;
+out vec4 fragColor;
+
+void main()
+{
+    vec4 sum = texture(u_source, v_texCoord) * u_weights[0];
+    for (int i = 1; i < u_tapCount; ++i) {
+        vec2 offset = u_direction * u_offsets[i];
+        sum += (texture(u_source, v_texCoord + offset) +
+                texture(u_source, v_texCoord - offset)) * u_weights[i];
+    }
+    fragColor = sum;
+}
+)";
+
+// Bloom upsample step: blends a level with the (bilinearly upscaled) average
+// of every coarser level
+const char *kCombineFragmentShaderSource = R"(#version 330 core
+uniform sampler2D u_source;
+uniform sampler2D u_coarser;
+uniform float u_coarserWeight;
+
+in vec2 v_texCoord;
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = mix(texture(u_source, v_texCoord), texture(u_coarser, v_texCoord), u_coarserWeight);
+}
+)";
+
+enum EffectFlag : quint32 {
+    EffectBrightness = 1u << 0,
+    EffectContrast = 1u << 1,
+    EffectExposure = 1u << 2,
+    EffectShadows = 1u << 3,
+    EffectHighlights = 1u << 4,
+    EffectSaturation = 1u << 5,
+    EffectVibrance = 1u << 6,
+    EffectTemperature = 1u << 7,
+    EffectTint = 1u << 8,
+    EffectNoise = 1u << 9,
+    EffectBlur = 1u << 10,
+    EffectSharpen = 1u << 11,
+    EffectGlow = 1u << 12,
+    EffectBloom = 1u << 13,
+    EffectSoftFocus = 1u << 14,
+    EffectDuoTone = 1u << 15
+};
+
+struct EffectDefine {
+    EffectFlag flag;
+    const char *name;
+};
+
+constexpr EffectDefine kEffectDefines[] = {
+    {EffectBrightness, "EFFECT_BRIGHTNESS"},
+    {EffectContrast, "EFFECT_CONTRAST"},
+    {EffectExposure, "EFFECT_EXPOSURE"},
+    {EffectShadows, "EFFECT_SHADOWS"},
+    {EffectHighlights, "EFFECT_HIGHLIGHTS"},
+    {EffectSaturation, "EFFECT_SATURATION"},
+    {EffectVibrance, "EFFECT_VIBRANCE"},
+    {EffectTemperature, "EFFECT_TEMPERATURE"},
+    {EffectTint, "EFFECT_TINT"},
+    {EffectNoise, "EFFECT_NOISE"},
+    {EffectBlur, "EFFECT_BLUR"},
+    {EffectSharpen, "EFFECT_SHARPEN"},
+    {EffectGlow, "EFFECT_GLOW"},
+    {EffectBloom, "EFFECT_BLOOM"},
+    {EffectSoftFocus, "EFFECT_SOFT_FOCUS"},
+    {EffectDuoTone, "EFFECT_DUO_TONE"}
+};
+
+// Variants are cheap to build but not free; drop the cache if slider
+// sweeps ever leave behind more combinations than this.
+constexpr size_t kMaxCachedPrograms = 32;
+
+constexpr quint32 kBlurEffects = EffectBlur | EffectSoftFocus;
+constexpr quint32 kGlowEffects = EffectGlow | EffectBloom;
+
+// Blur radius in pixels at full slider strength on a 1080-line frame; it
+// scales with the frame height so the look holds across resolutions
+constexpr float kMaxBlurRadius = 24.0f;
+constexpr int kMaxBlurTaps = 33;
+constexpr int kMaxBlurKernelRadius = (kMaxBlurTaps - 1) * 2;
+
+// Each bloom level is half the size of the one above and gets a small blur;
+// stacking them gives a wide halo for a handful of taps per pixel
+constexpr int kBloomLevelRadius = 4;
+constexpr int kMinBloomLevelSize = 8;
+
+struct BlurKernel {
+    int taps = 0;
+    std::array<float, kMaxBlurTaps> offsets{};
+    std::array<float, kMaxBlurTaps> weights{};
+};
+
+// Gaussian over [-radius, radius] with sigma = radius / 2. Tap 0 is the
+// centre texel; every later tap merges two neighbouring texels into one
+// linear fetch at their weighted position, mirrored by the shader.
+BlurKernel gaussianKernel(int radius)
+{
+    radius = qBound(1, radius, kMaxBlurKernelRadius);
+    const float sigma = std::max(radius / 2.0f, 0.5f);
+
+    std::array<float, kMaxBlurKernelRadius + 2> texelWeights{};
+    float total = 0.0f;
+    for (int i = 0; i <= radius; ++i) {
+        texelWeights[static_cast<size_t>(i)] = std::exp(-(i * i) / (2.0f * sigma * sigma));
+        total += (i == 0 ? 1.0f : 2.0f) * texelWeights[static_cast<size_t>(i)];
+    }
+
+    BlurKernel kernel;
+    kernel.offsets[0] = 0.0f;
+    kernel.weights[0] = texelWeights[0] / total;
+    kernel.taps = 1;
+    for (int i = 1; i <= radius; i += 2) {
+        const float nearWeight = texelWeights[static_cast<size_t>(i)];
+        const float farWeight = texelWeights[static_cast<size_t>(i + 1)];
+        const size_t tap = static_cast<size_t>(kernel.taps++);
+        kernel.weights[tap] = (nearWeight + farWeight) / total;
+        kernel.offsets[tap] = (i * nearWeight + (i + 1) * farWeight) / (nearWeight + farWeight);
+    }
+    return kernel;
+}
+
+int blurRadiusFor(float strength, int frameHeight)
+{
+    const float radius = qBound(0.0f, strength, 1.0f) * kMaxBlurRadius * frameHeight / 1080.0f;
+    return qBound(1, qRound(radius), kMaxBlurKernelRadius);
+}
+
+std::unique_ptr<QOpenGLShaderProgram> linkProgram(const QByteArray &fragmentSource, const char *name)
+{
+    auto program = std::make_unique<QOpenGLShaderProgram>();
+    if (!program->addShaderFromSourceCode(QOpenGLShader::Vertex, kVertexShaderSource)) {
+        qWarning() << "Failed to compile" << name << "vertex shader:" << program->log();
+    }
+    if (!program->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource)) {
+        qWarning() << "Failed to compile" << name << "fragment shader:" << program->log();
+    }
+    if (!program->link()) {
+        qWarning() << "Failed to link" << name << "shader program:" << program->log();
+        return nullptr;
+    }
+    return program;
+}
+
+quint32 activeEffects(const VideoEffectsEngine::VideoEffectsSettings &settings)
+{
+    quint32 flags = 0;
+    const auto setIf = [&flags](bool active, EffectFlag flag) {
+        if (active) {
+            flags |= flag;
+        }
+    };
+
+    setIf(!qFuzzyIsNull(settings.brightness), EffectBrightness);
+    setIf(!qFuzzyIsNull(settings.contrast), EffectContrast);
+    setIf(!qFuzzyIsNull(settings.exposure), EffectExposure);
+    setIf(!qFuzzyIsNull(settings.shadows), EffectShadows);
+    setIf(!qFuzzyIsNull(settings.highlights), EffectHighlights);
+    setIf(!qFuzzyIsNull(settings.saturation), EffectSaturation);
+    setIf(!qFuzzyIsNull(settings.vibrance), EffectVibrance);
+    setIf(!qFuzzyIsNull(settings.temperature), EffectTemperature);
+    setIf(!qFuzzyIsNull(settings.tint), EffectTint);
+    setIf(settings.noise > 0.0f, EffectNoise);
+    setIf(settings.blur > 0.0f, EffectBlur);
+    setIf(settings.sharpen > 0.0f, EffectSharpen);
+    setIf(settings.glow > 0.0f, EffectGlow);
+    setIf(settings.bloom > 0.0f, EffectBloom);
+    setIf(settings.softFocus > 0.0f, EffectSoftFocus);
+    setIf(settings.duoToneIntensity > 0.0f, EffectDuoTone);
+    return flags;
+}
+
+// With no effects active this yields the passthrough variant: sample,
+// convert to RGB if needed, write.
+QByteArray fragmentShaderVariant(int inputFormat, quint32 effects)
+{
+    QByteArray source("#version 330 core\n");
+    source += "#define INPUT_FORMAT " + QByteArray::number(inputFormat) + "\n";
+    for (const EffectDefine &define : kEffectDefines) {
+        if (effects & define.flag) {
+            source += "#define ";
+            source += define.name;
+            source += "\n";
+        }
+    }
+    source += kFragmentShaderSource;
+    return source;
+}
+
+// Y'CbCr -> R'G'B' for the frame's matrix and range, applied in the shader as
+// rgb = matrix * (yuv - offset) on normalized texel values
+void yuvConversion(bool bt709, bool fullRange, QMatrix3x3 &matrix, QVector3D &offset)
+{
+    const float kr = bt709 ? 0.2126f : 0.299f;
+    const float kb = bt709 ? 0.0722f : 0.114f;
+    const float kg = 1.0f - kr - kb;
+
+    const float yScale = fullRange ? 1.0f : 255.0f / 219.0f;
+    const float cScale = fullRange ? 1.0f : 255.0f / 224.0f;
+    offset = QVector3D(fullRange ? 0.0f : 16.0f / 255.0f, 128.0f / 255.0f, 128.0f / 255.0f);
+
+    const float values[] = {
+        yScale, 0.0f,                                     cScale * 2.0f * (1.0f - kr),
+        yScale, -cScale * 2.0f * kb * (1.0f - kb) / kg,   -cScale * 2.0f * kr * (1.0f - kr) / kg,
+        yScale, cScale * 2.0f * (1.0f - kb),              0.0f
+    };
+    matrix = QMatrix3x3(values);
+}
+
+void yuvConversionFor(const QVideoFrameFormat &format, QMatrix3x3 &matrix, QVector3D &offset)
+{
+    // Webcams (and MJPEG in particular) are BT.601 unless they say otherwise
+    yuvConversion(format.colorSpace() == QVideoFrameFormat::ColorSpace_BT709,
+                  format.colorRange() == QVideoFrameFormat::ColorRange_Full,
+                  matrix, offset);
+}
+
+} // namespace
+
+VideoEffectsEngine::VideoEffectsEngine(QObject *parent)
+    : QObject(parent)
+    , m_initialized(false)
+    , m_currentImagePixelFormat(QOpenGLTexture::RGBA)
+    , m_frameCaptureTimeUs(0)
+    , m_inputFormat(InputFormat::Rgba)
+    , m_textureDirty(false)
+    , m_emitPending(false)
+    , m_effectsDirty(true)
+    , m_effectSettings(VideoEffectsSettings::defaults())
+    , m_readbackEnabled(false)
+    , m_gpuPackingEnabled(false)
+    , m_readbackLatency(1)
+    , m_program(nullptr)
+    , m_sourceProgram(nullptr)
+    , m_nextReadbackSlot(0)
+    , m_pendingReadbacks(0)
+    , m_vertexBuffer(QOpenGLBuffer::VertexBuffer)
+    , m_geometryInitialized(false)
+{
+}
+
+// GL resources must already be gone: only the owner knows whether its
+// context can still be made current here
+VideoEffectsEngine::~VideoEffectsEngine() = default;
+
+bool VideoEffectsEngine::initialize()
+{
+    if (!QOpenGLContext::currentContext()) {
+        qWarning() << "Video effects engine needs a current OpenGL context";
+        return false;
+    }
+
+    initializeOpenGLFunctions();
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+
+    cleanup();
+
+    ensureProgram();
+    ensurePassPrograms();
+    ensureGeometry();
+    m_initialized = m_copyProgram && m_blurProgram && m_combineProgram;
+    return m_initialized;
+}
+
+void VideoEffectsEngine::setVideoEffects(const VideoEffectsSettings &settings)
+{
+    if (m_effectSettings == settings) {
+        return;
+    }
+    m_effectSettings = settings;
+    m_effectsDirty = true;
+}
+
+void VideoEffectsEngine::setReadbackEnabled(bool enabled)
+{
+    m_readbackEnabled = enabled;
+    if (!enabled) {
+        // Buffers stay allocated; their contents are simply never emitted
+        for (ReadbackSlot &slot : m_readbackSlots) {
+            slot.pending = false;
+        }
+        m_pendingReadbacks = 0;
+    }
+}
+
+void VideoEffectsEngine::setGpuPacking(bool enabled, const QSize &targetSize)
+{
+    m_gpuPackingEnabled = enabled;
+    m_packedTargetSize = targetSize;
+}
+
+void VideoEffectsEngine::setReadbackLatency(int frames)
+{
+    m_readbackLatency = qBound(0, frames, kReadbackSlotCount - 1);
+}
+
+void VideoEffectsEngine::setMaxRenderSize(const QSize &size)
+{
+    if (m_maxRenderSize == size) {
+        return;
+    }
+    m_maxRenderSize = size;
+    m_effectsDirty = true;
+}
+
+void VideoEffectsEngine::setFrame(const QVideoFrame &frame, qint64 captureTimeUs)
+{
+    if (!frame.isValid()) {
+        return;
+    }
+
+    // JFIF data is full-range BT.601 YCbCr; its planes take the same route
+    // as the camera's own YUV layouts. Qt decodes what libjpeg turns down.
+    if (frame.pixelFormat() == QVideoFrameFormat::Format_Jpeg && decodeJpegFrame(frame)) {
+        m_frameCaptureTimeUs = captureTimeUs;
+        m_textureDirty = true;
+        m_emitPending = true;
+        return;
+    }
+
+    // YUV layouts the camera (or Qt's MJPEG decoder) hands us are uploaded
+    // as-is and converted in the shader; anything else goes through Qt.
+    switch (frame.pixelFormat()) {
+    case QVideoFrameFormat::Format_YUYV:
+        m_inputFormat = InputFormat::Yuyv;
+        break;
+    case QVideoFrameFormat::Format_NV12:
+        m_inputFormat = InputFormat::Nv12;
+        break;
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_YUV422P:
+        m_inputFormat = InputFormat::Planar;
+        break;
+    default:
+        m_inputFormat = InputFormat::Rgba;
+        break;
+    }
+
+    if (m_inputFormat == InputFormat::Rgba) {
+        QVideoFrame copy(frame);
+        QImage image = copy.toImage();
+        if (image.isNull()) {
+            return;
+        }
+
+        // Qt hands back one of its 32-bit layouts; upload those as they are
+        // rather than paying for another full-frame conversion. Camera
+        // frames are opaque, so premultiplied alpha changes nothing.
+        switch (image.format()) {
+        case QImage::Format_RGBA8888:
+        case QImage::Format_RGBA8888_Premultiplied:
+        case QImage::Format_RGBX8888:
+            m_currentImagePixelFormat = QOpenGLTexture::RGBA;
+            break;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        case QImage::Format_ARGB32:
+        case QImage::Format_ARGB32_Premultiplied:
+        case QImage::Format_RGB32:
+            m_currentImagePixelFormat = QOpenGLTexture::BGRA;
+            break;
+#endif
+        default:
+            image = image.convertToFormat(QImage::Format_RGBA8888);
+            m_currentImagePixelFormat = QOpenGLTexture::RGBA;
+            break;
+        }
+
+        m_currentImage = image;
+        m_currentFrame = QVideoFrame();
+        m_decodedFrame = MjpegDecoder::Frame();
+        m_frameSize = image.size();
+    } else {
+        m_currentImage = QImage();
+        m_currentFrame = frame;
+        m_decodedFrame = MjpegDecoder::Frame();
+        m_frameSize = frame.size();
+        yuvConversionFor(frame.surfaceFormat(), m_yuvMatrix, m_yuvOffset);
+    }
+
+    m_frameCaptureTimeUs = captureTimeUs;
+    m_textureDirty = true;
+    m_emitPending = true;
+}
+
+bool VideoEffectsEngine::decodeJpegFrame(const QVideoFrame &frame)
+{
+    QVideoFrame jpeg(frame);
+    if (!jpeg.map(QVideoFrame::ReadOnly)) {
+        return false;
+    }
+    MjpegDecoder::Frame decoded = m_mjpegDecoder.decode(
+        jpeg.bits(0), static_cast<size_t>(jpeg.mappedBytes(0)), m_maxDecodeSize);
+    jpeg.unmap();
+    if (decoded.isNull()) {
+        return false;
+    }
+
+    m_inputFormat = InputFormat::Planar;
+    m_decodedFrame = std::move(decoded);
+    m_currentImage = QImage();
+    m_currentFrame = QVideoFrame();
+    m_frameSize = m_decodedFrame.size;
+    yuvConversion(false, true, m_yuvMatrix, m_yuvOffset);
+    return true;
+}
+
+bool VideoEffectsEngine::render()
+{
+    if (!m_initialized || m_frameSize.isEmpty()) {
+        m_emitPending = false;
+        return false;
+    }
+
+    // Only a new frame or new settings run the effect passes again; resizes
+    // and expose events just redraw the last result
+    const QSize frameSize = renderSize();
+    const bool frameChanged = m_textureDirty;
+    const bool framebufferStale = !m_framebuffer || m_framebuffer->size() != frameSize;
+
+    ensureProgram();
+    ensurePassPrograms();
+    ensureGeometry();
+    uploadTextureIfNeeded();
+
+    if (!m_program || !m_copyProgram || !m_planeTextures[0] ||
+        !ensureFramebuffer(m_framebuffer, frameSize, true)) {
+        return false;
+    }
+
+    if (frameChanged || m_effectsDirty || framebufferStale) {
+        renderEffects(frameSize);
+        m_effectsDirty = false;
+    }
+
+    if (m_emitPending && m_readbackEnabled) {
+        if (m_gpuPackingEnabled) {
+            renderPackedFrame(frameSize);
+        } else {
+            m_framebuffer->bind();
+            queueReadback(false, frameSize, frameSize);
+            m_framebuffer->release();
+        }
+
+        // Older readbacks have had at least one frame to finish by now
+        emitCompletedReadbacks(m_readbackLatency);
+    }
+    m_emitPending = false;
+    return true;
+}
+
+void VideoEffectsEngine::ensureProgram()
+{
+    const quint32 effects = activeEffects(m_effectSettings);
+    const bool needsSource = (effects & (kBlurEffects | kGlowEffects)) != 0;
+
+    // Both lookups below may insert; make room first so the second insert
+    // can never drop the program the first one returned
+    if (m_programCache.size() + 2 > kMaxCachedPrograms) {
+        m_programCache.clear();
+    }
+
+    m_sourceProgram = needsSource ? effectProgram(0) : nullptr;
+    m_program = effectProgram(effects);
+}
+
+QOpenGLShaderProgram *VideoEffectsEngine::effectProgram(quint32 effects)
+{
+    const quint32 key = (static_cast<quint32>(m_inputFormat) << 16) | effects;
+
+    const auto cached = m_programCache.find(key);
+    if (cached != m_programCache.end()) {
+        return cached->second.get();
+    }
+
+    auto program = linkProgram(fragmentShaderVariant(static_cast<int>(m_inputFormat), effects), "effects");
+    if (!program) {
+        return nullptr;
+    }
+
+    QOpenGLShaderProgram *result = program.get();
+    m_programCache.emplace(key, std::move(program));
+    return result;
+}
+
+void VideoEffectsEngine::ensurePassPrograms()
+{
+    if (!m_copyProgram) {
+        m_copyProgram = linkProgram(kCopyFragmentShaderSource, "copy");
+    }
+    if (!m_blurProgram) {
+        m_blurProgram = linkProgram(kBlurFragmentShaderSource, "blur");
+    }
+    if (!m_combineProgram) {
+        m_combineProgram = linkProgram(kCombineFragmentShaderSource, "bloom combine");
+    }
+}
+
+void VideoEffectsEngine::ensureGeometry()
+{
+    if (m_geometryInitialized) {
+        return;
+    }
+
+    static const float vertexData[] = {
+        // position   // texCoord
+        -1.f, -1.f,   0.f, 1.f,
+         1.f, -1.f,   1.f, 1.f,
+        -1.f,  1.f,   0.f, 0.f,
+         1.f,  1.f,   1.f, 0.f
+    };
+
+    m_vertexArray.create();
+    QOpenGLVertexArrayObject::Binder binder(&m_vertexArray);
+
+    m_vertexBuffer.create();
+    m_vertexBuffer.bind();
+    m_vertexBuffer.allocate(vertexData, sizeof(vertexData));
+
+    // Every pass shares this quad through the fixed attribute locations
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                          reinterpret_cast<const void *>(2 * sizeof(float)));
+
+    m_vertexBuffer.release();
+    m_geometryInitialized = true;
+}
+
+bool VideoEffectsEngine::ensureFramebuffer(std::unique_ptr<QOpenGLFramebufferObject> &framebuffer,
+                                            const QSize &size, bool mipmapped)
+{
+    if (size.isEmpty()) {
+        framebuffer.reset();
+        return false;
+    }
+
+    if (framebuffer && framebuffer->size() == size) {
+        return true;
+    }
+
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::NoAttachment);
+    format.setTextureTarget(GL_TEXTURE_2D);
+    format.setInternalTextureFormat(GL_RGBA8);
+    format.setMipmap(mipmapped);
+
+    framebuffer = std::make_unique<QOpenGLFramebufferObject>(size, format);
+    if (!framebuffer->isValid()) {
+        qWarning() << "Failed to create framebuffer object for filter preview";
+        framebuffer.reset();
+        return false;
+    }
+    return true;
+}
+
+void VideoEffectsEngine::ensurePackProgram()
+{
+    if (!m_packProgram) {
+        m_packProgram = linkProgram(kPackFragmentShaderSource, "pack");
+    }
+}
+
+void VideoEffectsEngine::renderEffects(const QSize &frameSize)
+{
+    const quint32 effects = activeEffects(m_effectSettings);
+
+    GLuint blurTexture = 0;
+    GLuint glowTexture = 0;
+    if ((effects & (kBlurEffects | kGlowEffects)) && renderSourcePass(frameSize)) {
+        if (effects & kBlurEffects) {
+            blurTexture = renderBlurChain(frameSize);
+        }
+        if (effects & kGlowEffects) {
+            glowTexture = renderBloomChain(frameSize);
+        }
+    }
+
+    m_program->bind();
+    applySourceUniforms(*m_program);
+    applyEffectsUniforms();
+    m_program->setUniformValue("u_texelSize", QVector2D(1.0f / frameSize.width(), 1.0f / frameSize.height()));
+    m_program->setUniformValue("u_blurTexture", 3);
+    m_program->setUniformValue("u_glowTexture", 4);
+
+    bindPlaneTextures();
+    bindTexture(blurTexture, 3, GL_LINEAR);
+    bindTexture(glowTexture, 4, GL_LINEAR);
+    drawPass(*m_program, *m_framebuffer);
+    bindTexture(0, 4);
+    bindTexture(0, 3);
+    releasePlaneTextures();
+
+    m_program->release();
+    m_framebuffer->release();
+}
+
+bool VideoEffectsEngine::renderSourcePass(const QSize &frameSize)
+{
+    if (!m_sourceProgram || !ensureFramebuffer(m_sourceFramebuffer, frameSize)) {
+        return false;
+    }
+
+    // Convert and flip once so the blur passes sample a plain RGB texture
+    m_sourceProgram->bind();
+    applySourceUniforms(*m_sourceProgram);
+    m_sourceProgram->setUniformValue("u_horizontalFlip", m_effectSettings.horizontalFlip ? 1 : 0);
+    bindPlaneTextures();
+    drawPass(*m_sourceProgram, *m_sourceFramebuffer);
+    releasePlaneTextures();
+    m_sourceProgram->release();
+    return true;
+}
+
+GLuint VideoEffectsEngine::renderBlurChain(const QSize &frameSize)
+{
+    if (!m_blurProgram ||
+        !ensureFramebuffer(m_blurFramebuffers[0], frameSize) ||
+        !ensureFramebuffer(m_blurFramebuffers[1], frameSize)) {
+        return 0;
+    }
+
+    // Blur and soft focus share one blurred frame, sized by the stronger slider
+    const float strength = std::max(m_effectSettings.blur, m_effectSettings.softFocus);
+    const int radius = blurRadiusFor(strength, frameSize.height());
+
+    blurPass(m_sourceFramebuffer->texture(), *m_blurFramebuffers[0], radius, true);
+    blurPass(m_blurFramebuffers[0]->texture(), *m_blurFramebuffers[1], radius, false);
+    return m_blurFramebuffers[1]->texture();
+}
+
+GLuint VideoEffectsEngine::renderBloomChain(const QSize &frameSize)
+{
+    if (!m_blurProgram || !m_combineProgram) {
+        return 0;
+    }
+
+    // Halve the frame until it gets too small to contribute
+    int levelCount = 0;
+    QSize levelSize = frameSize;
+    while (levelCount < kMaxBloomLevels) {
+        levelSize = QSize((levelSize.width() + 1) / 2, (levelSize.height() + 1) / 2);
+        if (std::min(levelSize.width(), levelSize.height()) < kMinBloomLevelSize) {
+            break;
+        }
+        BloomLevel &level = m_bloomLevels[static_cast<size_t>(levelCount)];
+        if (!ensureFramebuffer(level.image, levelSize) || !ensureFramebuffer(level.scratch, levelSize)) {
+            return 0;
+        }
+        ++levelCount;
+    }
+    if (levelCount == 0) {
+        return 0;
+    }
+
+    // Down: a linear fetch at the centre of each 2x2 block box-filters the
+    // level above, then a small separable blur smooths it
+    GLuint previous = m_sourceFramebuffer->texture();
+    for (int i = 0; i < levelCount; ++i) {
+        BloomLevel &level = m_bloomLevels[static_cast<size_t>(i)];
+        copyPass(previous, *level.image);
+        blurPass(level.image->texture(), *level.scratch, kBloomLevelRadius, true);
+        blurPass(level.scratch->texture(), *level.image, kBloomLevelRadius, false);
+        previous = level.image->texture();
+    }
+
+    // Up: average each level with everything coarser, so every level
+    // contributes equally and the sum never clips in RGBA8
+    GLuint accumulated = m_bloomLevels[static_cast<size_t>(levelCount - 1)].image->texture();
+    m_combineProgram->bind();
+    m_combineProgram->setUniformValue("u_source", 0);
+    m_combineProgram->setUniformValue("u_coarser", 1);
+    for (int i = levelCount - 2; i >= 0; --i) {
+        BloomLevel &level = m_bloomLevels[static_cast<size_t>(i)];
+        const float coarserLevels = static_cast<float>(levelCount - 1 - i);
+        m_combineProgram->setUniformValue("u_coarserWeight", coarserLevels / (coarserLevels + 1.0f));
+        bindTexture(level.image->texture(), 0, GL_LINEAR);
+        bindTexture(accumulated, 1, GL_LINEAR);
+        drawPass(*m_combineProgram, *level.scratch);
+        accumulated = level.scratch->texture();
+    }
+    bindTexture(0, 1);
+    bindTexture(0, 0);
+    m_combineProgram->release();
+    return accumulated;
+}
+
+void VideoEffectsEngine::blurPass(GLuint source, QOpenGLFramebufferObject &target, int radius, bool horizontal)
+{
+    // Ping-pong targets always match their source in size
+    const BlurKernel kernel = gaussianKernel(radius);
+    const QSize size = target.size();
+    const QVector2D direction = horizontal
+        ? QVector2D(1.0f / size.width(), 0.0f)
+        : QVector2D(0.0f, 1.0f / size.height());
+
+    m_blurProgram->bind();
+    m_blurProgram->setUniformValue("u_source", 0);
+    m_blurProgram->setUniformValue("u_direction", direction);
+    m_blurProgram->setUniformValue("u_tapCount", kernel.taps);
+    m_blurProgram->setUniformValueArray("u_offsets", kernel.offsets.data(), kernel.taps, 1);
+    m_blurProgram->setUniformValueArray("u_weights", kernel.weights.data(), kernel.taps, 1);
+    bindTexture(source, 0, GL_LINEAR);
+    drawPass(*m_blurProgram, target);
+    bindTexture(0, 0);
+    m_blurProgram->release();
+}
+
+void VideoEffectsEngine::copyPass(GLuint source, QOpenGLFramebufferObject &target)
+{
+    m_copyProgram->bind();
+    m_copyProgram->setUniformValue("u_source", 0);
+    bindTexture(source, 0, GL_LINEAR);
+    drawPass(*m_copyProgram, target);
+    bindTexture(0, 0);
+    m_copyProgram->release();
+}
+
+void VideoEffectsEngine::downsamplePass(GLuint source, QOpenGLFramebufferObject &target)
+{
+    glBindTexture(GL_TEXTURE_2D, source);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_copyProgram->bind();
+    m_copyProgram->setUniformValue("u_source", 0);
+    // bindTexture() sets both filters, and a mipmap filter is only valid
+    // for minification; the next bind resets it
+    bindTexture(source, 0, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    drawPass(*m_copyProgram, target);
+    bindTexture(0, 0);
+    m_copyProgram->release();
+}
+
+void VideoEffectsEngine::drawPass(QOpenGLShaderProgram &program, QOpenGLFramebufferObject &target)
+{
+    // Offscreen passes draw upside down in GL terms so row 0 of every target
+    // is the top image row, matching the uploaded planes and the readback
+    program.setUniformValue("u_scale", QVector2D(1.0f, -1.0f));
+    target.bind();
+    glViewport(0, 0, target.width(), target.height());
+
+    QOpenGLVertexArrayObject::Binder binder(&m_vertexArray);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+void VideoEffectsEngine::drawOutput(const QVector2D &scale)
+{
+    if (!m_framebuffer) {
+        return;
+    }
+    drawTexture(m_framebuffer->texture(), scale);
+}
+
+void VideoEffectsEngine::drawTexture(GLuint texture, const QVector2D &scale)
+{
+    if (!m_copyProgram || !m_geometryInitialized) {
+        return;
+    }
+
+    m_copyProgram->bind();
+    m_copyProgram->setUniformValue("u_scale", scale);
+    m_copyProgram->setUniformValue("u_source", 0);
+    bindTexture(texture, 0, GL_LINEAR);
+    {
+        QOpenGLVertexArrayObject::Binder binder(&m_vertexArray);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    bindTexture(0, 0);
+    m_copyProgram->release();
+}
+
+bool VideoEffectsEngine::copyOutput(std::unique_ptr<QOpenGLFramebufferObject> &target, const QSize &maxSize)
+{
+    if (!m_framebuffer || !m_copyProgram || !m_geometryInitialized) {
+        return false;
+    }
+
+    const QSize outputSize = m_framebuffer->size();
+    QSize size = outputSize;
+    if (maxSize.isValid() && !maxSize.isEmpty() &&
+        (size.width() > maxSize.width() || size.height() > maxSize.height())) {
+        size = size.scaled(maxSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+    }
+    if (!ensureFramebuffer(target, size)) {
+        return false;
+    }
+
+    // Bilinear taps cover 2x2 texels, so anything smaller needs the mipmap
+    if (size.width() * 2 < outputSize.width() || size.height() * 2 < outputSize.height()) {
+        downsamplePass(m_framebuffer->texture(), *target);
+    } else {
+        copyPass(m_framebuffer->texture(), *target);
+    }
+    target->release();
+    return true;
+}
+
+void VideoEffectsEngine::renderPackedFrame(const QSize &frameSize)
+{
+    const QSize targetSize = m_packedTargetSize.isValid() ? m_packedTargetSize : frameSize;
+    const QSize packedSize((targetSize.width() + 1) / 2, targetSize.height());
+
+    ensurePackProgram();
+    if (!m_packProgram || !ensureFramebuffer(m_packFramebuffer, packedSize)) {
+        return;
+    }
+
+    // Fill the target and center-crop, matching the CPU forced-resolution path
+    QVector2D cropScale(1.0f, 1.0f);
+    QVector2D cropOffset(0.0f, 0.0f);
+    const bool scaled = targetSize != frameSize;
+    if (scaled) {
+        const float scale = std::max(static_cast<float>(targetSize.width()) / frameSize.width(),
+                                     static_cast<float>(targetSize.height()) / frameSize.height());
+        cropScale = QVector2D(targetSize.width() / (frameSize.width() * scale),
+                              targetSize.height() / (frameSize.height() * scale));
+        cropOffset = QVector2D((1.0f - cropScale.x()) / 2.0f, (1.0f - cropScale.y()) / 2.0f);
+    }
+
+    m_packFramebuffer->bind();
+    glViewport(0, 0, packedSize.width(), packedSize.height());
+
+    m_packProgram->bind();
+    m_packProgram->setUniformValue("u_scale", QVector2D(1.0f, 1.0f));
+    m_packProgram->setUniformValue("u_source", 0);
+    m_packProgram->setUniformValue("u_targetSize", QVector2D(targetSize.width(), targetSize.height()));
+    m_packProgram->setUniformValue("u_cropOffset", cropOffset);
+    m_packProgram->setUniformValue("u_cropScale", cropScale);
+
+    // Nearest sampling keeps unscaled output exact; linear smooths rescaling
+    bindTexture(m_framebuffer->texture(), 0, scaled ? GL_LINEAR : GL_NEAREST);
+
+    {
+        QOpenGLVertexArrayObject::Binder binder(&m_vertexArray);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    bindTexture(0, 0);
+
+    queueReadback(true, packedSize, targetSize);
+
+    m_packProgram->release();
+    m_packFramebuffer->release();
+}
+
+void VideoEffectsEngine::queueReadback(bool packed, const QSize &readSize, const QSize &frameSize)
+{
+    // At most m_readbackLatency slots stay pending, so the next one is free
+    ReadbackSlot &slot = m_readbackSlots[static_cast<size_t>(m_nextReadbackSlot)];
+    const int bytes = readSize.width() * readSize.height() * 4;
+
+    if (!slot.buffer.isCreated()) {
+        slot.buffer.create();
+        slot.buffer.setUsagePattern(QOpenGLBuffer::StreamRead);
+    }
+    slot.buffer.bind();
+    if (slot.buffer.size() != bytes) {
+        slot.buffer.allocate(bytes);
+    }
+
+    // With a pack buffer bound the read is queued on the GPU and returns at once
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, readSize.width(), readSize.height(),
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    slot.buffer.release();
+
+    slot.packed = packed;
+    slot.readSize = readSize;
+    slot.frameSize = frameSize;
+    slot.captureTimeUs = m_frameCaptureTimeUs;
+    slot.pending = true;
+
+    m_nextReadbackSlot = (m_nextReadbackSlot + 1) % kReadbackSlotCount;
+    ++m_pendingReadbacks;
+}
+
+void VideoEffectsEngine::emitCompletedReadbacks(int maxPending)
+{
+    while (m_pendingReadbacks > maxPending) {
+        const int oldest = (m_nextReadbackSlot - m_pendingReadbacks + kReadbackSlotCount) % kReadbackSlotCount;
+        --m_pendingReadbacks;
+        emitReadback(m_readbackSlots[static_cast<size_t>(oldest)]);
+    }
+}
+
+void VideoEffectsEngine::emitReadback(ReadbackSlot &slot)
+{
+    if (!slot.pending) {
+        return;
+    }
+    slot.pending = false;
+
+    const int stride = slot.readSize.width() * 4;
+    const int bytes = stride * slot.readSize.height();
+
+    slot.buffer.bind();
+    const auto *mapped = static_cast<const uchar *>(
+        slot.buffer.mapRange(0, bytes, QOpenGLBuffer::RangeRead));
+    if (!mapped) {
+        qWarning() << "Failed to map readback buffer";
+        slot.buffer.release();
+        return;
+    }
+
+    if (slot.packed) {
+        PackedFrame frame;
+        frame.format = PackedFrame::Format::Yuyv;
+        frame.size = slot.frameSize;
+        frame.stride = stride;
+        frame.data = FramePool::instance().acquire(bytes);
+        frame.captureTimeUs = slot.captureTimeUs;
+        std::memcpy(frame.data.data(), mapped, static_cast<size_t>(bytes));
+        slot.buffer.unmap();
+        slot.buffer.release();
+        emit packedFrameReady(frame);
+        return;
+    }
+
+    // Rows of a 4-byte format are never padded, so one copy fills the image
+    QImage output = FramePool::instance().acquireImage(slot.readSize, QImage::Format_RGBA8888);
+    std::memcpy(output.bits(), mapped, static_cast<size_t>(bytes));
+    slot.buffer.unmap();
+    slot.buffer.release();
+    emit processedFrameReady(output, slot.captureTimeUs);
+}
+
+void VideoEffectsEngine::uploadTextureIfNeeded()
+{
+    if (!m_textureDirty) {
+        return;
+    }
+
+    if (!m_decodedFrame.isNull()) {
+        uploadDecodedPlanes();
+        // The pooled buffer can take the next decode
+        m_decodedFrame = MjpegDecoder::Frame();
+        m_textureDirty = false;
+        return;
+    }
+
+    if (m_inputFormat != InputFormat::Rgba) {
+        if (!uploadVideoFramePlanes()) {
+            qWarning() << "Failed to map video frame for upload";
+        }
+        // Let the camera recycle its buffer as soon as the planes are on the GPU
+        m_currentFrame = QVideoFrame();
+        m_textureDirty = false;
+        return;
+    }
+
+    if (m_currentImage.isNull()) {
+        return;
+    }
+
+    // Rows go up in QImage order (top first); the shaders address them that way
+    uploadPlane(0, QOpenGLTexture::RGBA8_UNorm, m_currentImagePixelFormat, m_currentImage.size(),
+                m_currentImage.constBits(), m_currentImage.bytesPerLine() / 4);
+    m_textureDirty = false;
+}
+
+bool VideoEffectsEngine::uploadVideoFramePlanes()
+{
+    if (!m_currentFrame.isValid() || !m_currentFrame.map(QVideoFrame::ReadOnly)) {
+        return false;
+    }
+
+    const QSize size = m_currentFrame.size();
+    const QSize halfWidth((size.width() + 1) / 2, size.height());
+    const QSize halfBoth((size.width() + 1) / 2, (size.height() + 1) / 2);
+
+    switch (m_inputFormat) {
+    case InputFormat::Yuyv:
+        uploadPlane(0, QOpenGLTexture::RG8_UNorm, QOpenGLTexture::RG, size,
+                    m_currentFrame.bits(0), m_currentFrame.bytesPerLine(0) / 2);
+        break;
+    case InputFormat::Nv12:
+        uploadPlane(0, QOpenGLTexture::R8_UNorm, QOpenGLTexture::Red, size,
+                    m_currentFrame.bits(0), m_currentFrame.bytesPerLine(0));
+        uploadPlane(1, QOpenGLTexture::RG8_UNorm, QOpenGLTexture::RG, halfBoth,
+                    m_currentFrame.bits(1), m_currentFrame.bytesPerLine(1) / 2);
+        break;
+    case InputFormat::Planar: {
+        const QSize chromaSize = m_currentFrame.pixelFormat() == QVideoFrameFormat::Format_YUV422P
+            ? halfWidth
+            : halfBoth;
+        uploadPlane(0, QOpenGLTexture::R8_UNorm, QOpenGLTexture::Red, size,
+                    m_currentFrame.bits(0), m_currentFrame.bytesPerLine(0));
+        uploadPlane(1, QOpenGLTexture::R8_UNorm, QOpenGLTexture::Red, chromaSize,
+                    m_currentFrame.bits(1), m_currentFrame.bytesPerLine(1));
+        uploadPlane(2, QOpenGLTexture::R8_UNorm, QOpenGLTexture::Red, chromaSize,
+                    m_currentFrame.bits(2), m_currentFrame.bytesPerLine(2));
+        break;
+    }
+    case InputFormat::Rgba:
+        break;
+    }
+
+    m_currentFrame.unmap();
+    return true;
+}
+
+void VideoEffectsEngine::uploadDecodedPlanes()
+{
+    // Rows are padded to whole DCT blocks; the textures cover only the image
+    const MjpegDecoder::Frame &frame = m_decodedFrame;
+    uploadPlane(0, QOpenGLTexture::R8_UNorm, QOpenGLTexture::Red, frame.size,
+                frame.plane(0), frame.stride[0]);
+    uploadPlane(1, QOpenGLTexture::R8_UNorm, QOpenGLTexture::Red, frame.chromaSize,
+                frame.plane(1), frame.stride[1]);
+    uploadPlane(2, QOpenGLTexture::R8_UNorm, QOpenGLTexture::Red, frame.chromaSize,
+                frame.plane(2), frame.stride[2]);
+}
+
+void VideoEffectsEngine::uploadPlane(int plane, QOpenGLTexture::TextureFormat format,
+                                      QOpenGLTexture::PixelFormat pixelFormat, const QSize &size,
+                                      const uchar *data, int rowLength)
+{
+    std::unique_ptr<QOpenGLTexture> &texture = m_planeTextures[static_cast<size_t>(plane)];
+    if (!texture) {
+        texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+    }
+
+    if (!texture->isCreated() ||
+        texture->format() != format ||
+        texture->width() != size.width() ||
+        texture->height() != size.height()) {
+        texture->destroy();
+        texture->create();
+        texture->bind();
+        texture->setFormat(format);
+        texture->setSize(size.width(), size.height());
+        texture->setMipLevels(1);
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+        texture->setMinificationFilter(QOpenGLTexture::Linear);
+        texture->setMagnificationFilter(QOpenGLTexture::Linear);
+        texture->allocateStorage(pixelFormat, QOpenGLTexture::UInt8);
+    } else {
+        texture->bind();
+    }
+
+    // Upload straight from the mapped frame, honouring its row padding
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+                    size.width(), size.height(),
+                    static_cast<GLenum>(pixelFormat), GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    texture->release();
+}
+
+void VideoEffectsEngine::bindPlaneTextures()
+{
+    for (size_t i = 0; i < m_planeTextures.size(); ++i) {
+        if (m_planeTextures[i]) {
+            m_planeTextures[i]->bind(static_cast<uint>(i));
+        }
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void VideoEffectsEngine::releasePlaneTextures()
+{
+    for (size_t i = 0; i < m_planeTextures.size(); ++i) {
+        if (m_planeTextures[i]) {
+            m_planeTextures[i]->release(static_cast<uint>(i));
+        }
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void VideoEffectsEngine::bindTexture(GLuint texture, int unit, GLint filter)
+{
+    glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (texture != 0) {
+        // Framebuffer textures are shared by passes that want different filtering
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void VideoEffectsEngine::applySourceUniforms(QOpenGLShaderProgram &program)
+{
+    program.setUniformValue("u_texture", 0);
+    program.setUniformValue("u_plane1", 1);
+    program.setUniformValue("u_plane2", 2);
+    program.setUniformValue("u_yuvMatrix", m_yuvMatrix);
+    program.setUniformValue("u_yuvOffset", m_yuvOffset);
+}
+
+void VideoEffectsEngine::cleanup()
+{
+    for (std::unique_ptr<QOpenGLTexture> &texture : m_planeTextures) {
+        if (texture) {
+            texture->destroy();
+            texture.reset();
+        }
+    }
+    m_framebuffer.reset();
+    m_sourceFramebuffer.reset();
+    for (std::unique_ptr<QOpenGLFramebufferObject> &framebuffer : m_blurFramebuffers) {
+        framebuffer.reset();
+    }
+    for (BloomLevel &level : m_bloomLevels) {
+        level.image.reset();
+        level.scratch.reset();
+    }
+    m_packFramebuffer.reset();
+    for (ReadbackSlot &slot : m_readbackSlots) {
+        if (slot.buffer.isCreated()) {
+            slot.buffer.destroy();
+        }
+        slot.pending = false;
+    }
+    m_nextReadbackSlot = 0;
+    m_pendingReadbacks = 0;
+    if (m_vertexBuffer.isCreated()) {
+        m_vertexBuffer.destroy();
+    }
+    if (m_vertexArray.isCreated()) {
+        m_vertexArray.destroy();
+    }
+    m_program = nullptr;
+    m_sourceProgram = nullptr;
+    m_programCache.clear();
+    m_copyProgram.reset();
+    m_blurProgram.reset();
+    m_combineProgram.reset();
+    m_packProgram.reset();
+    m_geometryInitialized = false;
+    m_effectsDirty = true;
+    m_initialized = false;
+}
+
+void VideoEffectsEngine::applyEffectsUniforms()
+{
+    if (!m_program) {
+        return;
+    }
+
+    const auto clamp01 = [](float value) {
+        return qBound(0.0f, value, 1.0f);
+    };
+
+    m_program->setUniformValue("u_brightness", m_effectSettings.brightness);
+    m_program->setUniformValue("u_contrast", m_effectSettings.contrast);
+    m_program->setUniformValue("u_exposure", m_effectSettings.exposure);
+    m_program->setUniformValue("u_highlights", m_effectSettings.highlights);
+    m_program->setUniformValue("u_shadows", m_effectSettings.shadows);
+    m_program->setUniformValue("u_saturation", m_effectSettings.saturation);
+    m_program->setUniformValue("u_vibrance", m_effectSettings.vibrance);
+    m_program->setUniformValue("u_temperature", m_effectSettings.temperature);
+    m_program->setUniformValue("u_tint", m_effectSettings.tint);
+    m_program->setUniformValue("u_noise", clamp01(m_effectSettings.noise));
+    m_program->setUniformValue("u_blur", clamp01(m_effectSettings.blur));
+    m_program->setUniformValue("u_sharpen", clamp01(m_effectSettings.sharpen));
+    m_program->setUniformValue("u_glow", clamp01(m_effectSettings.glow));
+    m_program->setUniformValue("u_bloom", clamp01(m_effectSettings.bloom));
+    m_program->setUniformValue("u_softFocus", clamp01(m_effectSettings.softFocus));
+    m_program->setUniformValue("u_duoToneIntensity", clamp01(m_effectSettings.duoToneIntensity));
+
+    QVector3D shadowColor = srgbColorToLinearVec3(m_effectSettings.duoToneShadow);
+    QVector3D highlightColor = srgbColorToLinearVec3(m_effectSettings.duoToneHighlight);
+    m_program->setUniformValue("u_duoToneShadow", shadowColor);
+    m_program->setUniformValue("u_duoToneHighlight", highlightColor);
+    m_program->setUniformValue("u_horizontalFlip", m_effectSettings.horizontalFlip ? 1 : 0);
+}
+
+QVector3D VideoEffectsEngine::srgbColorToLinearVec3(const QColor &color) const
+{
+    auto toLinear = [](float channel) {
+        if (channel <= 0.04045f) {
+            return channel / 12.92f;
+        }
+        return std::pow((channel + 0.055f) / 1.055f, 2.4f);
+    };
+    return QVector3D(
+        toLinear(color.redF()),
+        toLinear(color.greenF()),
+        toLinear(color.blueF()));
+}
+
+QSize VideoEffectsEngine::renderSize() const
+{
+    if (!m_maxRenderSize.isValid() || m_maxRenderSize.isEmpty() ||
+        (m_frameSize.width() <= m_maxRenderSize.width() && m_frameSize.height() <= m_maxRenderSize.height())) {
+        return m_frameSize;
+    }
+    return m_frameSize.scaled(m_maxRenderSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+}
@@ -0,0 +1,261 @@
+#ifndef VIDEOEFFECTSENGINE_H
+#define VIDEOEFFECTSENGINE_H
+
+#include <QColor>
+#include <QGenericMatrix>
+#include <QImage>
+#include <QObject>
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QOpenGLVertexArrayObject>
+#include <QVector2D>
+#include <QVideoFrame>
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <QtGlobal>
+#include <QVector3D>
+#include "MjpegDecoder.h"
+#include "PackedFrame.h"
+
+/**
+ * @brief The video effects render graph, independent of any widget or window.
+ *
+ * Uploads camera frames (RGBA or YUV planes; MJPEG is decoded to YUV planes
+ * by MjpegDecoder), runs the effect passes into an offscreen framebuffer and
+ * optionally reads the result back as a QImage or a GPU-packed YUYV frame. The engine does not own a context: every call
+ * except the settings setters needs the context it was initialized with to
+ * be current on the calling thread. OffscreenEffectsEngine drives it on a
+ * worker thread; FilterPreviewWidget uses it to draw those results and only
+ * renders frames itself when the worker's textures cannot be shared.
+ */
+class VideoEffectsEngine : public QObject, protected QOpenGLFunctions
+{
+    Q_OBJECT
+
+public:
+    struct VideoEffectsSettings {
+        float brightness = 0.0f;      // -1.0 to 1.0
+        float contrast = 0.0f;        // -1.0 to 1.0
+        float exposure = 0.0f;        // -2.0 to 2.0
+        float highlights = 0.0f;      // -1.0 to 1.0
+        float shadows = 0.0f;         // -1.0 to 1.0
+        float saturation = 0.0f;      // -1.0 to 1.0
+        float vibrance = 0.0f;        // -1.0 to 1.0
+        float temperature = 0.0f;     // -1.0 to 1.0
+        float tint = 0.0f;            // -1.0 to 1.0
+        float noise = 0.0f;           // 0.0 to 1.0
+        float blur = 0.0f;            // 0.0 to 1.0
+        float sharpen = 0.0f;         // 0.0 to 1.0
+        float glow = 0.0f;            // 0.0 to 1.0
+        float bloom = 0.0f;           // 0.0 to 1.0
+        float softFocus = 0.0f;       // 0.0 to 1.0
+        float duoToneIntensity = 0.0f; // 0.0 to 1.0
+        QColor duoToneShadow = QColor(30, 30, 60);
+        QColor duoToneHighlight = QColor(220, 180, 160);
+        bool horizontalFlip = false;
+
+        bool operator==(const VideoEffectsSettings &other) const
+        {
+            return qFuzzyCompare(1.0f + brightness, 1.0f + other.brightness)
+                && qFuzzyCompare(1.0f + contrast, 1.0f + other.contrast)
+                && qFuzzyCompare(1.0f + exposure, 1.0f + other.exposure)
+                && qFuzzyCompare(1.0f + highlights, 1.0f + other.highlights)
+                && qFuzzyCompare(1.0f + shadows, 1.0f + other.shadows)
+                && qFuzzyCompare(1.0f + saturation, 1.0f + other.saturation)
+                && qFuzzyCompare(1.0f + vibrance, 1.0f + other.vibrance)
+                && qFuzzyCompare(1.0f + temperature, 1.0f + other.temperature)
+                && qFuzzyCompare(1.0f + tint, 1.0f + other.tint)
+                && qFuzzyCompare(1.0f + noise, 1.0f + other.noise)
+                && qFuzzyCompare(1.0f + blur, 1.0f + other.blur)
+                && qFuzzyCompare(1.0f + sharpen, 1.0f + other.sharpen)
+                && qFuzzyCompare(1.0f + glow, 1.0f + other.glow)
+                && qFuzzyCompare(1.0f + bloom, 1.0f + other.bloom)
+                && qFuzzyCompare(1.0f + softFocus, 1.0f + other.softFocus)
+                && qFuzzyCompare(1.0f + duoToneIntensity, 1.0f + other.duoToneIntensity)
+                && duoToneShadow == other.duoToneShadow
+                && duoToneHighlight == other.duoToneHighlight
+                && horizontalFlip == other.horizontalFlip;
+        }
+
+        bool operator!=(const VideoEffectsSettings &other) const
+        {
+            return !(*this == other);
+        }
+
+        static VideoEffectsSettings defaults() { return VideoEffectsSettings{}; }
+    };
+
+    explicit VideoEffectsEngine(QObject *parent = nullptr);
+    ~VideoEffectsEngine() override;
+
+    // Resolve GL functions and build the programs and geometry for the
+    // current context. cleanup() releases everything while it is current.
+    bool initialize();
+    void cleanup();
+    bool isInitialized() const { return m_initialized; }
+
+    void setVideoEffects(const VideoEffectsSettings &settings);
+    VideoEffectsSettings videoEffects() const { return m_effectSettings; }
+
+    // Hold a frame for the next render(). Does not touch GL. The capture
+    // time (FrameClock) is handed back with the frame's readback.
+    void setFrame(const QVideoFrame &frame, qint64 captureTimeUs = 0);
+    QSize frameSize() const { return m_frameSize; }
+
+    // MJPEG frames larger than this are reduced in the IDCT, by 1/2, 1/4 or
+    // 1/8 while they still cover it. Invalid (the default) decodes in full.
+    void setMaxDecodeSize(const QSize &size) { m_maxDecodeSize = size; }
+
+    // Run the effect passes, and any readback, at most at this size with the
+    // frame's aspect ratio kept. Invalid (the default) renders at the frame
+    // size. Meant for display-only use, where the output never needs more
+    // pixels than the screen shows.
+    void setMaxRenderSize(const QSize &size);
+
+    // Emit every newly rendered frame through processedFrameReady or
+    // packedFrameReady. Off by default; display-only users skip the readback.
+    void setReadbackEnabled(bool enabled);
+
+    // Pack processed frames to YUYV on the GPU before readback. The target
+    // size is filled and center-cropped; an invalid size keeps the frame size.
+    void setGpuPacking(bool enabled, const QSize &targetSize = QSize());
+
+    // Frames of delay between rendering a frame and emitting it. 0 reads back
+    // synchronously; 1-2 let the pixel-pack transfer overlap later frames.
+    void setReadbackLatency(int frames);
+    int readbackLatency() const { return m_readbackLatency; }
+
+    // Upload the pending frame and re-run the effect passes if the frame or
+    // settings changed. Returns false while there is nothing to show.
+    bool render();
+
+    // Draw the last rendered frame into the bound framebuffer and viewport.
+    // A scale above 1 on an axis shrinks the image on that axis (letterboxing).
+    void drawOutput(const QVector2D &scale);
+
+    // Same as drawOutput() for a texture rendered elsewhere in the share
+    // group, laid out like the engine's output (row 0 is the top row)
+    void drawTexture(GLuint texture, const QVector2D &scale);
+
+    // Copy the last rendered frame into target, (re)allocating it at the
+    // frame size, in the top-row-first layout that drawTexture() expects.
+    // A valid maxSize shrinks the copy to fit it, filtered through a mipmap
+    // of the output once the reduction passes 2x.
+    bool copyOutput(std::unique_ptr<QOpenGLFramebufferObject> &target, const QSize &maxSize = QSize());
+
+signals:
+    void processedFrameReady(const QImage &frame, qint64 captureTimeUs);
+    void packedFrameReady(const PackedFrame &frame);
+
+private:
+    // Layout of the textures sampled by the effects shader
+    enum class InputFormat {
+        Rgba = 0,     // Plane 0: RGBA8
+        Yuyv = 1,     // Plane 0: RG8 at full width (R = Y, G = U/V alternating)
+        Nv12 = 2,     // Plane 0: Y, plane 1: interleaved UV
+        Planar = 3    // Planes 0-2: Y, U, V (4:2:0 or 4:2:2)
+    };
+
+    struct ReadbackSlot {
+        QOpenGLBuffer buffer{QOpenGLBuffer::PixelPackBuffer};
+        bool packed = false;
+        QSize readSize;   // Texels read from the framebuffer
+        QSize frameSize;  // Pixel size of the emitted frame
+        qint64 captureTimeUs = 0;
+        bool pending = false;
+    };
+
+    // One level of the bloom mip chain plus a scratch target for its
+    // horizontal blur pass and the upsample blend
+    struct BloomLevel {
+        std::unique_ptr<QOpenGLFramebufferObject> image;
+        std::unique_ptr<QOpenGLFramebufferObject> scratch;
+    };
+
+    void ensureProgram();
+    QOpenGLShaderProgram *effectProgram(quint32 effects);
+    void ensurePassPrograms();
+    void ensureGeometry();
+    bool ensureFramebuffer(std::unique_ptr<QOpenGLFramebufferObject> &framebuffer, const QSize &size,
+                           bool mipmapped = false);
+    void ensurePackProgram();
+
+    // Render graph: source -> blur / bloom chains -> effects -> m_framebuffer,
+    // which then feeds the display, the readback and the packing pass
+    void renderEffects(const QSize &frameSize);
+    bool renderSourcePass(const QSize &frameSize);
+    GLuint renderBlurChain(const QSize &frameSize);
+    GLuint renderBloomChain(const QSize &frameSize);
+    void blurPass(GLuint source, QOpenGLFramebufferObject &target, int radius, bool horizontal);
+    void copyPass(GLuint source, QOpenGLFramebufferObject &target);
+    void downsamplePass(GLuint source, QOpenGLFramebufferObject &target);
+    void drawPass(QOpenGLShaderProgram &program, QOpenGLFramebufferObject &target);
+    void renderPackedFrame(const QSize &frameSize);
+    void queueReadback(bool packed, const QSize &readSize, const QSize &frameSize);
+    void emitCompletedReadbacks(int maxPending);
+    void emitReadback(ReadbackSlot &slot);
+    bool decodeJpegFrame(const QVideoFrame &frame);
+    void uploadTextureIfNeeded();
+    bool uploadVideoFramePlanes();
+    void uploadDecodedPlanes();
+    void uploadPlane(int plane, QOpenGLTexture::TextureFormat format,
+                     QOpenGLTexture::PixelFormat pixelFormat, const QSize &size,
+                     const uchar *data, int rowLength);
+    void bindPlaneTextures();
+    void releasePlaneTextures();
+    void bindTexture(GLuint texture, int unit, GLint filter = GL_LINEAR);
+    void applySourceUniforms(QOpenGLShaderProgram &program);
+    void applyEffectsUniforms();
+    QVector3D srgbColorToLinearVec3(const QColor &color) const;
+    QSize renderSize() const;
+
+    bool m_initialized;
+    QImage m_currentImage;        // Frames Qt has to convert for us
+    QOpenGLTexture::PixelFormat m_currentImagePixelFormat;  // RGBA or BGRA byte order
+    QVideoFrame m_currentFrame;   // YUV frames, held until their planes are uploaded
+    MjpegDecoder m_mjpegDecoder;
+    MjpegDecoder::Frame m_decodedFrame;  // Decoded MJPEG planes, held until uploaded
+    QSize m_maxDecodeSize;
+    QSize m_maxRenderSize;
+    QSize m_frameSize;
+    qint64 m_frameCaptureTimeUs;
+    InputFormat m_inputFormat;
+    QMatrix3x3 m_yuvMatrix;
+    QVector3D m_yuvOffset;
+    bool m_textureDirty;
+    bool m_emitPending;
+    bool m_effectsDirty;          // Settings changed since m_framebuffer was rendered
+    VideoEffectsSettings m_effectSettings;
+    bool m_readbackEnabled;
+    bool m_gpuPackingEnabled;
+    QSize m_packedTargetSize;
+    int m_readbackLatency;
+
+    QOpenGLShaderProgram *m_program;        // Variant for the current input format and effects
+    QOpenGLShaderProgram *m_sourceProgram;  // Passthrough variant feeding the blur chains
+    std::unordered_map<quint32, std::unique_ptr<QOpenGLShaderProgram>> m_programCache;
+    std::unique_ptr<QOpenGLShaderProgram> m_copyProgram;
+    std::unique_ptr<QOpenGLShaderProgram> m_blurProgram;
+    std::unique_ptr<QOpenGLShaderProgram> m_combineProgram;
+    std::array<std::unique_ptr<QOpenGLTexture>, 3> m_planeTextures;
+    std::unique_ptr<QOpenGLFramebufferObject> m_framebuffer;        // Processed frame, top row first, mipmapped
+    std::unique_ptr<QOpenGLFramebufferObject> m_sourceFramebuffer;  // RGB frame before effects
+    std::array<std::unique_ptr<QOpenGLFramebufferObject>, 2> m_blurFramebuffers;
+    static constexpr int kMaxBloomLevels = 5;
+    std::array<BloomLevel, kMaxBloomLevels> m_bloomLevels;
+    std::unique_ptr<QOpenGLShaderProgram> m_packProgram;
+    std::unique_ptr<QOpenGLFramebufferObject> m_packFramebuffer;
+    static constexpr int kReadbackSlotCount = 3;
+    std::array<ReadbackSlot, kReadbackSlotCount> m_readbackSlots;
+    int m_nextReadbackSlot;
+    int m_pendingReadbacks;
+    QOpenGLBuffer m_vertexBuffer;
+    QOpenGLVertexArrayObject m_vertexArray;
+    bool m_geometryInitialized;
+};
+
+#endif // VIDEOEFFECTSENGINE_H
@@ -0,0 +1,113 @@
+#include "VirtualCameraOutputs.h"
+
+#include "SharedConversion.h"
+
+#include <algorithm>
+#include <memory>
+
+VirtualCameraOutputs::VirtualCameraOutputs(QObject *parent)
+    : QObject(parent)
+    , m_enabled(false)
+    , m_threadCount(0)
+    , m_outputFrameRate(0)
+{
+}
+
+VirtualCameraOutputs::~VirtualCameraOutputs()
+{
+    // Each streamer stops its worker thread before it goes away
+    qDeleteAll(m_streamers);
+    m_streamers.clear();
+}
+
+void VirtualCameraOutputs::setSinks(const QList<Sink> &sinks)
+{
+    m_sinks = sinks;
+
+    while (m_streamers.size() > m_sinks.size()) {
+        delete m_streamers.takeLast();
+    }
+    while (m_streamers.size() < m_sinks.size()) {
+        m_streamers.append(createStreamer());
+    }
+
+    for (qsizetype i = 0; i < m_sinks.size(); ++i) {
+        VirtualCameraStreamer *streamer = m_streamers.at(i);
+        const Sink &sink = m_sinks.at(i);
+        streamer->setDevicePath(sink.devicePath);
+        streamer->setForcedResolution(sink.forcedResolution);
+        streamer->setOutputFormat(sink.format);
+        streamer->setEnabled(m_enabled);
+    }
+}
+
+bool VirtualCameraOutputs::isEnabled() const
+{
+    return std::any_of(m_streamers.cbegin(), m_streamers.cend(),
+                       [](const VirtualCameraStreamer *streamer) { return streamer->isEnabled(); });
+}
+
+void VirtualCameraOutputs::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    for (VirtualCameraStreamer *streamer : m_streamers) {
+        streamer->setEnabled(enabled);
+    }
+}
+
+void VirtualCameraOutputs::setThreadCount(int threads)
+{
+    m_threadCount = std::max(0, threads);
+    for (VirtualCameraStreamer *streamer : m_streamers) {
+        streamer->setThreadCount(m_threadCount);
+    }
+}
+
+void VirtualCameraOutputs::setOutputFrameRate(int fps)
+{
+    m_outputFrameRate = std::max(0, fps);
+    for (VirtualCameraStreamer *streamer : m_streamers) {
+        streamer->setOutputFrameRate(m_outputFrameRate);
+    }
+}
+
+void VirtualCameraOutputs::onProcessedFrameReady(const QImage &frame, qint64 captureTimeUs)
+{
+    if (frame.isNull()) {
+        return;
+    }
+
+    // Sharing only pays off once a second sink takes the frame
+    std::shared_ptr<SharedConversion> shared;
+    const auto activeSinks = std::count_if(m_streamers.cbegin(), m_streamers.cend(),
+        [](const VirtualCameraStreamer *streamer) { return streamer->isEnabled(); });
+    if (activeSinks > 1) {
+        shared = std::make_shared<SharedConversion>();
+        for (const VirtualCameraStreamer *streamer : m_streamers) {
+            if (streamer->isEnabled()) {
+                shared->addSink(streamer->forcedResolution(), streamer->outputFormat());
+            }
+        }
+    }
+
+    for (VirtualCameraStreamer *streamer : m_streamers) {
+        streamer->submitFrame(frame, captureTimeUs, shared);
+    }
+}
+
+void VirtualCameraOutputs::onPackedFrameReady(const PackedFrame &frame)
+{
+    for (VirtualCameraStreamer *streamer : m_streamers) {
+        streamer->onPackedFrameReady(frame);
+    }
+}
+
+VirtualCameraStreamer *VirtualCameraOutputs::createStreamer()
+{
+    auto *streamer = new VirtualCameraStreamer(this);
+    streamer->setThreadCount(m_threadCount);
+    streamer->setOutputFrameRate(m_outputFrameRate);
+    connect(streamer, &VirtualCameraStreamer::errorOccurred,
+            this, &VirtualCameraOutputs::errorOccurred);
+    return streamer;
+}
@@ -0,0 +1,64 @@
+#ifndef VIRTUALCAMERAOUTPUTS_H
+#define VIRTUALCAMERAOUTPUTS_H
+
+#include <QList>
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include "PackedFrame.h"
+#include "VirtualCameraStreamer.h"
+
+/**
+ * @brief Feeds one processed frame to several virtual camera devices.
+ *
+ * Every sink is a VirtualCameraStreamer with its own worker thread, device,
+ * resolution and pixel format, so a slow consumer on one device does not
+ * hold up the others. When two or more sinks are configured, each frame is
+ * handed out with a SharedConversion: sinks with the same resolution scale
+ * it once, and sinks that also share the pixel format convert it once.
+ * The first sink is the primary output configured in the main window.
+ */
+class VirtualCameraOutputs : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Sink {
+        QString devicePath;
+        QSize forcedResolution;   // Invalid follows the processed frame
+        VirtualCameraStreamer::OutputFormat format = VirtualCameraStreamer::OutputFormat::Yuyv;
+    };
+
+    explicit VirtualCameraOutputs(QObject *parent = nullptr);
+    ~VirtualCameraOutputs() override;
+
+    // Existing streamers are reconfigured in place; surplus ones are shut down
+    void setSinks(const QList<Sink> &sinks);
+    QList<Sink> sinks() const { return m_sinks; }
+    const QList<VirtualCameraStreamer *> &streamers() const { return m_streamers; }
+
+    // True while any sink is streaming
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+    void setThreadCount(int threads);
+    void setOutputFrameRate(int fps);
+
+public slots:
+    void onProcessedFrameReady(const QImage &frame, qint64 captureTimeUs = 0);
+    void onPackedFrameReady(const PackedFrame &frame);
+
+signals:
+    void errorOccurred(const QString &message);
+
+private:
+    VirtualCameraStreamer *createStreamer();
+
+    QList<Sink> m_sinks;
+    QList<VirtualCameraStreamer *> m_streamers;
+    bool m_enabled;
+    int m_threadCount;
+    int m_outputFrameRate;
+};
+
+#endif // VIRTUALCAMERAOUTPUTS_H
@@ -1,105 +1,166 @@
 #include "VirtualCameraStreamer.h"
 
+#include "FrameClock.h"
+#include "FramePool.h"
+#include "FrameRing.h"
+#include "FrameScaler.h"
+#include "SharedConversion.h"
+#include "SliceWorkerPool.h"
+#include "YuvConverter.h"
+
+#include <QBuffer>
 #include <QByteArray>
+#include <QElapsedTimer>
 #include <QImage>
+#include <QImageWriter>
 #include <QLoggingCategory>
 #include <QMetaObject>
 #include <QMetaType>
-#include <QQueue>
+#include <QSocketNotifier>
 #include <QThread>
+#include <QTimer>
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <deque>
 #include <fcntl.h>
 #include <linux/videodev2.h>
+#include <memory>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <vector>
 
 Q_LOGGING_CATEGORY(VirtualCameraLog, "obsbot.virtualcamera")
 
 namespace {
 
 constexpr const char *kDefaultDevicePath = "/dev/video42";
+constexpr unsigned int kMappedBufferCount = 4;
+constexpr int kBufferWaitTimeoutMs = 100;
+constexpr int kMjpegQuality = 85;
+constexpr qint64 kNanosecondsPerSecond = 1000000000;
+constexpr qint64 kStatsIntervalNs = 2 * kNanosecondsPerSecond;
+// Frames in flight between the submitting thread and a worker
+constexpr std::size_t kFrameRingSlots = 4;
 
 QString errnoString()
 {
     return QString::fromLocal8Bit(strerror(errno));
 }
 
-inline uint8_t clampToByte(int value)
+bool convertRgbToYuyv(const QImage &image, uint8_t *dst, int dstStride, SliceWorkerPool &pool)
 {
-    if (value < 0) {
-        return 0;
-    }
-    if (value > 255) {
-        return 255;
+    if (image.isNull() || !dst) {
+        return false;
     }
-    return static_cast<uint8_t>(value);
-}
 
-struct YuvComponents {
-    uint8_t y;
-    uint8_t u;
-    uint8_t v;
-};
+    pool.run(image.height(), 1, [&](int firstRow, int endRow) {
+        YuvConverter::convertRgbToYuyv(image.constScanLine(firstRow), image.bytesPerLine(),
+                                       image.width(), endRow - firstRow,
+                                       dst + static_cast<size_t>(firstRow) * dstStride, dstStride);
+    });
+    return true;
+}
 
-YuvComponents rgbToYuv(uint8_t r, uint8_t g, uint8_t b)
+// Bands start on even rows so each one owns whole chroma rows
+bool convertRgbToNv12(const QImage &image, uint8_t *yPlane, int yStride,
+                      uint8_t *uvPlane, int uvStride, SliceWorkerPool &pool)
 {
-    // BT.601 conversion with integer math
-    const int y = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
-    const int u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
-    const int v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+    if (image.isNull() || !yPlane || !uvPlane) {
+        return false;
+    }
 
-    return {clampToByte(y), clampToByte(u), clampToByte(v)};
+    pool.run(image.height(), 2, [&](int firstRow, int endRow) {
+        YuvConverter::convertRgbToNv12(image.constScanLine(firstRow), image.bytesPerLine(),
+                                       image.width(), endRow - firstRow,
+                                       yPlane + static_cast<size_t>(firstRow) * yStride, yStride,
+                                       uvPlane + static_cast<size_t>(firstRow / 2) * uvStride, uvStride);
+    });
+    return true;
 }
 
-bool convertRgbToYuyv(const QImage &image, QByteArray &outBuffer)
+bool convertRgbToI420(const QImage &image, uint8_t *yPlane, int yStride,
+                      uint8_t *uPlane, uint8_t *vPlane, int chromaStride, SliceWorkerPool &pool)
 {
-    const int width = image.width();
-    const int height = image.height();
-    if (width <= 0 || height <= 0) {
+    if (image.isNull() || !yPlane || !uPlane || !vPlane) {
         return false;
     }
 
-    outBuffer.resize(width * height * 2);
-    uint8_t *dst = reinterpret_cast<uint8_t *>(outBuffer.data());
-
-    for (int y = 0; y < height; ++y) {
-        const uint8_t *src = reinterpret_cast<const uint8_t *>(image.constScanLine(y));
-        uint8_t *rowPtr = dst + (y * width * 2);
-
-        int x = 0;
-        for (; x + 1 < width; x += 2) {
-            const uint8_t *p0 = src + (x * 3);
-            const uint8_t *p1 = src + ((x + 1) * 3);
+    pool.run(image.height(), 2, [&](int firstRow, int endRow) {
+        const size_t chromaOffset = static_cast<size_t>(firstRow / 2) * chromaStride;
+        YuvConverter::convertRgbToI420(image.constScanLine(firstRow), image.bytesPerLine(),
+                                       image.width(), endRow - firstRow,
+                                       yPlane + static_cast<size_t>(firstRow) * yStride, yStride,
+                                       uPlane + chromaOffset, vPlane + chromaOffset, chromaStride);
+    });
+    return true;
+}
 
-            const YuvComponents yuv0 = rgbToYuv(p0[0], p0[1], p0[2]);
-            const YuvComponents yuv1 = rgbToYuv(p1[0], p1[1], p1[2]);
+// The effects readback arrives as RGBA8888. Dropping alpha into a pooled
+// image keeps the steady-state path free of per-frame allocations.
+QImage toRgb888(const QImage &image, SliceWorkerPool &pool)
+{
+    switch (image.format()) {
+    case QImage::Format_RGB888:
+        return image;
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+    case QImage::Format_RGBX8888:
+        break;
+    default:
+        return image.convertToFormat(QImage::Format_RGB888);
+    }
 
-            const uint8_t u = clampToByte((static_cast<int>(yuv0.u) + static_cast<int>(yuv1.u)) / 2);
-            const uint8_t v = clampToByte((static_cast<int>(yuv0.v) + static_cast<int>(yuv1.v)) / 2);
+    QImage rgb = FramePool::instance().acquireImage(image.size(), QImage::Format_RGB888);
+    if (rgb.isNull()) {
+        return QImage();
+    }
 
-            rowPtr[(x * 2) + 0] = yuv0.y;
-            rowPtr[(x * 2) + 1] = u;
-            rowPtr[(x * 2) + 2] = yuv1.y;
-            rowPtr[(x * 2) + 3] = v;
+    // Fetch the pixels once; scanLine() on a shared QImage is not thread-safe
+    const int width = image.width();
+    uchar *const rgbBits = rgb.bits();
+    const qsizetype rgbStride = rgb.bytesPerLine();
+    pool.run(image.height(), 1, [&](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; ++y) {
+            const uchar *src = image.constScanLine(y);
+            uchar *dst = rgbBits + y * rgbStride;
+            for (int x = 0; x < width; ++x) {
+                dst[x * 3 + 0] = src[x * 4 + 0];
+                dst[x * 3 + 1] = src[x * 4 + 1];
+                dst[x * 3 + 2] = src[x * 4 + 2];
+            }
         }
+    });
+    return rgb;
+}
 
-        if (x < width) {
-            const uint8_t *p0 = src + (x * 3);
-            const YuvComponents yuv0 = rgbToYuv(p0[0], p0[1], p0[2]);
+int xioctl(int fd, unsigned long request, void *arg)
+{
+    int result;
+    do {
+        result = ioctl(fd, request, arg);
+    } while (result == -1 && errno == EINTR);
+    return result;
+}
 
-            rowPtr[(x * 2) + 0] = yuv0.y;
-            rowPtr[(x * 2) + 1] = yuv0.u;
-            rowPtr[(x * 2) + 2] = yuv0.y;
-            rowPtr[(x * 2) + 3] = yuv0.v;
-        }
-    }
+// One frame on its way to the device: RGB from the effects readback, or
+// YUYV already packed on the GPU
+struct QueuedFrame {
+    QImage image;
+    PackedFrame packed;
+    qint64 captureTimeUs = 0;
+    bool prepared = false;   // image is already scaled and in RGB888
+    std::shared_ptr<SharedConversion> shared;  // Set when other sinks get the same frame
 
-    return true;
-}
+    bool isNull() const { return image.isNull() && packed.isNull(); }
+};
 
 } // namespace
 
@@ -115,16 +176,75 @@ public:
         , m_deviceConfigured(false)
         , m_frameWidth(0)
         , m_frameHeight(0)
-        , m_processing(false)
+        , m_bytesPerLine(0)
+        , m_frameBytes(0)
+        , m_outputFormat(VirtualCameraStreamer::OutputFormat::Yuyv)
+        , m_outputMode(OutputMode::Write)
+        , m_streaming(false)
+        , m_ringDropped(0)
+        , m_wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+        , m_wakeNotifier(nullptr)
+        , m_outputFrameRate(0)
+        , m_paceTimer(nullptr)
+        , m_frameTimestampUs(0)
+        , m_lastTimestampUs(0)
+        , m_statsWindowStartNs(0)
+        , m_lastWriteNs(-1)
+        , m_windowWrites(0)
+        , m_intervalCount(0)
+        , m_intervalSum(0.0)
+        , m_intervalSquares(0.0)
     {
+        m_statsClock.start();
+        qCDebug(VirtualCameraLog) << "YUV conversion backend:"
+                                  << YuvConverter::backendName(YuvConverter::activeBackend());
+        if (m_wakeFd == -1) {
+            qCWarning(VirtualCameraLog) << "eventfd failed, waking the worker through its event queue"
+                                        << errnoString();
+        }
     }
 
     ~VirtualCameraStreamerWorker() override
     {
         shutdown();
+        if (m_wakeFd != -1) {
+            ::close(m_wakeFd);
+        }
+    }
+
+    // Called on the submitting thread, which must always be the same one.
+    // Neither locks nor allocates; if frames pile up faster than the device
+    // takes them, the worker keeps only the newest.
+    void pushFrame(QueuedFrame frame)
+    {
+        if (!m_ring.push(std::move(frame))) {
+            // The worker is stuck in a device call and already has frames to wake up to
+            m_ringDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (m_wakeFd != -1) {
+            const uint64_t one = 1;
+            if (::write(m_wakeFd, &one, sizeof(one)) == static_cast<ssize_t>(sizeof(one))) {
+                return;
+            }
+        }
+        QMetaObject::invokeMethod(this, &VirtualCameraStreamerWorker::drainRing, Qt::QueuedConnection);
     }
 
 public slots:
+    // Must run on the worker thread, before frames are expected
+    void startWakeNotifier()
+    {
+        if (m_wakeNotifier || m_wakeFd == -1) {
+            return;
+        }
+
+        m_wakeNotifier = new QSocketNotifier(m_wakeFd, QSocketNotifier::Read, this);
+        connect(m_wakeNotifier, &QSocketNotifier::activated,
+                this, &VirtualCameraStreamerWorker::drainRing);
+    }
+
     void setDevicePath(const QString &path)
     {
         const QString normalized = path.trimmed().isEmpty()
@@ -148,102 +268,287 @@ public slots:
 
         m_forcedResolution = normalized;
         m_deviceConfigured = false;
+        m_lastFrame = QueuedFrame();
     }
 
-    void setEnabled(bool enabled)
+    void setOutputFormat(VirtualCameraStreamer::OutputFormat format)
     {
-        if (m_enabled == enabled) {
+        if (format == VirtualCameraStreamer::OutputFormat::Mjpeg &&
+            !QImageWriter::supportedImageFormats().contains("jpeg")) {
+            emit errorOccurred(tr("MJPEG output needs Qt's JPEG image plugin; using YUYV instead"));
+            qCWarning(VirtualCameraLog) << "No JPEG image writer available, falling back to YUYV";
+            format = VirtualCameraStreamer::OutputFormat::Yuyv;
+        }
+        if (format == m_outputFormat) {
             return;
         }
 
-        m_enabled = enabled;
-        if (!m_enabled) {
-            clearQueue();
-            closeDevice();
+        m_outputFormat = format;
+        m_deviceConfigured = false;
+        m_lastFrame = QueuedFrame();
+    }
+
+    void setThreadCount(int threads)
+    {
+        m_slicePool.setThreadCount(threads);
+        qCDebug(VirtualCameraLog) << "Converting frames on" << m_slicePool.threadCount() << "threads";
+    }
+
+    void setOutputFrameRate(int fps)
+    {
+        fps = std::max(0, fps);
+        if (fps == m_outputFrameRate) {
+            return;
         }
 
-        emit streamingStateChanged(m_enabled);
+        m_outputFrameRate = fps;
+        restartPacing();
 
-        if (m_enabled && !m_frameQueue.isEmpty() && !m_processing) {
-            m_processing = true;
-            QMetaObject::invokeMethod(this, &VirtualCameraStreamerWorker::processNextFrame, Qt::QueuedConnection);
+        // A frame that was waiting for a tick goes out right away now
+        if (m_outputFrameRate == 0) {
+            writePendingFrame();
         }
     }
 
-    void processFrame(const QImage &frame)
+    void setEnabled(bool enabled)
     {
-        if (!m_enabled || frame.isNull()) {
+        if (m_enabled == enabled) {
             return;
         }
 
-        if (m_frameQueue.size() >= 3) {
-            m_frameQueue.dequeue(); // Drop oldest frame to avoid backlog
+        m_enabled = enabled;
+        if (!m_enabled) {
+            clearQueue();
+            closeDevice();
+        } else {
+            resetStats();
         }
+        restartPacing();
 
-        m_frameQueue.enqueue(frame);
-
-        if (!m_processing) {
-            m_processing = true;
-            QMetaObject::invokeMethod(this, &VirtualCameraStreamerWorker::processNextFrame, Qt::QueuedConnection);
-        }
+        emit streamingStateChanged(m_enabled);
     }
 
     void shutdown()
     {
         m_enabled = false;
         clearQueue();
+        restartPacing();
         closeDevice();
     }
 
 signals:
     void errorOccurred(const QString &message);
     void streamingStateChanged(bool enabled);
+    void outputStatsUpdated(const VirtualCameraStreamer::OutputStats &stats);
 
 private:
-    void processNextFrame()
+    // Moves everything the producer queued out of the ring. Only the newest
+    // frame is kept: the device always gets the latest picture available.
+    void collectFrames()
     {
+        QueuedFrame frame;
+        while (m_ring.pop(frame)) {
+            if (!m_pendingFrame.isNull()) {
+                ++m_stats.framesDropped;
+            }
+            m_pendingFrame = std::move(frame);
+        }
+        m_stats.framesDropped += m_ringDropped.exchange(0, std::memory_order_relaxed);
+
         if (!m_enabled) {
-            m_processing = false;
-            clearQueue();
-            return;
+            m_pendingFrame = QueuedFrame();
         }
+    }
 
-        if (m_frameQueue.isEmpty()) {
-            m_processing = false;
-            return;
+    void drainRing()
+    {
+        if (m_wakeFd != -1) {
+            // Reset the counter first so frames pushed from here on wake us again
+            uint64_t wakeups = 0;
+            if (::read(m_wakeFd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) {
+                qCWarning(VirtualCameraLog) << "Reading the wakeup eventfd failed" << errnoString();
+            }
+        }
+
+        collectFrames();
+
+        // With pacing the next tick picks the frame up
+        if (m_outputFrameRate == 0) {
+            writePendingFrame();
+        }
+    }
+
+    // Returns false when there was nothing new to write
+    bool writePendingFrame()
+    {
+        if (!m_enabled || m_pendingFrame.isNull()) {
+            return false;
         }
 
-        QImage image = prepareFrame(m_frameQueue.dequeue());
-        if (!image.isNull()) {
-            const int width = image.width();
-            const int height = image.height();
-            if (ensureDevice(width, height)) {
-                if (!writeFrame(image)) {
-                    closeDevice();
+        QueuedFrame frame = std::move(m_pendingFrame);
+        m_pendingFrame = QueuedFrame();
+        writeQueuedFrame(std::move(frame), false);
+        return true;
+    }
+
+    // Writes one frame, preparing it first unless it is a repeat of the
+    // last one. A failed write closes the device.
+    void writeQueuedFrame(QueuedFrame frame, bool repeat)
+    {
+        m_frameTimestampUs = nextTimestamp(frame.captureTimeUs, repeat);
+
+        if (!frame.packed.isNull()) {
+            // Already scaled and converted on the GPU; only YUYV is packed
+            const QSize size = frame.packed.size;
+            if (m_outputFormat != VirtualCameraStreamer::OutputFormat::Yuyv) {
+                qCDebug(VirtualCameraLog) << "Dropping GPU-packed YUYV frame for a non-YUYV output";
+                return;
+            }
+            if (!ensureDevice(size.width(), size.height())) {
+                return;
+            }
+            if (!writePackedFrame(frame.packed)) {
+                closeDevice();
+                return;
+            }
+        } else {
+            if (!frame.prepared) {
+                const QImage source = frame.image;
+                if (frame.shared && frame.shared->sharesScaling(m_forcedResolution)) {
+                    frame.image = frame.shared->scaledImage(m_forcedResolution, [this, &source]() {
+                        return prepareFrame(source);
+                    });
+                } else {
+                    frame.image = prepareFrame(source);
                 }
+                frame.prepared = true;
+            }
+            if (frame.image.isNull() || !ensureDevice(frame.image.width(), frame.image.height())) {
+                return;
+            }
+            const bool written = frame.shared && frame.shared->sharesConversion(m_forcedResolution, m_outputFormat)
+                ? writeSharedFrame(frame)
+                : writeImageFrame(frame.image);
+            if (!written) {
+                closeDevice();
+                return;
             }
         }
 
-        if (!m_frameQueue.isEmpty() && m_enabled) {
-            QMetaObject::invokeMethod(this, &VirtualCameraStreamerWorker::processNextFrame, Qt::QueuedConnection);
-        } else {
-            m_processing = false;
+        if (m_outputFrameRate > 0) {
+            m_lastFrame = frame;
+        }
+    }
+
+    // New frames carry their capture time. Repeats advance by one period so
+    // timestamps keep increasing while the same picture is shown.
+    qint64 nextTimestamp(qint64 captureTimeUs, bool repeat) const
+    {
+        qint64 timestamp = captureTimeUs > 0 ? captureTimeUs : FrameClock::nowUs();
+        if (repeat && m_outputFrameRate > 0 && m_lastTimestampUs > 0) {
+            timestamp = m_lastTimestampUs + 1000000 / m_outputFrameRate;
+        }
+        return std::max(timestamp, m_lastTimestampUs + 1);
+    }
+
+    void restartPacing()
+    {
+        m_lastFrame = QueuedFrame();
+        if (m_paceTimer) {
+            m_paceTimer->stop();
+        }
+        if (m_outputFrameRate <= 0 || !m_enabled) {
+            return;
+        }
+
+        if (!m_paceTimer) {
+            m_paceTimer = new QTimer(this);
+            m_paceTimer->setTimerType(Qt::PreciseTimer);
+            m_paceTimer->setSingleShot(true);
+            connect(m_paceTimer, &QTimer::timeout, this, &VirtualCameraStreamerWorker::processPaceTick);
+        }
+        m_paceSchedule.start(m_outputFrameRate);
+        m_paceTimer->start(m_paceSchedule.nextDelayMs());
+    }
+
+    void processPaceTick()
+    {
+        if (!m_enabled || m_outputFrameRate <= 0) {
+            return;
+        }
+
+        // Overruns are dropped while collecting, so one frame goes out per tick
+        collectFrames();
+        if (!writePendingFrame() && !m_lastFrame.isNull()) {
+            // Underrun: repeat the last frame to hold the configured rate
+            ++m_stats.framesDuplicated;
+            writeQueuedFrame(m_lastFrame, true);
+        }
+
+        if (m_enabled && m_outputFrameRate > 0) {
+            m_paceTimer->start(m_paceSchedule.nextDelayMs());
+        }
+    }
+
+    void resetStats()
+    {
+        m_stats = VirtualCameraStreamer::OutputStats();
+        m_statsClock.start();
+        m_statsWindowStartNs = 0;
+        m_lastWriteNs = -1;
+        m_windowWrites = 0;
+        m_intervalCount = 0;
+        m_intervalSum = 0.0;
+        m_intervalSquares = 0.0;
+    }
+
+    // Called once a frame has been handed to the device
+    void recordWrite()
+    {
+        m_lastTimestampUs = m_frameTimestampUs;
+        ++m_stats.framesWritten;
+        ++m_windowWrites;
+
+        const qint64 now = m_statsClock.nsecsElapsed();
+        if (m_lastWriteNs >= 0) {
+            const double intervalMs = static_cast<double>(now - m_lastWriteNs) / 1e6;
+            m_intervalSum += intervalMs;
+            m_intervalSquares += intervalMs * intervalMs;
+            ++m_intervalCount;
+        }
+        m_lastWriteNs = now;
+
+        const qint64 window = now - m_statsWindowStartNs;
+        if (window < kStatsIntervalNs) {
+            return;
+        }
+
+        m_stats.fps = static_cast<double>(m_windowWrites) * kNanosecondsPerSecond / window;
+        if (m_intervalCount > 1) {
+            const double mean = m_intervalSum / m_intervalCount;
+            m_stats.jitterMs = std::sqrt(std::max(0.0, m_intervalSquares / m_intervalCount - mean * mean));
         }
+        emit outputStatsUpdated(m_stats);
+        qCDebug(VirtualCameraLog) << "Output" << m_stats.fps << "fps, jitter" << m_stats.jitterMs << "ms,"
+                                  << m_stats.framesDuplicated << "duplicated," << m_stats.framesDropped << "dropped";
+
+        m_statsWindowStartNs = now;
+        m_windowWrites = 0;
+        m_intervalCount = 0;
+        m_intervalSum = 0.0;
+        m_intervalSquares = 0.0;
     }
 
-    QImage prepareFrame(const QImage &frame) const
+    QImage prepareFrame(const QImage &frame)
     {
         if (frame.isNull()) {
             return QImage();
         }
 
-        QImage image = frame;
-        if (image.format() != QImage::Format_RGB888) {
-            image = image.convertToFormat(QImage::Format_RGB888);
-            if (image.isNull()) {
-                qCWarning(VirtualCameraLog) << "Failed to convert frame to RGB888 format";
-                return QImage();
-            }
+        QImage image = toRgb888(frame, m_slicePool);
+        if (image.isNull()) {
+            qCWarning(VirtualCameraLog) << "Failed to convert frame to RGB888 format";
+            return QImage();
         }
 
         QSize targetSize = m_forcedResolution.isValid() ? m_forcedResolution : image.size();
@@ -252,22 +557,14 @@ private:
         }
 
         if (image.size() != targetSize) {
-            if (m_forcedResolution.isValid()) {
-                QImage scaled = image.scaled(targetSize, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-                if (scaled.isNull()) {
-                    qCWarning(VirtualCameraLog) << "Failed to scale frame to forced resolution" << targetSize;
-                    return QImage();
-                }
-
-                if (scaled.size() != targetSize) {
-                    const int xOffset = std::max(0, (scaled.width() - targetSize.width()) / 2);
-                    const int yOffset = std::max(0, (scaled.height() - targetSize.height()) / 2);
-                    image = scaled.copy(xOffset, yOffset, targetSize.width(), targetSize.height());
-                } else {
-                    image = scaled;
-                }
-            } else {
-                image = image.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            // A forced resolution keeps the aspect ratio: the scaler covers
+            // the target and crops the centre in the same pass
+            const FrameScaler::Fit fit = m_forcedResolution.isValid()
+                ? FrameScaler::Fit::Crop : FrameScaler::Fit::Stretch;
+            image = scaleImage(image, targetSize, fit);
+            if (image.isNull()) {
+                qCWarning(VirtualCameraLog) << "Failed to scale frame to" << targetSize;
+                return QImage();
             }
         }
 
@@ -278,10 +575,37 @@ private:
         return image;
     }
 
+    QImage scaleImage(const QImage &image, const QSize &size, FrameScaler::Fit fit)
+    {
+        if (size.isEmpty()) {
+            return QImage();
+        }
+
+        QImage scaled = FramePool::instance().acquireImage(size, QImage::Format_RGB888);
+        if (scaled.isNull()) {
+            return QImage();
+        }
+
+        // Taps and crop window are only rebuilt when the sizes change
+        m_scaler.configure(image.size(), size, fit);
+        const uint8_t *src = image.constBits();
+        uint8_t *dst = scaled.bits();
+        m_slicePool.run(size.height(), 1, [&](int firstRow, int endRow) {
+            m_scaler.scaleRows(src, image.bytesPerLine(), dst, scaled.bytesPerLine(), firstRow, endRow);
+        });
+        return scaled;
+    }
+
     bool ensureDevice(int width, int height)
     {
         if (m_fd == -1) {
-            m_fd = ::open(m_devicePath.toLocal8Bit().constData(), O_WRONLY);
+            // Read/write access is needed to mmap streaming buffers; plain
+            // write() output only needs O_WRONLY.
+            const QByteArray path = m_devicePath.toLocal8Bit();
+            m_fd = ::open(path.constData(), O_RDWR);
+            if (m_fd == -1) {
+                m_fd = ::open(path.constData(), O_WRONLY);
+            }
             if (m_fd == -1) {
                 emit errorOccurred(tr("Cannot open virtual camera device %1: %2")
                     .arg(m_devicePath, errnoString()));
@@ -294,6 +618,8 @@ private:
         }
 
         if (!m_deviceConfigured || width != m_frameWidth || height != m_frameHeight) {
+            // Buffers must be released before the format can change
+            releaseMappedBuffers();
             if (!configureFormat(width, height)) {
                 closeDevice();
                 m_enabled = false;
@@ -303,6 +629,9 @@ private:
             m_deviceConfigured = true;
             m_frameWidth = width;
             m_frameHeight = height;
+            m_outputMode = setupMappedBuffers(height) ? OutputMode::Mmap : OutputMode::Write;
+            qCDebug(VirtualCameraLog) << "Virtual camera output mode:"
+                                      << (m_outputMode == OutputMode::Mmap ? "mmap streaming" : "write()");
         }
 
         return true;
@@ -319,11 +648,35 @@ private:
         format.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
         format.fmt.pix.width = width;
         format.fmt.pix.height = height;
-        format.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
         format.fmt.pix.field = V4L2_FIELD_NONE;
         format.fmt.pix.colorspace = V4L2_COLORSPACE_SRGB;
-        format.fmt.pix.bytesperline = width * 2;
-        format.fmt.pix.sizeimage = format.fmt.pix.bytesperline * height;
+
+        int minBytesPerLine = 0;
+        switch (m_outputFormat) {
+        case VirtualCameraStreamer::OutputFormat::Nv12:
+            format.fmt.pix.pixelformat = V4L2_PIX_FMT_NV12;
+            minBytesPerLine = width;
+            break;
+        case VirtualCameraStreamer::OutputFormat::I420:
+            format.fmt.pix.pixelformat = V4L2_PIX_FMT_YUV420;
+            minBytesPerLine = width;
+            break;
+        case VirtualCameraStreamer::OutputFormat::Mjpeg:
+            format.fmt.pix.pixelformat = V4L2_PIX_FMT_MJPEG;
+            format.fmt.pix.colorspace = V4L2_COLORSPACE_JPEG;
+            break;
+        case VirtualCameraStreamer::OutputFormat::Yuyv:
+        default:
+            format.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+            minBytesPerLine = width * 2;
+            break;
+        }
+        m_bytesPerLine = minBytesPerLine;
+        format.fmt.pix.bytesperline = minBytesPerLine;
+        // Compressed frames vary in size; YUYV's size is a generous upper bound
+        format.fmt.pix.sizeimage = m_outputFormat == VirtualCameraStreamer::OutputFormat::Mjpeg
+            ? static_cast<uint32_t>(width) * height * 2
+            : static_cast<uint32_t>(imageBytes(height));
 
         if (ioctl(m_fd, VIDIOC_S_FMT, &format) == -1) {
             emit errorOccurred(tr("Failed to configure virtual camera format: %1")
@@ -332,24 +685,401 @@ private:
             return false;
         }
 
+        // The driver may pad rows; honour the stride and size it reports.
+        m_bytesPerLine = std::max<int>(static_cast<int>(format.fmt.pix.bytesperline), minBytesPerLine);
+        m_frameBytes = m_outputFormat == VirtualCameraStreamer::OutputFormat::Mjpeg
+            ? std::max<size_t>(format.fmt.pix.sizeimage, static_cast<size_t>(width) * height * 2)
+            : std::max<size_t>(format.fmt.pix.sizeimage, imageBytes(height));
         return true;
     }
 
-    bool writeFrame(const QImage &image)
+    // Bytes of one uncompressed frame at the configured format and stride.
+    // 4:2:0 chroma rounds odd sizes up; I420 chroma rows are half the stride.
+    size_t imageBytes(int height) const
+    {
+        const size_t lumaBytes = static_cast<size_t>(m_bytesPerLine) * height;
+        const size_t chromaRows = static_cast<size_t>((height + 1) / 2);
+        switch (m_outputFormat) {
+        case VirtualCameraStreamer::OutputFormat::Nv12:
+            return lumaBytes + static_cast<size_t>(m_bytesPerLine) * chromaRows;
+        case VirtualCameraStreamer::OutputFormat::I420:
+            return lumaBytes + 2 * static_cast<size_t>(chromaStride()) * chromaRows;
+        case VirtualCameraStreamer::OutputFormat::Mjpeg:
+            return m_frameBytes;
+        case VirtualCameraStreamer::OutputFormat::Yuyv:
+        default:
+            return lumaBytes;
+        }
+    }
+
+    int chromaStride() const
+    {
+        return m_outputFormat == VirtualCameraStreamer::OutputFormat::Nv12
+            ? m_bytesPerLine
+            : (m_bytesPerLine + 1) / 2;
+    }
+
+    bool setupMappedBuffers(int height)
+    {
+        struct v4l2_capability capability;
+        memset(&capability, 0, sizeof(capability));
+        if (xioctl(m_fd, VIDIOC_QUERYCAP, &capability) == -1) {
+            return false;
+        }
+
+        const uint32_t caps = (capability.capabilities & V4L2_CAP_DEVICE_CAPS)
+            ? capability.device_caps
+            : capability.capabilities;
+        if (!(caps & V4L2_CAP_STREAMING)) {
+            return false;
+        }
+
+        struct v4l2_requestbuffers request;
+        memset(&request, 0, sizeof(request));
+        request.count = kMappedBufferCount;
+        request.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+        request.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(m_fd, VIDIOC_REQBUFS, &request) == -1 || request.count == 0) {
+            qCDebug(VirtualCameraLog) << "VIDIOC_REQBUFS unsupported, falling back to write()" << errnoString();
+            return false;
+        }
+
+        const size_t frameBytes = imageBytes(height);
+        for (unsigned int i = 0; i < request.count; ++i) {
+            struct v4l2_buffer buffer;
+            memset(&buffer, 0, sizeof(buffer));
+            buffer.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+            buffer.memory = V4L2_MEMORY_MMAP;
+            buffer.index = i;
+            if (xioctl(m_fd, VIDIOC_QUERYBUF, &buffer) == -1 || buffer.length < frameBytes) {
+                qCWarning(VirtualCameraLog) << "VIDIOC_QUERYBUF failed for buffer" << i;
+                releaseMappedBuffers();
+                return false;
+            }
+
+            void *start = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                               m_fd, buffer.m.offset);
+            if (start == MAP_FAILED) {
+                qCWarning(VirtualCameraLog) << "mmap failed for buffer" << i << errnoString();
+                releaseMappedBuffers();
+                return false;
+            }
+
+            m_mappedBuffers.push_back({start, buffer.length});
+            m_freeBuffers.push_back(static_cast<int>(i));
+        }
+
+        return true;
+    }
+
+    void releaseMappedBuffers()
+    {
+        if (m_fd != -1 && m_streaming) {
+            int type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+            xioctl(m_fd, VIDIOC_STREAMOFF, &type);
+        }
+        m_streaming = false;
+
+        for (const MappedBuffer &buffer : m_mappedBuffers) {
+            munmap(buffer.start, buffer.length);
+        }
+
+        if (m_fd != -1 && !m_mappedBuffers.empty()) {
+            struct v4l2_requestbuffers request;
+            memset(&request, 0, sizeof(request));
+            request.count = 0;
+            request.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+            request.memory = V4L2_MEMORY_MMAP;
+            xioctl(m_fd, VIDIOC_REQBUFS, &request);
+        }
+
+        m_mappedBuffers.clear();
+        m_freeBuffers.clear();
+        m_outputMode = OutputMode::Write;
+    }
+
+    // Returns a buffer index owned by us, -1 if none became free in time
+    // (frame is dropped), or -2 on a device error.
+    int acquireMappedBuffer()
+    {
+        if (!m_freeBuffers.empty()) {
+            const int index = m_freeBuffers.front();
+            m_freeBuffers.pop_front();
+            return index;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        const int ready = poll(&pfd, 1, kBufferWaitTimeoutMs);
+        if (ready == 0) {
+            return -1;
+        }
+        if (ready < 0) {
+            return errno == EINTR ? -1 : -2;
+        }
+        if (pfd.revents & (POLLERR | POLLNVAL)) {
+            return -2;
+        }
+
+        struct v4l2_buffer buffer;
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(m_fd, VIDIOC_DQBUF, &buffer) == -1) {
+            return errno == EAGAIN ? -1 : -2;
+        }
+
+        return static_cast<int>(buffer.index);
+    }
+
+    // Fills a mapped output buffer via fill(dst, capacity), which returns the
+    // bytes it wrote or 0 on failure, and queues it to the driver.
+    template <typename FillFunction>
+    bool writeMappedFrame(FillFunction fill)
+    {
+        const int index = acquireMappedBuffer();
+        if (index == -1) {
+            qCDebug(VirtualCameraLog) << "No free output buffer, dropping frame";
+            ++m_stats.framesDropped;
+            return true;
+        }
+        if (index < 0 || index >= static_cast<int>(m_mappedBuffers.size())) {
+            emit errorOccurred(tr("Failed to dequeue virtual camera buffer: %1")
+                .arg(errnoString()));
+            qCWarning(VirtualCameraLog) << "VIDIOC_DQBUF failed" << errnoString();
+            return false;
+        }
+
+        // Write straight into the kernel-shared buffer: no staging copy.
+        const MappedBuffer &mapped = m_mappedBuffers[static_cast<size_t>(index)];
+        const size_t bytesUsed = fill(static_cast<uint8_t *>(mapped.start), mapped.length);
+        if (bytesUsed == 0) {
+            m_freeBuffers.push_back(index);
+            emit errorOccurred(tr("Failed to convert frame for virtual camera output"));
+            qCWarning(VirtualCameraLog) << "Frame conversion for virtual camera output failed";
+            return false;
+        }
+
+        struct v4l2_buffer buffer;
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        buffer.index = static_cast<uint32_t>(index);
+        buffer.bytesused = static_cast<uint32_t>(bytesUsed);
+        buffer.field = V4L2_FIELD_NONE;
+        // CLOCK_MONOTONIC capture time; v4l2loopback hands it to readers
+        buffer.timestamp.tv_sec = static_cast<time_t>(m_frameTimestampUs / 1000000);
+        buffer.timestamp.tv_usec = static_cast<suseconds_t>(m_frameTimestampUs % 1000000);
+        if (xioctl(m_fd, VIDIOC_QBUF, &buffer) == -1) {
+            const QString error = errnoString();
+            // The driver did not take the buffer, so it is still ours to reuse
+            m_freeBuffers.push_back(index);
+            emit errorOccurred(tr("Failed to queue frame to virtual camera: %1").arg(error));
+            qCWarning(VirtualCameraLog) << "VIDIOC_QBUF failed" << error;
+            return false;
+        }
+        recordWrite();
+
+        if (!m_streaming) {
+            int type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+            if (xioctl(m_fd, VIDIOC_STREAMON, &type) == -1) {
+                emit errorOccurred(tr("Failed to start virtual camera streaming: %1")
+                    .arg(errnoString()));
+                qCWarning(VirtualCameraLog) << "VIDIOC_STREAMON failed" << errnoString();
+                return false;
+            }
+            m_streaming = true;
+        }
+
+        return true;
+    }
+
+    template <typename FillFunction>
+    bool writeFrame(FillFunction fill)
     {
         if (m_fd == -1) {
             return false;
         }
 
-        QByteArray buffer;
-        if (!convertRgbToYuyv(image, buffer)) {
+        if (m_outputMode == OutputMode::Mmap) {
+            return writeMappedFrame(fill);
+        }
+
+        // Fallback path: the staging buffer is reused across frames and only
+        // reallocated when the output size changes.
+        m_writeBuffer.resize(static_cast<qsizetype>(m_frameBytes));
+        const size_t bytesUsed = fill(reinterpret_cast<uint8_t *>(m_writeBuffer.data()), m_frameBytes);
+        if (bytesUsed == 0) {
             emit errorOccurred(tr("Failed to convert frame for virtual camera output"));
-            qCWarning(VirtualCameraLog) << "Frame conversion to YUYV failed";
+            qCWarning(VirtualCameraLog) << "Frame conversion for virtual camera output failed";
+            return false;
+        }
+
+        return writeToDevice(m_writeBuffer.constData(), static_cast<ssize_t>(bytesUsed));
+    }
+
+    // Converts into dst in the device layout; returns the bytes written or 0
+    size_t convertImage(const QImage &image, uint8_t *dst, size_t capacity)
+    {
+        const int height = image.height();
+        const size_t frameBytes = imageBytes(height);
+        const size_t lumaBytes = static_cast<size_t>(m_bytesPerLine) * height;
+
+        switch (m_outputFormat) {
+        case VirtualCameraStreamer::OutputFormat::Nv12:
+            if (capacity < frameBytes) {
+                return 0;
+            }
+            return convertRgbToNv12(image, dst, m_bytesPerLine,
+                                    dst + lumaBytes, chromaStride(), m_slicePool)
+                ? frameBytes : 0;
+        case VirtualCameraStreamer::OutputFormat::I420: {
+            if (capacity < frameBytes) {
+                return 0;
+            }
+            const size_t chromaBytes = static_cast<size_t>(chromaStride()) * ((height + 1) / 2);
+            return convertRgbToI420(image, dst, m_bytesPerLine,
+                                    dst + lumaBytes, dst + lumaBytes + chromaBytes,
+                                    chromaStride(), m_slicePool)
+                ? frameBytes : 0;
+        }
+        case VirtualCameraStreamer::OutputFormat::Mjpeg:
+            return encodeJpeg(image) ? copyJpeg(dst, capacity) : 0;
+        case VirtualCameraStreamer::OutputFormat::Yuyv:
+        default:
+            if (capacity < frameBytes) {
+                return 0;
+            }
+            return convertRgbToYuyv(image, dst, m_bytesPerLine, m_slicePool) ? frameBytes : 0;
+        }
+    }
+
+    bool writeImageFrame(const QImage &image)
+    {
+        if (m_outputFormat == VirtualCameraStreamer::OutputFormat::Mjpeg) {
+            return writeJpegFrame(image);
+        }
+        return writeFrame([this, &image](uint8_t *dst, size_t capacity) -> size_t {
+            return convertImage(image, dst, capacity);
+        });
+    }
+
+    // Writes a frame converted once for every sink with the same resolution
+    // and format. The first sink to get here converts into a pooled buffer;
+    // the others copy that buffer instead of converting again.
+    bool writeSharedFrame(const QueuedFrame &frame)
+    {
+        const QImage &image = frame.image;
+        const SharedConversion::Converted converted = frame.shared->convertedFrame(
+            m_forcedResolution, m_outputFormat, [this, &image]() {
+                SharedConversion::Converted result;
+                const size_t capacity = m_outputFormat == VirtualCameraStreamer::OutputFormat::Mjpeg
+                    ? m_frameBytes : imageBytes(image.height());
+                result.buffer = FramePool::instance().acquire(static_cast<qsizetype>(capacity));
+                if (!result.buffer.isNull()) {
+                    result.bytesUsed = convertImage(image, result.buffer.data(), capacity);
+                    result.bytesPerLine = m_bytesPerLine;
+                }
+                return result;
+            });
+
+        // Devices can pad rows differently; such a sink converts on its own
+        const bool layoutMatches = m_outputFormat == VirtualCameraStreamer::OutputFormat::Mjpeg
+            || converted.bytesPerLine == m_bytesPerLine;
+        if (converted.isNull() || !layoutMatches) {
+            return writeImageFrame(image);
+        }
+
+        if (m_outputMode == OutputMode::Write) {
+            return writeToDevice(reinterpret_cast<const char *>(converted.buffer.constData()),
+                                 static_cast<ssize_t>(converted.bytesUsed));
+        }
+        return writeFrame([&converted](uint8_t *dst, size_t capacity) -> size_t {
+            if (converted.bytesUsed > capacity) {
+                return 0;
+            }
+            memcpy(dst, converted.buffer.constData(), converted.bytesUsed);
+            return converted.bytesUsed;
+        });
+    }
+
+    bool encodeJpeg(const QImage &image)
+    {
+        // resize(0) keeps the capacity, so the buffer settles after a few frames
+        m_jpegBuffer.resize(0);
+        QBuffer buffer(&m_jpegBuffer);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "jpeg");
+        writer.setQuality(kMjpegQuality);
+        if (!writer.write(image)) {
+            emit errorOccurred(tr("Failed to encode MJPEG frame: %1").arg(writer.errorString()));
+            qCWarning(VirtualCameraLog) << "JPEG encoding failed" << writer.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    size_t copyJpeg(uint8_t *dst, size_t capacity) const
+    {
+        const size_t bytes = static_cast<size_t>(m_jpegBuffer.size());
+        if (bytes > capacity) {
+            qCWarning(VirtualCameraLog) << "Encoded frame of" << bytes
+                                        << "bytes exceeds the output buffer";
+            return 0;
+        }
+        memcpy(dst, m_jpegBuffer.constData(), bytes);
+        return bytes;
+    }
+
+    bool writeJpegFrame(const QImage &image)
+    {
+        if (!encodeJpeg(image)) {
+            return false;
+        }
+
+        // write() takes the encoded frame as is; mmap buffers get a copy
+        if (m_outputMode == OutputMode::Write) {
+            return writeToDevice(m_jpegBuffer.constData(), m_jpegBuffer.size());
+        }
+        return writeFrame([this](uint8_t *dst, size_t capacity) -> size_t {
+            return copyJpeg(dst, capacity);
+        });
+    }
+
+    bool writePackedFrame(const PackedFrame &frame)
+    {
+        const int height = frame.size.height();
+        const int rowBytes = std::min(frame.stride, m_bytesPerLine);
+        if (frame.stride <= 0 || frame.data.size() < static_cast<qsizetype>(frame.stride) * height) {
             return false;
         }
 
-        const ssize_t frameSize = buffer.size();
-        const ssize_t written = ::write(m_fd, buffer.constData(), frameSize);
+        // Strides match on the write() path: hand the buffer over untouched
+        if (m_outputMode == OutputMode::Write && frame.stride == m_bytesPerLine) {
+            return m_fd != -1 && writeToDevice(reinterpret_cast<const char *>(frame.data.constData()),
+                                               frame.data.size());
+        }
+
+        const size_t frameBytes = static_cast<size_t>(m_bytesPerLine) * height;
+        return writeFrame([this, &frame, height, rowBytes, frameBytes](uint8_t *dst, size_t capacity) -> size_t {
+            if (capacity < frameBytes) {
+                return 0;
+            }
+            const uchar *src = frame.data.constData();
+            for (int y = 0; y < height; ++y) {
+                memcpy(dst + static_cast<size_t>(y) * m_bytesPerLine,
+                       src + static_cast<size_t>(y) * frame.stride,
+                       static_cast<size_t>(rowBytes));
+            }
+            return frameBytes;
+        });
+    }
+
+    bool writeToDevice(const char *data, ssize_t frameSize)
+    {
+        const ssize_t written = ::write(m_fd, data, frameSize);
         if (written != frameSize) {
             emit errorOccurred(tr("Failed to write frame to virtual camera: %1")
                 .arg(errnoString()));
@@ -357,11 +1087,13 @@ private:
             return false;
         }
 
+        recordWrite();
         return true;
     }
 
     void closeDevice()
     {
+        releaseMappedBuffers();
         if (m_fd != -1) {
             ::close(m_fd);
             m_fd = -1;
@@ -369,35 +1101,104 @@ private:
         m_deviceConfigured = false;
         m_frameWidth = 0;
         m_frameHeight = 0;
+        m_bytesPerLine = 0;
+        m_frameBytes = 0;
     }
 
     void clearQueue()
     {
-        m_frameQueue.clear();
-        m_processing = false;
+        QueuedFrame frame;
+        while (m_ring.pop(frame)) {
+        }
+        m_pendingFrame = QueuedFrame();
+        m_ringDropped.store(0, std::memory_order_relaxed);
     }
 
+    enum class OutputMode {
+        Write,
+        Mmap
+    };
+
+    struct MappedBuffer {
+        void *start;
+        size_t length;
+    };
+
     int m_fd;
     QString m_devicePath;
     bool m_enabled;
     bool m_deviceConfigured;
     int m_frameWidth;
     int m_frameHeight;
+    int m_bytesPerLine;
+    size_t m_frameBytes;          // Largest frame the device accepts (sizeimage)
+    VirtualCameraStreamer::OutputFormat m_outputFormat;
+    OutputMode m_outputMode;
+    bool m_streaming;
+    std::vector<MappedBuffer> m_mappedBuffers;
+    std::deque<int> m_freeBuffers;
+    QByteArray m_writeBuffer;
+    QByteArray m_jpegBuffer;
+    SliceWorkerPool m_slicePool;
+    FrameScaler m_scaler;
     QSize m_forcedResolution;
-    QQueue<QImage> m_frameQueue;
-    bool m_processing;
+
+    // Frame handoff from the submitting thread
+    FrameRing<QueuedFrame, kFrameRingSlots> m_ring;
+    QueuedFrame m_pendingFrame;          // Newest frame not written yet
+    std::atomic<quint64> m_ringDropped;  // Pushes rejected by a full ring
+    int m_wakeFd;                        // eventfd the producer signals after a push
+    QSocketNotifier *m_wakeNotifier;
+
+    // Pacing
+    int m_outputFrameRate;
+    QTimer *m_paceTimer;
+    FrameClock::TickSchedule m_paceSchedule;
+    QueuedFrame m_lastFrame;       // Repeated on ticks with no new frame
+    qint64 m_frameTimestampUs;     // Timestamp of the frame being written
+    qint64 m_lastTimestampUs;
+
+    // Output statistics, reported every kStatsIntervalNs
+    VirtualCameraStreamer::OutputStats m_stats;
+    QElapsedTimer m_statsClock;
+    qint64 m_statsWindowStartNs;
+    qint64 m_lastWriteNs;
+    int m_windowWrites;
+    int m_intervalCount;
+    double m_intervalSum;
+    double m_intervalSquares;
 };
 
+VirtualCameraStreamer::OutputFormat VirtualCameraStreamer::outputFormatForKey(const QString &key)
+{
+    const QString normalized = key.trimmed().toLower();
+    if (normalized == QStringLiteral("nv12")) {
+        return OutputFormat::Nv12;
+    }
+    if (normalized == QStringLiteral("i420") || normalized == QStringLiteral("yuv420")) {
+        return OutputFormat::I420;
+    }
+    if (normalized == QStringLiteral("mjpeg") || normalized == QStringLiteral("mjpg")) {
+        return OutputFormat::Mjpeg;
+    }
+    return OutputFormat::Yuyv;
+}
+
 VirtualCameraStreamer::VirtualCameraStreamer(QObject *parent)
     : QObject(parent)
     , m_devicePath(QString::fromLatin1(kDefaultDevicePath))
     , m_enabled(false)
     , m_forcedResolution()
+    , m_outputFormat(OutputFormat::Yuyv)
+    , m_threadCount(0)
+    , m_outputFrameRate(0)
     , m_workerThread(nullptr)
     , m_worker(nullptr)
     , m_workerInitialized(false)
 {
     qRegisterMetaType<QImage>("QImage");
+    qRegisterMetaType<PackedFrame>("PackedFrame");
+    qRegisterMetaType<VirtualCameraStreamer::OutputStats>("VirtualCameraStreamer::OutputStats");
 }
 
 VirtualCameraStreamer::~VirtualCameraStreamer()
@@ -465,14 +1266,80 @@ void VirtualCameraStreamer::setForcedResolution(const QSize &resolution)
         Qt::QueuedConnection);
 }
 
-void VirtualCameraStreamer::onProcessedFrameReady(const QImage &frame)
+void VirtualCameraStreamer::setOutputFormat(OutputFormat format)
+{
+    if (format == m_outputFormat) {
+        return;
+    }
+
+    m_outputFormat = format;
+    ensureWorker();
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, format]() {
+            worker->setOutputFormat(format);
+        },
+        Qt::QueuedConnection);
+}
+
+void VirtualCameraStreamer::setThreadCount(int threads)
+{
+    threads = std::max(0, threads);
+    if (threads == m_threadCount) {
+        return;
+    }
+
+    m_threadCount = threads;
+    ensureWorker();
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, threads]() {
+            worker->setThreadCount(threads);
+        },
+        Qt::QueuedConnection);
+}
+
+void VirtualCameraStreamer::setOutputFrameRate(int fps)
+{
+    fps = std::max(0, fps);
+    if (fps == m_outputFrameRate) {
+        return;
+    }
+
+    m_outputFrameRate = fps;
+    ensureWorker();
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, fps]() {
+            worker->setOutputFrameRate(fps);
+        },
+        Qt::QueuedConnection);
+}
+
+void VirtualCameraStreamer::onProcessedFrameReady(const QImage &frame, qint64 captureTimeUs)
+{
+    submitFrame(frame, captureTimeUs, nullptr);
+}
+
+void VirtualCameraStreamer::submitFrame(const QImage &frame, qint64 captureTimeUs,
+                                        const std::shared_ptr<SharedConversion> &shared)
 {
     if (!m_enabled || frame.isNull()) {
         return;
     }
 
     ensureWorker();
-    scheduleFrameDelivery(frame);
+    scheduleFrameDelivery(frame, captureTimeUs, shared);
+}
+
+void VirtualCameraStreamer::onPackedFrameReady(const PackedFrame &frame)
+{
+    if (!m_enabled || frame.isNull()) {
+        return;
+    }
+
+    ensureWorker();
+    QueuedFrame queued;
+    queued.packed = frame;
+    queued.captureTimeUs = frame.captureTimeUs;
+    m_worker->pushFrame(std::move(queued));
 }
 
 void VirtualCameraStreamer::ensureWorker()
@@ -488,13 +1355,21 @@ void VirtualCameraStreamer::ensureWorker()
             this, &VirtualCameraStreamer::errorOccurred);
     connect(m_worker, &VirtualCameraStreamerWorker::streamingStateChanged,
             this, &VirtualCameraStreamer::handleWorkerStreamingStateChanged);
+    connect(m_worker, &VirtualCameraStreamerWorker::outputStatsUpdated,
+            this, &VirtualCameraStreamer::handleWorkerOutputStats);
     connect(m_workerThread, &QThread::finished,
             m_worker, &QObject::deleteLater);
 
     m_workerThread->start();
     m_workerInitialized = true;
+    QMetaObject::invokeMethod(m_worker, &VirtualCameraStreamerWorker::startWakeNotifier,
+                              Qt::QueuedConnection);
+
     const QString devicePathCopy = m_devicePath;
     const QSize resolutionCopy = m_forcedResolution;
+    const OutputFormat formatCopy = m_outputFormat;
+    const int threadCountCopy = m_threadCount;
+    const int outputFrameRateCopy = m_outputFrameRate;
     const bool enabledCopy = m_enabled;
 
     QMetaObject::invokeMethod(m_worker,
@@ -507,6 +1382,21 @@ void VirtualCameraStreamer::ensureWorker()
             worker->setForcedResolution(resolutionCopy);
         },
         Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, formatCopy]() {
+            worker->setOutputFormat(formatCopy);
+        },
+        Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, threadCountCopy]() {
+            worker->setThreadCount(threadCountCopy);
+        },
+        Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_worker,
+        [worker = m_worker, outputFrameRateCopy]() {
+            worker->setOutputFrameRate(outputFrameRateCopy);
+        },
+        Qt::QueuedConnection);
     QMetaObject::invokeMethod(m_worker,
         [worker = m_worker, enabledCopy]() {
             worker->setEnabled(enabledCopy);
@@ -514,13 +1404,15 @@ void VirtualCameraStreamer::ensureWorker()
         Qt::QueuedConnection);
 }
 
-void VirtualCameraStreamer::scheduleFrameDelivery(const QImage &frame)
+void VirtualCameraStreamer::scheduleFrameDelivery(const QImage &frame, qint64 captureTimeUs,
+                                                  const std::shared_ptr<SharedConversion> &shared)
 {
-    QMetaObject::invokeMethod(m_worker,
-        [worker = m_worker, image = frame]() {
-            worker->processFrame(image);
-        },
-        Qt::QueuedConnection);
+    // Straight into the worker's ring: no event or allocation per frame
+    QueuedFrame queued;
+    queued.image = frame;
+    queued.captureTimeUs = captureTimeUs;
+    queued.shared = shared;
+    m_worker->pushFrame(std::move(queued));
 }
 
 void VirtualCameraStreamer::handleWorkerStreamingStateChanged(bool enabled)
@@ -528,4 +1420,10 @@ void VirtualCameraStreamer::handleWorkerStreamingStateChanged(bool enabled)
     m_enabled = enabled;
 }
 
+void VirtualCameraStreamer::handleWorkerOutputStats(const OutputStats &stats)
+{
+    m_outputStats = stats;
+    emit outputStatsChanged(stats);
+}
+
 #include "VirtualCameraStreamer.moc"
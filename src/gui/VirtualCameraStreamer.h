@@ -3,25 +3,69 @@
 
 #include <QObject>
 #include <QImage>
+#include <QMetaType>
 #include <QString>
 #include <QSize>
+#include <memory>
+#include "PackedFrame.h"
 
 class QThread;
+class SharedConversion;
 class VirtualCameraStreamerWorker;
 
 /**
  * @brief Streams preview frames into a v4l2loopback virtual camera device.
  *
  * The streamer opens the requested V4L2 video output device and writes
- * frames in YUYV (YUY2) format. An optional forced resolution keeps the
- * virtual camera output stable for conferencing apps that dislike runtime
- * format changes.
+ * frames as YUYV (YUY2), NV12, I420 or MJPEG. Consumers that negotiate NV12
+ * or I420 natively skip their own conversion; MJPEG trades CPU time for far
+ * less memory bandwidth at high resolutions. When the device supports
+ * streaming I/O the worker converts straight into a ring of mmap'd output
+ * buffers; otherwise it falls back to write(). Frames that were already
+ * packed to YUYV on the GPU (PackedFrame) skip scaling and conversion and
+ * are copied through. An optional forced resolution keeps the virtual camera
+ * output stable for conferencing apps that dislike runtime format changes.
+ *
+ * Frames reach the worker through a lock-free single-producer ring and an
+ * eventfd wakeup, so submitting a frame costs no event or allocation. Frames
+ * must be submitted from one thread (the GUI thread). When the worker falls
+ * behind, the newest frame wins and older ones are counted as dropped.
+ * Scaling and colour conversion of each frame are split into horizontal
+ * slices on a small thread pool so 4K output keeps up without effects.
+ *
+ * By default frames are written as they arrive. With an output frame rate
+ * the worker paces itself instead: each tick writes the newest frame, drops
+ * any older ones and repeats the last frame when nothing new arrived, so
+ * GUI-thread stalls do not reach consumers. Mapped buffers carry the
+ * frame's monotonic capture time as their V4L2 timestamp.
+ *
+ * Each streamer drives one device. VirtualCameraOutputs runs several side by
+ * side and lets sinks with the same resolution and format share the scaling
+ * and conversion of a frame through SharedConversion.
  */
 class VirtualCameraStreamer : public QObject
 {
     Q_OBJECT
 
 public:
+    enum class OutputFormat {
+        Yuyv,
+        Nv12,
+        I420,
+        Mjpeg
+    };
+
+    // Parses a virtual_camera_format config value; unknown values give YUYV
+    static OutputFormat outputFormatForKey(const QString &key);
+
+    struct OutputStats {
+        double fps = 0.0;             // Frames written per second, last interval
+        double jitterMs = 0.0;        // Std. deviation of the write interval
+        quint64 framesWritten = 0;
+        quint64 framesDuplicated = 0; // Repeated because nothing new arrived
+        quint64 framesDropped = 0;    // Replaced by a newer frame before writing
+    };
+
     explicit VirtualCameraStreamer(QObject *parent = nullptr);
     ~VirtualCameraStreamer() override;
 
@@ -32,26 +76,54 @@ public:
     void setEnabled(bool enabled);
     void setForcedResolution(const QSize &resolution);
     QSize forcedResolution() const { return m_forcedResolution; }
+    void setOutputFormat(OutputFormat format);
+    OutputFormat outputFormat() const { return m_outputFormat; }
+
+    // Threads used to scale and convert each frame; 0 picks from the CPU count
+    void setThreadCount(int threads);
+    int threadCount() const { return m_threadCount; }
+
+    // Frames per second written to the device; 0 writes frames as they arrive
+    void setOutputFrameRate(int fps);
+    int outputFrameRate() const { return m_outputFrameRate; }
+
+    // Updated every couple of seconds while streaming
+    OutputStats outputStats() const { return m_outputStats; }
+
+    // Like onProcessedFrameReady(); scaling and conversion that other sinks
+    // registered with the same parameters in shared are done only once
+    void submitFrame(const QImage &frame, qint64 captureTimeUs,
+                     const std::shared_ptr<SharedConversion> &shared);
 
 public slots:
-    void onProcessedFrameReady(const QImage &frame);
+    void onProcessedFrameReady(const QImage &frame, qint64 captureTimeUs = 0);
+    void onPackedFrameReady(const PackedFrame &frame);
 
 signals:
     void errorOccurred(const QString &message);
+    void outputStatsChanged(const VirtualCameraStreamer::OutputStats &stats);
 
 private slots:
     void handleWorkerStreamingStateChanged(bool enabled);
+    void handleWorkerOutputStats(const VirtualCameraStreamer::OutputStats &stats);
 
 private:
     void ensureWorker();
-    void scheduleFrameDelivery(const QImage &frame);
+    void scheduleFrameDelivery(const QImage &frame, qint64 captureTimeUs,
+                               const std::shared_ptr<SharedConversion> &shared);
 
     QString m_devicePath;
     bool m_enabled;
     QSize m_forcedResolution;
+    OutputFormat m_outputFormat;
+    int m_threadCount;
+    int m_outputFrameRate;
+    OutputStats m_outputStats;
     QThread *m_workerThread;
     VirtualCameraStreamerWorker *m_worker;
     bool m_workerInitialized;
 };
 
+Q_DECLARE_METATYPE(VirtualCameraStreamer::OutputStats)
+
 #endif // VIRTUALCAMERASTREAMER_H
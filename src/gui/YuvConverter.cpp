@@ -0,0 +1,486 @@
+#include "YuvConverter.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define OBSBOT_YUV_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define OBSBOT_YUV_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace YuvConverter {
+
+namespace {
+
+inline uint8_t clampToByte(int value)
+{
+    if (value < 0) {
+        return 0;
+    }
+    if (value > 255) {
+        return 255;
+    }
+    return static_cast<uint8_t>(value);
+}
+
+struct YuvComponents {
+    uint8_t y;
+    uint8_t u;
+    uint8_t v;
+};
+
+YuvComponents rgbToYuv(uint8_t r, uint8_t g, uint8_t b)
+{
+    // BT.601 conversion with integer math
+    const int y = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+    const int u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+    const int v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+
+    return {clampToByte(y), clampToByte(u), clampToByte(v)};
+}
+
+// Reference implementation. The SIMD kernels handle the bulk of a row and
+// hand the remainder (including an odd trailing pixel) to this function.
+void convertRowScalar(const uint8_t *src, uint8_t *rowPtr, int x, int width)
+{
+    for (; x + 1 < width; x += 2) {
+        const uint8_t *p0 = src + (x * 3);
+        const uint8_t *p1 = src + ((x + 1) * 3);
+
+        const YuvComponents yuv0 = rgbToYuv(p0[0], p0[1], p0[2]);
+        const YuvComponents yuv1 = rgbToYuv(p1[0], p1[1], p1[2]);
+
+        const uint8_t u = clampToByte((static_cast<int>(yuv0.u) + static_cast<int>(yuv1.u)) / 2);
+        const uint8_t v = clampToByte((static_cast<int>(yuv0.v) + static_cast<int>(yuv1.v)) / 2);
+
+        rowPtr[(x * 2) + 0] = yuv0.y;
+        rowPtr[(x * 2) + 1] = u;
+        rowPtr[(x * 2) + 2] = yuv1.y;
+        rowPtr[(x * 2) + 3] = v;
+    }
+
+    if (x < width) {
+        const uint8_t *p0 = src + (x * 3);
+        const YuvComponents yuv0 = rgbToYuv(p0[0], p0[1], p0[2]);
+
+        rowPtr[(x * 2) + 0] = yuv0.y;
+        rowPtr[(x * 2) + 1] = yuv0.u;
+        rowPtr[(x * 2) + 2] = yuv0.y;
+        rowPtr[(x * 2) + 3] = yuv0.v;
+    }
+}
+
+#if defined(OBSBOT_YUV_X86)
+
+// The integer math maps onto 16-bit lanes without overflow: the Y sum peaks
+// at 56228 (unsigned), the U/V sums stay within +/-28688 (signed). Arithmetic
+// shifts match the scalar ">> 8" on negative values, and the results never
+// leave [16, 240], so the scalar clamps are no-ops here. Chroma pairs are
+// averaged with a truncating add+shift, not _mm_avg_epu8, which rounds up.
+
+__attribute__((target("sse4.1")))
+inline void deinterleave8Sse(const uint8_t *src, __m128i &r, __m128i &g, __m128i &b)
+{
+    // 8 RGB pixels span 24 bytes: load [0,16) and [8,24) and gather each
+    // channel into zero-extended 16-bit lanes.
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 8));
+
+    const __m128i rLo = _mm_setr_epi8(0, -1, 3, -1, 6, -1, 9, -1, 12, -1, 15, -1, -1, -1, -1, -1);
+    const __m128i rHi = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 10, -1, 13, -1);
+    const __m128i gLo = _mm_setr_epi8(1, -1, 4, -1, 7, -1, 10, -1, 13, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i gHi = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, -1, 11, -1, 14, -1);
+    const __m128i bLo = _mm_setr_epi8(2, -1, 5, -1, 8, -1, 11, -1, 14, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i bHi = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, -1, 12, -1, 15, -1);
+
+    r = _mm_or_si128(_mm_shuffle_epi8(lo, rLo), _mm_shuffle_epi8(hi, rHi));
+    g = _mm_or_si128(_mm_shuffle_epi8(lo, gLo), _mm_shuffle_epi8(hi, gHi));
+    b = _mm_or_si128(_mm_shuffle_epi8(lo, bLo), _mm_shuffle_epi8(hi, bHi));
+}
+
+__attribute__((target("sse4.1")))
+void convertRowSse41(const uint8_t *src, uint8_t *dst, int width)
+{
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i yOffset = _mm_set1_epi16(16);
+    const __m128i uvOffset = _mm_set1_epi16(128);
+    const __m128i yR = _mm_set1_epi16(66);
+    const __m128i yG = _mm_set1_epi16(129);
+    const __m128i yB = _mm_set1_epi16(25);
+    const __m128i uR = _mm_set1_epi16(-38);
+    const __m128i uG = _mm_set1_epi16(-74);
+    const __m128i uB = _mm_set1_epi16(112);
+    const __m128i vR = _mm_set1_epi16(112);
+    const __m128i vG = _mm_set1_epi16(-94);
+    const __m128i vB = _mm_set1_epi16(-18);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i r;
+        __m128i g;
+        __m128i b;
+        deinterleave8Sse(src + (x * 3), r, g, b);
+
+        __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, yR), _mm_mullo_epi16(g, yG));
+        y = _mm_add_epi16(y, _mm_add_epi16(_mm_mullo_epi16(b, yB), round));
+        y = _mm_add_epi16(_mm_srli_epi16(y, 8), yOffset);
+
+        __m128i u = _mm_add_epi16(_mm_mullo_epi16(r, uR), _mm_mullo_epi16(g, uG));
+        u = _mm_add_epi16(u, _mm_add_epi16(_mm_mullo_epi16(b, uB), round));
+        u = _mm_add_epi16(_mm_srai_epi16(u, 8), uvOffset);
+
+        __m128i v = _mm_add_epi16(_mm_mullo_epi16(r, vR), _mm_mullo_epi16(g, vG));
+        v = _mm_add_epi16(v, _mm_add_epi16(_mm_mullo_epi16(b, vB), round));
+        v = _mm_add_epi16(_mm_srai_epi16(v, 8), uvOffset);
+
+        // [u0+u1, u2+u3, u4+u5, u6+u7, v0+v1, ...] -> [U0, V0, U1, V1, ...]
+        const __m128i pairs = _mm_srli_epi16(_mm_hadd_epi16(u, v), 1);
+        const __m128i chroma = _mm_unpacklo_epi16(pairs, _mm_srli_si128(pairs, 8));
+
+        const __m128i packed = _mm_or_si128(y, _mm_slli_epi16(chroma, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (x * 2)), packed);
+    }
+
+    convertRowScalar(src, dst, x, width);
+}
+
+__attribute__((target("avx2")))
+void convertRowAvx2(const uint8_t *src, uint8_t *dst, int width)
+{
+    const __m256i round = _mm256_set1_epi16(128);
+    const __m256i yOffset = _mm256_set1_epi16(16);
+    const __m256i uvOffset = _mm256_set1_epi16(128);
+    const __m256i yR = _mm256_set1_epi16(66);
+    const __m256i yG = _mm256_set1_epi16(129);
+    const __m256i yB = _mm256_set1_epi16(25);
+    const __m256i uR = _mm256_set1_epi16(-38);
+    const __m256i uG = _mm256_set1_epi16(-74);
+    const __m256i uB = _mm256_set1_epi16(112);
+    const __m256i vR = _mm256_set1_epi16(112);
+    const __m256i vG = _mm256_set1_epi16(-94);
+    const __m256i vB = _mm256_set1_epi16(-18);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i r0;
+        __m128i g0;
+        __m128i b0;
+        __m128i r1;
+        __m128i g1;
+        __m128i b1;
+        deinterleave8Sse(src + (x * 3), r0, g0, b0);
+        deinterleave8Sse(src + ((x + 8) * 3), r1, g1, b1);
+
+        // Each 128-bit lane holds 8 consecutive pixels, so the in-lane hadd
+        // and unpack below mirror the SSE kernel exactly.
+        const __m256i r = _mm256_inserti128_si256(_mm256_castsi128_si256(r0), r1, 1);
+        const __m256i g = _mm256_inserti128_si256(_mm256_castsi128_si256(g0), g1, 1);
+        const __m256i b = _mm256_inserti128_si256(_mm256_castsi128_si256(b0), b1, 1);
+
+        __m256i y = _mm256_add_epi16(_mm256_mullo_epi16(r, yR), _mm256_mullo_epi16(g, yG));
+        y = _mm256_add_epi16(y, _mm256_add_epi16(_mm256_mullo_epi16(b, yB), round));
+        y = _mm256_add_epi16(_mm256_srli_epi16(y, 8), yOffset);
+
+        __m256i u = _mm256_add_epi16(_mm256_mullo_epi16(r, uR), _mm256_mullo_epi16(g, uG));
+        u = _mm256_add_epi16(u, _mm256_add_epi16(_mm256_mullo_epi16(b, uB), round));
+        u = _mm256_add_epi16(_mm256_srai_epi16(u, 8), uvOffset);
+
+        __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(r, vR), _mm256_mullo_epi16(g, vG));
+        v = _mm256_add_epi16(v, _mm256_add_epi16(_mm256_mullo_epi16(b, vB), round));
+        v = _mm256_add_epi16(_mm256_srai_epi16(v, 8), uvOffset);
+
+        const __m256i pairs = _mm256_srli_epi16(_mm256_hadd_epi16(u, v), 1);
+        const __m256i chroma = _mm256_unpacklo_epi16(pairs, _mm256_srli_si256(pairs, 8));
+
+        const __m256i packed = _mm256_or_si256(y, _mm256_slli_epi16(chroma, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + (x * 2)), packed);
+    }
+
+    if (x + 8 <= width) {
+        convertRowSse41(src + (x * 3), dst + (x * 2), width - x);
+        return;
+    }
+
+    convertRowScalar(src, dst, x, width);
+}
+
+#endif // OBSBOT_YUV_X86
+
+#if defined(OBSBOT_YUV_NEON)
+
+inline void convertHalfNeon(uint8x8_t r8, uint8x8_t g8, uint8x8_t b8,
+                            uint8x8_t &y8, int16x4_t &uPairs, int16x4_t &vPairs)
+{
+    const uint16x8_t r = vmovl_u8(r8);
+    const uint16x8_t g = vmovl_u8(g8);
+    const uint16x8_t b = vmovl_u8(b8);
+
+    uint16x8_t y = vmulq_n_u16(r, 66);
+    y = vmlaq_n_u16(y, g, 129);
+    y = vmlaq_n_u16(y, b, 25);
+    y = vaddq_u16(y, vdupq_n_u16(128));
+    y = vaddq_u16(vshrq_n_u16(y, 8), vdupq_n_u16(16));
+    y8 = vmovn_u16(y);
+
+    const int16x8_t rs = vreinterpretq_s16_u16(r);
+    const int16x8_t gs = vreinterpretq_s16_u16(g);
+    const int16x8_t bs = vreinterpretq_s16_u16(b);
+
+    int16x8_t u = vmulq_n_s16(rs, -38);
+    u = vmlaq_n_s16(u, gs, -74);
+    u = vmlaq_n_s16(u, bs, 112);
+    u = vaddq_s16(u, vdupq_n_s16(128));
+    u = vaddq_s16(vshrq_n_s16(u, 8), vdupq_n_s16(128));
+
+    int16x8_t v = vmulq_n_s16(rs, 112);
+    v = vmlaq_n_s16(v, gs, -94);
+    v = vmlaq_n_s16(v, bs, -18);
+    v = vaddq_s16(v, vdupq_n_s16(128));
+    v = vaddq_s16(vshrq_n_s16(v, 8), vdupq_n_s16(128));
+
+    uPairs = vpadd_s16(vget_low_s16(u), vget_high_s16(u));
+    vPairs = vpadd_s16(vget_low_s16(v), vget_high_s16(v));
+}
+
+void convertRowNeon(const uint8_t *src, uint8_t *dst, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16x3_t rgb = vld3q_u8(src + (x * 3));
+
+        uint8x8_t yLo;
+        uint8x8_t yHi;
+        int16x4_t uLo;
+        int16x4_t uHi;
+        int16x4_t vLo;
+        int16x4_t vHi;
+        convertHalfNeon(vget_low_u8(rgb.val[0]), vget_low_u8(rgb.val[1]), vget_low_u8(rgb.val[2]),
+                        yLo, uLo, vLo);
+        convertHalfNeon(vget_high_u8(rgb.val[0]), vget_high_u8(rgb.val[1]), vget_high_u8(rgb.val[2]),
+                        yHi, uHi, vHi);
+
+        // Truncating pair average; values are positive so >> 1 matches "/ 2".
+        const int16x8_t u = vshrq_n_s16(vcombine_s16(uLo, uHi), 1);
+        const int16x8_t v = vshrq_n_s16(vcombine_s16(vLo, vHi), 1);
+        const uint8x8x2_t yEvenOdd = vuzp_u8(yLo, yHi);
+
+        uint8x8x4_t out;
+        out.val[0] = yEvenOdd.val[0];
+        out.val[1] = vmovn_u16(vreinterpretq_u16_s16(u));
+        out.val[2] = yEvenOdd.val[1];
+        out.val[3] = vmovn_u16(vreinterpretq_u16_s16(v));
+        vst4_u8(dst + (x * 2), out);
+    }
+
+    convertRowScalar(src, dst, x, width);
+}
+
+#endif // OBSBOT_YUV_NEON
+
+// Two YUYV rows of scratch for the planar converters, kept per thread so
+// steady-state conversion does not allocate
+uint8_t *yuyvScratchRows(size_t rowBytes)
+{
+    thread_local std::vector<uint8_t> scratch;
+    if (scratch.size() < rowBytes * 2) {
+        scratch.resize(rowBytes * 2);
+    }
+    return scratch.data();
+}
+
+// Shared by NV12 (chromaStep 2, V right after U) and I420 (chromaStep 1)
+bool convertRgbToPlanar420(const uint8_t *rgb, int rgbStride, int width, int height,
+                           uint8_t *yPlane, int yStride,
+                           uint8_t *uPlane, uint8_t *vPlane, int chromaStride, int chromaStep)
+{
+    if (!rgb || !yPlane || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const Backend backend = activeBackend();
+    const int chromaWidth = (width + 1) / 2;
+    const size_t rowBytes = static_cast<size_t>(chromaWidth) * 4;
+    uint8_t *top = yuyvScratchRows(rowBytes);
+    uint8_t *bottom = top + rowBytes;
+
+    for (int y = 0; y < height; y += 2) {
+        // An odd last row pairs with itself
+        const bool hasBottom = y + 1 < height;
+        convertRgbRowToYuyv(backend, rgb + (static_cast<size_t>(y) * rgbStride), top, width);
+        if (hasBottom) {
+            convertRgbRowToYuyv(backend, rgb + (static_cast<size_t>(y + 1) * rgbStride), bottom, width);
+        }
+        const uint8_t *second = hasBottom ? bottom : top;
+
+        uint8_t *yTop = yPlane + (static_cast<size_t>(y) * yStride);
+        for (int x = 0; x < width; ++x) {
+            yTop[x] = top[x * 2];
+        }
+        if (hasBottom) {
+            uint8_t *yBottom = yTop + yStride;
+            for (int x = 0; x < width; ++x) {
+                yBottom[x] = bottom[x * 2];
+            }
+        }
+
+        uint8_t *u = uPlane + (static_cast<size_t>(y / 2) * chromaStride);
+        uint8_t *v = vPlane + (static_cast<size_t>(y / 2) * chromaStride);
+        for (int c = 0; c < chromaWidth; ++c) {
+            u[c * chromaStep] = static_cast<uint8_t>((top[c * 4 + 1] + second[c * 4 + 1] + 1) >> 1);
+            v[c * chromaStep] = static_cast<uint8_t>((top[c * 4 + 3] + second[c * 4 + 3] + 1) >> 1);
+        }
+    }
+
+    return true;
+}
+
+Backend detectBackend()
+{
+    const char *override = std::getenv("OBSBOT_YUV_BACKEND");
+    if (override && override[0] != '\0') {
+        const Backend candidates[] = {Backend::Scalar, Backend::Sse41, Backend::Avx2, Backend::Neon};
+        for (Backend candidate : candidates) {
+            if (std::strcmp(override, backendName(candidate)) == 0 && isBackendSupported(candidate)) {
+                return candidate;
+            }
+        }
+    }
+
+    if (isBackendSupported(Backend::Avx2)) {
+        return Backend::Avx2;
+    }
+    if (isBackendSupported(Backend::Sse41)) {
+        return Backend::Sse41;
+    }
+    if (isBackendSupported(Backend::Neon)) {
+        return Backend::Neon;
+    }
+    return Backend::Scalar;
+}
+
+} // namespace
+
+Backend activeBackend()
+{
+    static const Backend backend = detectBackend();
+    return backend;
+}
+
+bool isBackendSupported(Backend backend)
+{
+    switch (backend) {
+    case Backend::Scalar:
+        return true;
+#if defined(OBSBOT_YUV_X86)
+    case Backend::Sse41:
+        return __builtin_cpu_supports("sse4.1");
+    case Backend::Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#if defined(OBSBOT_YUV_NEON)
+    case Backend::Neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *backendName(Backend backend)
+{
+    switch (backend) {
+    case Backend::Sse41:
+        return "sse4.1";
+    case Backend::Avx2:
+        return "avx2";
+    case Backend::Neon:
+        return "neon";
+    case Backend::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+void convertRgbRowToYuyv(const uint8_t *rgb, uint8_t *yuyv, int width)
+{
+    convertRgbRowToYuyv(activeBackend(), rgb, yuyv, width);
+}
+
+void convertRgbRowToYuyv(Backend backend, const uint8_t *rgb, uint8_t *yuyv, int width)
+{
+    if (width <= 0) {
+        return;
+    }
+
+    if (!isBackendSupported(backend)) {
+        backend = Backend::Scalar;
+    }
+
+    switch (backend) {
+#if defined(OBSBOT_YUV_X86)
+    case Backend::Avx2:
+        convertRowAvx2(rgb, yuyv, width);
+        return;
+    case Backend::Sse41:
+        convertRowSse41(rgb, yuyv, width);
+        return;
+#endif
+#if defined(OBSBOT_YUV_NEON)
+    case Backend::Neon:
+        convertRowNeon(rgb, yuyv, width);
+        return;
+#endif
+    default:
+        convertRowScalar(rgb, yuyv, 0, width);
+        return;
+    }
+}
+
+bool convertRgbToYuyv(const uint8_t *rgb, int rgbStride,
+                      int width, int height,
+                      uint8_t *yuyv, int yuyvStride)
+{
+    if (!rgb || !yuyv || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const Backend backend = activeBackend();
+    for (int y = 0; y < height; ++y) {
+        convertRgbRowToYuyv(backend,
+                            rgb + (static_cast<size_t>(y) * rgbStride),
+                            yuyv + (static_cast<size_t>(y) * yuyvStride),
+                            width);
+    }
+
+    return true;
+}
+
+bool convertRgbToNv12(const uint8_t *rgb, int rgbStride,
+                      int width, int height,
+                      uint8_t *yPlane, int yStride,
+                      uint8_t *uvPlane, int uvStride)
+{
+    if (!uvPlane) {
+        return false;
+    }
+    return convertRgbToPlanar420(rgb, rgbStride, width, height, yPlane, yStride,
+                                 uvPlane, uvPlane + 1, uvStride, 2);
+}
+
+bool convertRgbToI420(const uint8_t *rgb, int rgbStride,
+                      int width, int height,
+                      uint8_t *yPlane, int yStride,
+                      uint8_t *uPlane, uint8_t *vPlane, int chromaStride)
+{
+    if (!uPlane || !vPlane) {
+        return false;
+    }
+    return convertRgbToPlanar420(rgb, rgbStride, width, height, yPlane, yStride,
+                                 uPlane, vPlane, chromaStride, 1);
+}
+
+} // namespace YuvConverter
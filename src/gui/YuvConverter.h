@@ -0,0 +1,82 @@
+#ifndef YUVCONVERTER_H
+#define YUVCONVERTER_H
+
+#include <cstdint>
+
+/**
+ * @brief BT.601 RGB888 to YUYV, NV12 and I420 conversion used by the virtual camera.
+ *
+ * The scalar path is the reference implementation. SIMD kernels (SSE4.1 and
+ * AVX2 on x86, NEON on ARM) produce bit-identical output and are selected at
+ * runtime based on the CPU. Set OBSBOT_YUV_BACKEND=scalar|sse4.1|avx2|neon to
+ * force a specific backend when comparing output or profiling.
+ */
+namespace YuvConverter {
+
+enum class Backend {
+    Scalar,
+    Sse41,
+    Avx2,
+    Neon
+};
+
+/**
+ * @brief Backend picked for this CPU (and environment override), resolved once
+ */
+Backend activeBackend();
+
+/**
+ * @brief Whether the given backend can run on this CPU
+ */
+bool isBackendSupported(Backend backend);
+
+const char *backendName(Backend backend);
+
+/**
+ * @brief Convert one row of RGB888 pixels into YUYV using the active backend
+ * @param rgb    Source row, width * 3 bytes
+ * @param yuyv   Destination row, width * 2 bytes (rounded up to an even width)
+ * @param width  Number of pixels in the row
+ */
+void convertRgbRowToYuyv(const uint8_t *rgb, uint8_t *yuyv, int width);
+
+/**
+ * @brief Convert one row with an explicit backend (falls back to scalar if unsupported)
+ */
+void convertRgbRowToYuyv(Backend backend, const uint8_t *rgb, uint8_t *yuyv, int width);
+
+/**
+ * @brief Convert a whole RGB888 image into a YUYV buffer
+ * @return false if the dimensions are invalid
+ */
+bool convertRgbToYuyv(const uint8_t *rgb, int rgbStride,
+                      int width, int height,
+                      uint8_t *yuyv, int yuyvStride);
+
+/**
+ * @brief Convert a whole RGB888 image into NV12 (Y plane, interleaved UV plane)
+ *
+ * Rows go through the YUYV kernels, so luma and horizontally averaged chroma
+ * match convertRgbToYuyv(); chroma is then averaged over each pair of rows.
+ * Odd widths and heights round the chroma planes up.
+ * @return false if the dimensions are invalid
+ */
+bool convertRgbToNv12(const uint8_t *rgb, int rgbStride,
+                      int width, int height,
+                      uint8_t *yPlane, int yStride,
+                      uint8_t *uvPlane, int uvStride);
+
+/**
+ * @brief Convert a whole RGB888 image into I420 (Y, U and V planes)
+ *
+ * Same sampling as convertRgbToNv12(), with separate chroma planes.
+ * @return false if the dimensions are invalid
+ */
+bool convertRgbToI420(const uint8_t *rgb, int rgbStride,
+                      int width, int height,
+                      uint8_t *yPlane, int yStride,
+                      uint8_t *uPlane, uint8_t *vPlane, int chromaStride);
+
+} // namespace YuvConverter
+
+#endif // YUVCONVERTER_H
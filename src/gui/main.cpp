@@ -3,6 +3,8 @@
 
 int main(int argc, char *argv[])
 {
+    // Lets the preview sample textures rendered on the effects thread
+    QApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
     QApplication app(argc, argv);
 
     MainWindow window;
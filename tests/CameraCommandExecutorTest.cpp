@@ -0,0 +1,238 @@
+// CameraCommandExecutor with fake work standing in for SDK calls. A gate
+// holds the command thread inside the first command, so the test decides
+// exactly what is still queued when it posts, coalesces or cancels.
+
+#include "CameraCommandExecutor.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QStringList>
+#include <QThread>
+#include <QtTest>
+#include <memory>
+
+namespace {
+
+// Work that blocks the command thread until release() is called
+class Gate
+{
+public:
+    CameraCommandExecutor::Work work()
+    {
+        return [this]() {
+            m_entered.release();
+            m_open.acquire();
+        };
+    }
+
+    // Returns once the command thread is inside work()
+    bool waitUntilEntered() { return m_entered.tryAcquire(1, 5000); }
+    void release() { m_open.release(); }
+
+private:
+    QSemaphore m_entered;
+    QSemaphore m_open;
+};
+
+// What ran where, shared between the command thread and the test
+class Journal
+{
+public:
+    CameraCommandExecutor::Work work(const QString &name)
+    {
+        return [this, name]() {
+            QMutexLocker locker(&m_mutex);
+            m_ran.append(name);
+            m_workThreads.append(QThread::currentThread());
+        };
+    }
+
+    CameraCommandExecutor::Completion completion(const QString &name)
+    {
+        return [this, name]() {
+            QMutexLocker locker(&m_mutex);
+            m_completed.append(name);
+            m_completionThreads.append(QThread::currentThread());
+        };
+    }
+
+    QStringList ran() const { QMutexLocker locker(&m_mutex); return m_ran; }
+    QStringList completed() const { QMutexLocker locker(&m_mutex); return m_completed; }
+    QList<QThread *> workThreads() const { QMutexLocker locker(&m_mutex); return m_workThreads; }
+    QList<QThread *> completionThreads() const { QMutexLocker locker(&m_mutex); return m_completionThreads; }
+
+private:
+    mutable QMutex m_mutex;
+    QStringList m_ran;
+    QStringList m_completed;
+    QList<QThread *> m_workThreads;
+    QList<QThread *> m_completionThreads;
+};
+
+} // namespace
+
+class CameraCommandExecutorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void runsInPostedOrder();
+    void coalescesQueuedSets();
+    void coalescingKeepsPostingOrder();
+    void cancelDropsQueuedWork();
+    void cancelDropsRunningCompletion();
+    void destructorWaitsForRunningWork();
+};
+
+void CameraCommandExecutorTest::runsInPostedOrder()
+{
+    CameraCommandExecutor executor;
+    Journal journal;
+    const QStringList names = {QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c"),
+                               QStringLiteral("d"), QStringLiteral("e")};
+    for (const QString &name : names) {
+        executor.post(name, journal.work(name), journal.completion(name));
+    }
+
+    QTRY_COMPARE(journal.completed().size(), names.size());
+    QCOMPARE(journal.ran(), names);
+    QCOMPARE(journal.completed(), names);
+
+    // Work on the command thread, completions back on the poster's
+    for (QThread *thread : journal.workThreads()) {
+        QVERIFY(thread != QThread::currentThread());
+    }
+    for (QThread *thread : journal.completionThreads()) {
+        QCOMPARE(thread, QThread::currentThread());
+    }
+    QCOMPARE(executor.statistics().sent, quint64(names.size()));
+    QCOMPARE(executor.pendingCount(), 0);
+}
+
+void CameraCommandExecutorTest::coalescesQueuedSets()
+{
+    CameraCommandExecutor executor;
+    Gate gate;
+    Journal journal;
+    executor.post(QStringLiteral("gate"), gate.work());
+    QVERIFY(gate.waitUntilEntered());
+
+    // A slider drag: only the last zoom still waiting should be sent
+    executor.postCoalesced(QStringLiteral("zoom"), QStringLiteral("zoom 1"),
+                           journal.work(QStringLiteral("zoom 1")), journal.completion(QStringLiteral("zoom 1")));
+    executor.postCoalesced(QStringLiteral("zoom"), QStringLiteral("zoom 2"),
+                           journal.work(QStringLiteral("zoom 2")), journal.completion(QStringLiteral("zoom 2")));
+    executor.postCoalesced(QStringLiteral("pan"), QStringLiteral("pan"),
+                           journal.work(QStringLiteral("pan")), journal.completion(QStringLiteral("pan")));
+    executor.postCoalesced(QStringLiteral("zoom"), QStringLiteral("zoom 3"),
+                           journal.work(QStringLiteral("zoom 3")), journal.completion(QStringLiteral("zoom 3")));
+    QCOMPARE(executor.pendingCount(), 2);
+
+    gate.release();
+    QTRY_COMPARE(journal.completed().size(), 2);
+    // The last zoom was posted after the pan, so it runs after it
+    const QStringList expected = {QStringLiteral("pan"), QStringLiteral("zoom 3")};
+    QCOMPARE(journal.ran(), expected);
+    QCOMPARE(journal.completed(), expected);
+
+    const CameraCommandExecutor::Statistics statistics = executor.statistics();
+    QCOMPARE(statistics.coalesced, quint64(2));
+    QCOMPARE(statistics.sent, quint64(3));  // Gate, pan and the last zoom
+}
+
+void CameraCommandExecutorTest::coalescingKeepsPostingOrder()
+{
+    CameraCommandExecutor executor;
+    Gate gate;
+    Journal journal;
+    executor.post(QStringLiteral("gate"), gate.work());
+    QVERIFY(gate.waitUntilEntered());
+
+    // A zoom from a slider is still queued when a batch sets the FOV and
+    // then the zoom, which the camera clamps against the FOV just set
+    executor.postCoalesced(QStringLiteral("zoom"), QStringLiteral("zoom 1"),
+                           journal.work(QStringLiteral("zoom 1")), journal.completion(QStringLiteral("zoom 1")));
+    executor.postCoalesced(QStringLiteral("fov"), QStringLiteral("fov"),
+                           journal.work(QStringLiteral("fov")), journal.completion(QStringLiteral("fov")));
+    executor.postCoalesced(QStringLiteral("zoom"), QStringLiteral("zoom 2"),
+                           journal.work(QStringLiteral("zoom 2")), journal.completion(QStringLiteral("zoom 2")));
+    QCOMPARE(executor.pendingCount(), 2);
+
+    gate.release();
+    QTRY_COMPARE(journal.completed().size(), 2);
+    const QStringList expected = {QStringLiteral("fov"), QStringLiteral("zoom 2")};
+    QCOMPARE(journal.ran(), expected);
+    QCOMPARE(journal.completed(), expected);
+    QCOMPARE(executor.statistics().coalesced, quint64(1));
+}
+
+void CameraCommandExecutorTest::cancelDropsQueuedWork()
+{
+    CameraCommandExecutor executor;
+    Gate gate;
+    Journal journal;
+    executor.post(QStringLiteral("gate"), gate.work());
+    QVERIFY(gate.waitUntilEntered());
+
+    executor.post(QStringLiteral("old 1"), journal.work(QStringLiteral("old 1")), journal.completion(QStringLiteral("old 1")));
+    executor.postCoalesced(QStringLiteral("zoom"), QStringLiteral("old 2"),
+                           journal.work(QStringLiteral("old 2")), journal.completion(QStringLiteral("old 2")));
+    executor.cancelPending();
+    QCOMPARE(executor.pendingCount(), 0);
+
+    // Posts after the cancel belong to the new device and go through
+    executor.post(QStringLiteral("new"), journal.work(QStringLiteral("new")), journal.completion(QStringLiteral("new")));
+    gate.release();
+
+    QTRY_COMPARE(journal.completed(), QStringList{QStringLiteral("new")});
+    QCOMPARE(journal.ran(), QStringList{QStringLiteral("new")});
+}
+
+void CameraCommandExecutorTest::cancelDropsRunningCompletion()
+{
+    CameraCommandExecutor executor;
+    Gate gate;
+    Journal journal;
+    bool staleCompletionRan = false;
+    executor.post(QStringLiteral("running"), gate.work(), [&staleCompletionRan]() {
+        staleCompletionRan = true;
+    });
+    QVERIFY(gate.waitUntilEntered());
+
+    // The device goes away mid-command: the command finishes, but its
+    // result is for a device the poster no longer has
+    executor.cancelPending();
+    executor.post(QStringLiteral("next"), journal.work(QStringLiteral("next")), journal.completion(QStringLiteral("next")));
+    gate.release();
+
+    QTRY_COMPARE(journal.completed(), QStringList{QStringLiteral("next")});
+    QCoreApplication::processEvents();
+    QVERIFY(!staleCompletionRan);
+}
+
+void CameraCommandExecutorTest::destructorWaitsForRunningWork()
+{
+    Gate gate;
+    Journal journal;
+    auto executor = std::make_unique<CameraCommandExecutor>();
+    executor->post(QStringLiteral("gate"), gate.work());
+    QVERIFY(gate.waitUntilEntered());
+    executor->post(QStringLiteral("dropped"), journal.work(QStringLiteral("dropped")));
+
+    // Let the running command finish while the destructor is waiting
+    QThread *releaser = QThread::create([&gate]() {
+        QThread::msleep(50);
+        gate.release();
+    });
+    releaser->start();
+    executor.reset();
+    releaser->wait();
+    delete releaser;
+
+    QVERIFY(journal.ran().isEmpty());
+}
+
+QTEST_GUILESS_MAIN(CameraCommandExecutorTest)
+
+#include "CameraCommandExecutorTest.moc"
@@ -0,0 +1,108 @@
+// FramePool recycling: handles share their buffer, the last one returns it,
+// and a steady stream of one size stops allocating after warm-up. The pool
+// is process-wide, so every check works on differences in stats().
+
+#include "FramePool.h"
+
+#include <QtTest>
+#include <thread>
+#include <vector>
+
+class FramePoolTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void handlesShareTheBuffer();
+    void steadyStateDoesNotAllocate();
+    void imagesReturnTheirBuffer();
+    void lastReleaseOnAnotherThread();
+};
+
+void FramePoolTest::handlesShareTheBuffer()
+{
+    FrameBuffer first = FramePool::instance().acquire(4096);
+    QVERIFY(!first.isNull());
+    QCOMPARE(first.size(), qsizetype(4096));
+    QCOMPARE(reinterpret_cast<quintptr>(first.data()) % 64, quintptr(0));
+
+    FrameBuffer copy = first;
+    FrameBuffer moved = std::move(copy);
+    QVERIFY(copy.isNull());
+    QCOMPARE(moved.constData(), first.constData());
+
+    first.data()[4095] = 0x5a;
+    QCOMPARE(moved.constData()[4095], uchar(0x5a));
+}
+
+void FramePoolTest::steadyStateDoesNotAllocate()
+{
+    constexpr qsizetype kBytes = 1920 * 1080 * 2;
+
+    // Warm up with as many buffers in flight as the loop below holds
+    {
+        FrameBuffer a = FramePool::instance().acquire(kBytes);
+        FrameBuffer b = FramePool::instance().acquire(kBytes);
+    }
+
+    const FramePool::Stats before = FramePool::instance().stats();
+    for (int i = 0; i < 100; ++i) {
+        FrameBuffer a = FramePool::instance().acquire(kBytes);
+        FrameBuffer b = FramePool::instance().acquire(kBytes);
+        FrameBuffer shared = a;
+        b = shared;
+    }
+    const FramePool::Stats after = FramePool::instance().stats();
+
+    QCOMPARE(after.allocations, before.allocations);
+    QCOMPARE(after.reuses - before.reuses, quint64(200));
+    QCOMPARE(after.bytesInUse, before.bytesInUse);
+}
+
+void FramePoolTest::imagesReturnTheirBuffer()
+{
+    const QSize size(641, 37);  // Odd width: rows are padded to 4 bytes
+    const FramePool::Stats before = FramePool::instance().stats();
+    {
+        QImage image = FramePool::instance().acquireImage(size, QImage::Format_RGB888);
+        QVERIFY(!image.isNull());
+        QCOMPARE(image.size(), size);
+        QCOMPARE(image.bytesPerLine() % 4, qsizetype(0));
+        image.fill(Qt::red);
+
+        const QImage copy = image;  // Shares the pooled pixels
+        QVERIFY(FramePool::instance().stats().bytesInUse > before.bytesInUse);
+    }
+    QCOMPARE(FramePool::instance().stats().bytesInUse, before.bytesInUse);
+
+    // The next image of that size gets the same buffer back
+    const quint64 reuses = FramePool::instance().stats().reuses;
+    const QImage again = FramePool::instance().acquireImage(size, QImage::Format_RGB888);
+    QCOMPARE(FramePool::instance().stats().reuses, reuses + 1);
+}
+
+void FramePoolTest::lastReleaseOnAnotherThread()
+{
+    const FramePool::Stats before = FramePool::instance().stats();
+    {
+        std::vector<std::thread> threads;
+        FrameBuffer buffer = FramePool::instance().acquire(65536);
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([copy = buffer]() mutable {
+                for (int j = 0; j < 1000; ++j) {
+                    FrameBuffer local = copy;
+                    local.data()[j] = static_cast<uchar>(j);
+                }
+            });
+        }
+        buffer = FrameBuffer();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+    QCOMPARE(FramePool::instance().stats().bytesInUse, before.bytesInUse);
+}
+
+QTEST_GUILESS_MAIN(FramePoolTest)
+
+#include "FramePoolTest.moc"
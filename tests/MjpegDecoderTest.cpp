@@ -0,0 +1,262 @@
+// MjpegDecoder's raw planes against what went into the encoder: 4:2:0,
+// 4:2:2, 4:4:0 and 4:4:4 at even and odd sizes, with and without IDCT
+// scaling, and input it must turn down so the engine falls back to Qt.
+// Frames are encoded with libjpeg here so the subsampling is known.
+
+#include "MjpegDecoder.h"
+
+#include <QtTest>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <jpeglib.h>
+
+namespace {
+
+// The decoder's fast IDCT at quality 100 stays well inside this on flat cells
+constexpr int kTolerance = 4;
+
+struct Sampling {
+    const char *name;
+    int h;  // Luma samples per chroma sample, horizontally
+    int v;  // And vertically
+};
+
+const Sampling kSamplings[] = {
+    {"4:2:0", 2, 2},
+    {"4:2:2", 2, 1},
+    {"4:4:0", 1, 2},
+    {"4:4:4", 1, 1},
+};
+
+// Flat cells of distinct colours, so a wrong plane, stride or flip shows up
+// at any sample. Cells are whole MCUs at every sampling and DCT scale used.
+struct Colour {
+    int y;
+    int cb;
+    int cr;
+};
+
+Colour cellColour(int x, int y, int cellSize)
+{
+    const int cx = x / cellSize;
+    const int cy = y / cellSize;
+    return {40 + (cx * 37 + cy * 71) % 180,
+            60 + (cx * 53 + cy * 29) % 140,
+            60 + (cx * 23 + cy * 61) % 140};
+}
+
+std::vector<uchar> encode(int width, int height, const Sampling &sampling, int cellSize)
+{
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr error;
+    cinfo.err = jpeg_std_error(&error);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char *buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+
+    cinfo.image_width = static_cast<JDIMENSION>(width);
+    cinfo.image_height = static_cast<JDIMENSION>(height);
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_YCbCr;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 100, TRUE);
+    cinfo.comp_info[0].h_samp_factor = sampling.h;
+    cinfo.comp_info[0].v_samp_factor = sampling.v;
+    for (int i = 1; i < 3; ++i) {
+        cinfo.comp_info[i].h_samp_factor = 1;
+        cinfo.comp_info[i].v_samp_factor = 1;
+    }
+
+    jpeg_start_compress(&cinfo, TRUE);
+    std::vector<JSAMPLE> row(static_cast<size_t>(width) * 3);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        const int y = static_cast<int>(cinfo.next_scanline);
+        for (int x = 0; x < width; ++x) {
+            const Colour colour = cellColour(x, y, cellSize);
+            row[static_cast<size_t>(x) * 3 + 0] = static_cast<JSAMPLE>(colour.y);
+            row[static_cast<size_t>(x) * 3 + 1] = static_cast<JSAMPLE>(colour.cb);
+            row[static_cast<size_t>(x) * 3 + 2] = static_cast<JSAMPLE>(colour.cr);
+        }
+        JSAMPROW rows[] = {row.data()};
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<uchar> bytes(buffer, buffer + size);
+    std::free(buffer);
+    return bytes;
+}
+
+std::vector<uchar> encodeGray(int width, int height)
+{
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr error;
+    cinfo.err = jpeg_std_error(&error);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char *buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+
+    cinfo.image_width = static_cast<JDIMENSION>(width);
+    cinfo.image_height = static_cast<JDIMENSION>(height);
+    cinfo.input_components = 1;
+    cinfo.in_color_space = JCS_GRAYSCALE;
+    jpeg_set_defaults(&cinfo);
+
+    jpeg_start_compress(&cinfo, TRUE);
+    std::vector<JSAMPLE> row(static_cast<size_t>(width), 128);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW rows[] = {row.data()};
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<uchar> bytes(buffer, buffer + size);
+    std::free(buffer);
+    return bytes;
+}
+
+// Returns a description of the first sample off by more than kTolerance,
+// or an empty string. Planes are compared at the decoded size, each sample
+// against the cell its centre maps back to in the source.
+QString compareCells(const MjpegDecoder::Frame &frame, const QSize &sourceSize, int cellSize)
+{
+    for (int plane = 0; plane < 3; ++plane) {
+        const QSize planeSize = plane == 0 ? frame.size : frame.chromaSize;
+        for (int y = 0; y < planeSize.height(); ++y) {
+            const uchar *row = frame.plane(plane) + static_cast<size_t>(y) * frame.stride[plane];
+            for (int x = 0; x < planeSize.width(); ++x) {
+                const int sourceX = (2 * x + 1) * sourceSize.width() / (2 * planeSize.width());
+                const int sourceY = (2 * y + 1) * sourceSize.height() / (2 * planeSize.height());
+                const Colour colour = cellColour(sourceX, sourceY, cellSize);
+                const int expected = plane == 0 ? colour.y : plane == 1 ? colour.cb : colour.cr;
+                if (std::abs(row[x] - expected) > kTolerance) {
+                    return QStringLiteral("plane %1 at (%2, %3) is %4, expected %5")
+                        .arg(plane).arg(x).arg(y).arg(row[x]).arg(expected);
+                }
+            }
+        }
+    }
+    return QString();
+}
+
+} // namespace
+
+class MjpegDecoderTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decodesEachSampling();
+    void scalesInTheIdct();
+    void rejectsWhatItCannotDecode();
+};
+
+void MjpegDecoderTest::decodesEachSampling()
+{
+    const QSize sizes[] = {QSize(96, 64), QSize(75, 45)};
+    constexpr int kCellSize = 16;
+
+    MjpegDecoder decoder;
+    for (const Sampling &sampling : kSamplings) {
+        for (const QSize &size : sizes) {
+            const QString what = QStringLiteral("%1 %2x%3: ")
+                                     .arg(QLatin1String(sampling.name))
+                                     .arg(size.width()).arg(size.height());
+            const std::vector<uchar> jpeg = encode(size.width(), size.height(), sampling, kCellSize);
+            const MjpegDecoder::Frame frame = decoder.decode(jpeg.data(), jpeg.size());
+
+            QVERIFY2(!frame.isNull(), qPrintable(what + QStringLiteral("not decoded")));
+            QCOMPARE(frame.size, size);
+            QCOMPARE(frame.chromaSize, QSize((size.width() + sampling.h - 1) / sampling.h,
+                                             (size.height() + sampling.v - 1) / sampling.v));
+            for (int plane = 0; plane < 3; ++plane) {
+                const QSize planeSize = plane == 0 ? frame.size : frame.chromaSize;
+                QVERIFY(frame.stride[plane] >= planeSize.width());
+                QCOMPARE(frame.offset[plane] % 64, size_t(0));
+            }
+            const QString mismatch = compareCells(frame, size, kCellSize);
+            QVERIFY2(mismatch.isEmpty(), qPrintable(what + mismatch));
+        }
+    }
+}
+
+void MjpegDecoderTest::scalesInTheIdct()
+{
+    const QSize size(640, 480);
+    constexpr int kCellSize = 128;  // Still whole blocks at 1/8
+
+    struct Case {
+        QSize maxSize;
+        QSize expected;
+    };
+    const Case cases[] = {
+        {QSize(), QSize(640, 480)},
+        {QSize(640, 480), QSize(640, 480)},
+        {QSize(320, 200), QSize(320, 240)},
+        {QSize(200, 100), QSize(320, 240)},
+        {QSize(160, 120), QSize(160, 120)},
+        {QSize(1, 1), QSize(80, 60)},
+    };
+
+    MjpegDecoder decoder;
+    for (const Sampling &sampling : kSamplings) {
+        const std::vector<uchar> jpeg = encode(size.width(), size.height(), sampling, kCellSize);
+        for (const Case &test : cases) {
+            const QString what = QStringLiteral("%1 max %2x%3: ")
+                                     .arg(QLatin1String(sampling.name))
+                                     .arg(test.maxSize.width()).arg(test.maxSize.height());
+            const MjpegDecoder::Frame frame = decoder.decode(jpeg.data(), jpeg.size(), test.maxSize);
+
+            QVERIFY2(!frame.isNull(), qPrintable(what + QStringLiteral("not decoded")));
+            QCOMPARE(frame.size, test.expected);
+            // Chroma may come out up to full size when the IDCT scales it up
+            QVERIFY(frame.chromaSize.width() >= test.expected.width() / sampling.h);
+            QVERIFY(frame.chromaSize.height() >= test.expected.height() / sampling.v);
+            QVERIFY(frame.chromaSize.width() <= test.expected.width());
+            QVERIFY(frame.chromaSize.height() <= test.expected.height());
+            const QString mismatch = compareCells(frame, size, kCellSize);
+            QVERIFY2(mismatch.isEmpty(), qPrintable(what + mismatch));
+        }
+    }
+}
+
+void MjpegDecoderTest::rejectsWhatItCannotDecode()
+{
+    MjpegDecoder decoder;
+    const std::vector<uchar> valid = encode(64, 48, kSamplings[0], 16);
+
+    QVERIFY(decoder.decode(nullptr, 0).isNull());
+    QVERIFY(decoder.decode(valid.data(), 0).isNull());
+
+    // Random bytes, and a valid frame cut off inside its header
+    std::vector<uchar> garbage(4096);
+    uint32_t state = 12345;
+    for (uchar &byte : garbage) {
+        state = state * 1664525u + 1013904223u;
+        byte = static_cast<uchar>(state >> 24);
+    }
+    QVERIFY(decoder.decode(garbage.data(), garbage.size()).isNull());
+    QVERIFY(decoder.decode(valid.data(), 20).isNull());
+
+    // Valid JPEGs without three YCbCr planes are left to Qt
+    const std::vector<uchar> gray = encodeGray(64, 48);
+    QVERIFY(decoder.decode(gray.data(), gray.size()).isNull());
+
+    // Failures longjmp out of libjpeg; the state must still decode afterwards
+    const MjpegDecoder::Frame frame = decoder.decode(valid.data(), valid.size());
+    QVERIFY(!frame.isNull());
+    QCOMPARE(frame.size, QSize(64, 48));
+    const QString mismatch = compareCells(frame, frame.size, 16);
+    QVERIFY2(mismatch.isEmpty(), qPrintable(mismatch));
+}
+
+QTEST_GUILESS_MAIN(MjpegDecoderTest)
+#include "MjpegDecoderTest.moc"
@@ -0,0 +1,124 @@
+// Drives OffscreenEffectsEngine the way the virtual camera does: the first
+// submitted frame starts the worker thread and its context, and processed
+// frames come back through the readback signals on this thread.
+// Runs headless; see tests/CMakeLists.txt for the environment.
+
+#include "OffscreenEffectsEngine.h"
+#include "TestPattern.h"
+
+#include <QGuiApplication>
+#include <QSignalSpy>
+#include <QtTest>
+
+namespace {
+
+constexpr int kTimeoutMs = 10000;
+constexpr int kTolerance = 12;
+
+} // namespace
+
+class OffscreenEffectsEngineTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void processedFrame();
+    void pipelinedReadback();
+    void packedFrame();
+
+private:
+    // Waits for the first emission of result; skips when the worker could
+    // not create its OpenGL context
+    bool waitForResult(QSignalSpy &result, QSignalSpy &errors);
+};
+
+bool OffscreenEffectsEngineTest::waitForResult(QSignalSpy &result, QSignalSpy &errors)
+{
+    return QTest::qWaitFor([&]() { return result.count() > 0 || errors.count() > 0; }, kTimeoutMs);
+}
+
+void OffscreenEffectsEngineTest::processedFrame()
+{
+    OffscreenEffectsEngine engine;
+    QSignalSpy processed(&engine, &OffscreenEffectsEngine::processedFrameReady);
+    QSignalSpy errors(&engine, &OffscreenEffectsEngine::errorOccurred);
+    engine.setReadbackEnabled(true);
+    engine.setReadbackLatency(0);
+
+    const qint64 captureTimeUs = 123456789;
+    engine.submitFrame(TestPattern::makeRgbFrame(), captureTimeUs);
+    QVERIFY2(waitForResult(processed, errors), "No frame and no error from the worker");
+    if (!errors.isEmpty()) {
+        QSKIP(qPrintable(errors.first().at(0).toString()));
+    }
+    QVERIFY(engine.isAvailable());
+
+    const QList<QVariant> arguments = processed.first();
+    const QImage frame = arguments.at(0).value<QImage>();
+    const QString mismatch = TestPattern::comparePattern(frame, kTolerance);
+    QVERIFY2(mismatch.isEmpty(), qPrintable(mismatch));
+    QCOMPARE(arguments.at(1).value<qint64>(), captureTimeUs);
+}
+
+void OffscreenEffectsEngineTest::pipelinedReadback()
+{
+    // With the default latency a frame is emitted once a later one has been
+    // rendered, so keep the camera "running" until one comes out
+    OffscreenEffectsEngine engine;
+    QSignalSpy processed(&engine, &OffscreenEffectsEngine::processedFrameReady);
+    QSignalSpy errors(&engine, &OffscreenEffectsEngine::errorOccurred);
+    engine.setReadbackEnabled(true);
+
+    const bool done = QTest::qWaitFor([&]() {
+        if (processed.count() > 0 || errors.count() > 0) {
+            return true;
+        }
+        engine.submitFrame(TestPattern::makeNv12Frame());
+        return false;
+    }, kTimeoutMs);
+    QVERIFY2(done, "No frame and no error from the worker");
+    if (!errors.isEmpty()) {
+        QSKIP(qPrintable(errors.first().at(0).toString()));
+    }
+
+    const QImage frame = processed.first().at(0).value<QImage>();
+    const QString mismatch = TestPattern::comparePattern(frame, kTolerance);
+    QVERIFY2(mismatch.isEmpty(), qPrintable(mismatch));
+}
+
+void OffscreenEffectsEngineTest::packedFrame()
+{
+    OffscreenEffectsEngine engine;
+    QSignalSpy packed(&engine, &OffscreenEffectsEngine::packedFrameReady);
+    QSignalSpy errors(&engine, &OffscreenEffectsEngine::errorOccurred);
+    engine.setReadbackEnabled(true);
+    engine.setReadbackLatency(0);
+    // A target smaller than the frame exercises the crop as well
+    const QSize targetSize(TestPattern::kWidth / 2, TestPattern::kHeight / 2);
+    engine.setGpuPacking(true, targetSize);
+
+    engine.submitFrame(TestPattern::makeRgbFrame(), 42);
+    QVERIFY2(waitForResult(packed, errors), "No frame and no error from the worker");
+    if (!errors.isEmpty()) {
+        QSKIP(qPrintable(errors.first().at(0).toString()));
+    }
+
+    const PackedFrame frame = packed.first().at(0).value<PackedFrame>();
+    QVERIFY(!frame.isNull());
+    QCOMPARE(frame.format, PackedFrame::Format::Yuyv);
+    QCOMPARE(frame.size, targetSize);
+    QCOMPARE(frame.stride, targetSize.width() * 2);
+    QVERIFY(frame.data.size() >= static_cast<qsizetype>(frame.stride) * targetSize.height());
+    QCOMPARE(frame.captureTimeUs, qint64(42));
+}
+
+int main(int argc, char *argv[])
+{
+    // As in the application, so the worker shares its textures with the preview
+    QGuiApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    QGuiApplication app(argc, argv);
+    OffscreenEffectsEngineTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "OffscreenEffectsEngineTest.moc"
@@ -0,0 +1,221 @@
+// SharedConversion between sink workers: each shared stage is computed once
+// per frame however many sinks ask, callers that arrive during the
+// computation wait for its result, and a failed computation still releases
+// them. Sink workers are plain threads here, as in the streamer. A waiter
+// that is never released hangs, which the ctest timeout reports.
+
+#include "SharedConversion.h"
+
+#include <QSemaphore>
+#include <QtTest>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using OutputFormat = VirtualCameraStreamer::OutputFormat;
+
+const QSize kResolution(64, 36);
+
+// Holds a computation until the test lets it finish
+class Gate
+{
+public:
+    bool waitUntilEntered() { return m_entered.tryAcquire(1, 5000); }
+    void release() { m_open.release(); }
+
+    void pass()
+    {
+        m_entered.release();
+        m_open.acquire();
+    }
+
+private:
+    QSemaphore m_entered;
+    QSemaphore m_open;
+};
+
+QImage makeScaled()
+{
+    QImage image(kResolution, QImage::Format_RGB888);
+    image.fill(Qt::darkCyan);
+    return image;
+}
+
+SharedConversion::Converted makeConverted()
+{
+    SharedConversion::Converted converted;
+    converted.bytesPerLine = kResolution.width() * 2;
+    converted.bytesUsed = static_cast<size_t>(converted.bytesPerLine) * kResolution.height();
+    converted.buffer = FramePool::instance().acquire(static_cast<qsizetype>(converted.bytesUsed));
+    return converted;
+}
+
+} // namespace
+
+class SharedConversionTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sharesOnlyRegisteredDuplicates();
+    void computesEachStageOnce();
+    void waitersGetTheResult();
+    void failedComputeReleasesWaiters();
+};
+
+void SharedConversionTest::sharesOnlyRegisteredDuplicates()
+{
+    SharedConversion shared;
+    shared.addSink(kResolution, OutputFormat::Yuyv);
+    shared.addSink(kResolution, OutputFormat::Nv12);
+    shared.addSink(QSize(1280, 720), OutputFormat::Yuyv);
+
+    QVERIFY(shared.sharesScaling(kResolution));
+    QVERIFY(!shared.sharesConversion(kResolution, OutputFormat::Yuyv));
+    QVERIFY(!shared.sharesConversion(kResolution, OutputFormat::Nv12));
+    QVERIFY(!shared.sharesScaling(QSize(1280, 720)));
+}
+
+void SharedConversionTest::computesEachStageOnce()
+{
+    constexpr int kSinks = 4;
+    constexpr int kFrames = 50;
+
+    for (int frame = 0; frame < kFrames; ++frame) {
+        SharedConversion shared;
+        for (int i = 0; i < kSinks; ++i) {
+            shared.addSink(kResolution, OutputFormat::Yuyv);
+        }
+
+        std::atomic<int> scaledRuns{0};
+        std::atomic<int> convertedRuns{0};
+        std::vector<qint64> images(kSinks);
+        std::vector<const uchar *> buffers(kSinks);
+        std::vector<std::thread> sinks;
+        for (int i = 0; i < kSinks; ++i) {
+            sinks.emplace_back([&, i]() {
+                const QImage scaled = shared.scaledImage(kResolution, [&]() {
+                    ++scaledRuns;
+                    return makeScaled();
+                });
+                const SharedConversion::Converted converted =
+                    shared.convertedFrame(kResolution, OutputFormat::Yuyv, [&]() {
+                        ++convertedRuns;
+                        return makeConverted();
+                    });
+                images[i] = scaled.cacheKey();
+                buffers[i] = converted.buffer.constData();
+            });
+        }
+        for (std::thread &sink : sinks) {
+            sink.join();
+        }
+
+        QCOMPARE(scaledRuns.load(), 1);
+        QCOMPARE(convertedRuns.load(), 1);
+        for (int i = 1; i < kSinks; ++i) {
+            QCOMPARE(images[i], images[0]);
+            QCOMPARE(buffers[i], buffers[0]);
+        }
+    }
+}
+
+void SharedConversionTest::waitersGetTheResult()
+{
+    SharedConversion shared;
+    for (int i = 0; i < 3; ++i) {
+        shared.addSink(kResolution, OutputFormat::Nv12);
+    }
+
+    Gate gate;
+    QImage expected = makeScaled();
+    QImage claimed;
+    std::thread first([&]() {
+        claimed = shared.scaledImage(kResolution, [&]() {
+            gate.pass();
+            return expected;
+        });
+    });
+    const bool entered = gate.waitUntilEntered();
+
+    // These arrive while the first sink is still computing
+    std::atomic<int> returned{0};
+    std::atomic<bool> computedAgain{false};
+    std::vector<QImage> waited(2);
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 2; ++i) {
+        waiters.emplace_back([&, i]() {
+            waited[i] = shared.scaledImage(kResolution, [&]() {
+                computedAgain = true;
+                return QImage();
+            });
+            ++returned;
+        });
+    }
+
+    QTest::qWait(50);
+    const int returnedEarly = returned.load();
+
+    // Join before checking, so a failure does not leave threads running
+    gate.release();
+    first.join();
+    for (std::thread &waiter : waiters) {
+        waiter.join();
+    }
+
+    QVERIFY(entered);
+    QCOMPARE(returnedEarly, 0);
+    QVERIFY(!computedAgain.load());
+    QCOMPARE(claimed.cacheKey(), expected.cacheKey());
+    for (const QImage &image : waited) {
+        QCOMPARE(image.cacheKey(), expected.cacheKey());
+    }
+}
+
+void SharedConversionTest::failedComputeReleasesWaiters()
+{
+    SharedConversion shared;
+    for (int i = 0; i < 3; ++i) {
+        shared.addSink(kResolution, OutputFormat::I420);
+    }
+
+    Gate gate;
+    std::atomic<bool> firstNull{false};
+    std::thread first([&]() {
+        const SharedConversion::Converted converted =
+            shared.convertedFrame(kResolution, OutputFormat::I420, [&]() {
+                gate.pass();
+                return SharedConversion::Converted();  // Conversion failed
+            });
+        firstNull = converted.isNull();
+    });
+    const bool entered = gate.waitUntilEntered();
+
+    std::atomic<int> nullResults{0};
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 2; ++i) {
+        waiters.emplace_back([&]() {
+            const SharedConversion::Converted converted =
+                shared.convertedFrame(kResolution, OutputFormat::I420, []() {
+                    return makeConverted();
+                });
+            if (converted.isNull()) {
+                ++nullResults;
+            }
+        });
+    }
+
+    gate.release();
+    first.join();
+    for (std::thread &waiter : waiters) {
+        waiter.join();
+    }
+    QVERIFY(entered);
+    QVERIFY(firstNull.load());
+    QCOMPARE(nullResults.load(), 2);
+}
+
+QTEST_GUILESS_MAIN(SharedConversionTest)
+#include "SharedConversionTest.moc"
@@ -0,0 +1,161 @@
+#ifndef TESTPATTERN_H
+#define TESTPATTERN_H
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QColor>
+#include <QImage>
+#include <QImageWriter>
+#include <QSize>
+#include <QString>
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * @brief Camera test frame that looks different after any flip or mirror.
+ *
+ * The top half is green on the left quarter and red elsewhere; the bottom
+ * half is blue. Colours stay well inside the legal range so YUV round trips
+ * and the effects shader leave them recognisable.
+ */
+namespace TestPattern {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+
+inline QColor expectedColor(int x, int y, const QSize &size = QSize(kWidth, kHeight))
+{
+    if (y < size.height() / 2) {
+        return x < size.width() / 4 ? QColor(40, 230, 40) : QColor(230, 40, 40);
+    }
+    return QColor(40, 40, 230);
+}
+
+// BT.601 limited range, as the effects engine assumes for unlabelled frames
+inline void toYuv(const QColor &color, int &y, int &u, int &v)
+{
+    const int r = color.red();
+    const int g = color.green();
+    const int b = color.blue();
+    y = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+    u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+    v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+inline QVideoFrame makeRgbFrame()
+{
+    const QSize size(kWidth, kHeight);
+    QVideoFrame frame(QVideoFrameFormat(size, QVideoFrameFormat::Format_RGBX8888));
+    if (!frame.map(QVideoFrame::WriteOnly)) {
+        return QVideoFrame();
+    }
+    for (int y = 0; y < kHeight; ++y) {
+        uchar *row = frame.bits(0) + y * frame.bytesPerLine(0);
+        for (int x = 0; x < kWidth; ++x) {
+            const QColor color = expectedColor(x, y);
+            row[x * 4 + 0] = static_cast<uchar>(color.red());
+            row[x * 4 + 1] = static_cast<uchar>(color.green());
+            row[x * 4 + 2] = static_cast<uchar>(color.blue());
+            row[x * 4 + 3] = 255;
+        }
+    }
+    frame.unmap();
+    return frame;
+}
+
+inline QVideoFrame makeNv12Frame()
+{
+    const QSize size(kWidth, kHeight);
+    QVideoFrame frame(QVideoFrameFormat(size, QVideoFrameFormat::Format_NV12));
+    if (!frame.map(QVideoFrame::WriteOnly)) {
+        return QVideoFrame();
+    }
+    for (int y = 0; y < kHeight; ++y) {
+        uchar *luma = frame.bits(0) + y * frame.bytesPerLine(0);
+        uchar *chroma = frame.bits(1) + (y / 2) * frame.bytesPerLine(1);
+        for (int x = 0; x < kWidth; ++x) {
+            int yValue = 0;
+            int uValue = 0;
+            int vValue = 0;
+            toYuv(expectedColor(x, y), yValue, uValue, vValue);
+            luma[x] = static_cast<uchar>(yValue);
+            // Regions are aligned to 2x2 blocks, so any sample of a block will do
+            if (x % 2 == 0 && y % 2 == 0) {
+                chroma[x] = static_cast<uchar>(uValue);
+                chroma[x + 1] = static_cast<uchar>(vValue);
+            }
+        }
+    }
+    frame.unmap();
+    return frame;
+}
+
+// What an MJPEG camera delivers: Qt's writer subsamples chroma 4:2:0, and
+// the region edges fall on MCU boundaries so blocks stay flat
+inline QVideoFrame makeJpegFrame()
+{
+    QImage image(kWidth, kHeight, QImage::Format_RGB32);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            image.setPixelColor(x, y, expectedColor(x, y));
+        }
+    }
+
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "jpeg");
+    writer.setQuality(95);
+    if (!writer.write(image)) {
+        return QVideoFrame();
+    }
+
+    QVideoFrame frame(QVideoFrameFormat(image.size(), QVideoFrameFormat::Format_Jpeg));
+    if (!frame.map(QVideoFrame::WriteOnly)) {
+        return QVideoFrame();
+    }
+    const bool fits = bytes.size() <= frame.mappedBytes(0);
+    if (fits) {
+        memcpy(frame.bits(0), bytes.constData(), static_cast<size_t>(bytes.size()));
+    }
+    frame.unmap();
+    return fits ? frame : QVideoFrame();
+}
+
+inline bool isNear(const QColor &actual, const QColor &expected, int tolerance)
+{
+    return std::abs(actual.red() - expected.red()) <= tolerance
+        && std::abs(actual.green() - expected.green()) <= tolerance
+        && std::abs(actual.blue() - expected.blue()) <= tolerance;
+}
+
+// Sample points well inside each region, away from filtered edges
+constexpr int kSamplePoints[][2] = {
+    {6, 4},    // Top left: green
+    {48, 4},   // Top right: red
+    {6, 44},   // Bottom left: blue
+    {48, 44}   // Bottom right: blue
+};
+
+// Returns a description of the first mismatch, or an empty string
+inline QString comparePattern(const QImage &image, int tolerance)
+{
+    if (image.size() != QSize(kWidth, kHeight)) {
+        return QStringLiteral("size %1x%2").arg(image.width()).arg(image.height());
+    }
+    for (const auto &point : kSamplePoints) {
+        const QColor actual = image.pixelColor(point[0], point[1]);
+        const QColor expected = expectedColor(point[0], point[1]);
+        if (!isNear(actual, expected, tolerance)) {
+            return QStringLiteral("pixel (%1, %2) is %3, expected %4")
+                .arg(point[0]).arg(point[1]).arg(actual.name(), expected.name());
+        }
+    }
+    return QString();
+}
+
+} // namespace TestPattern
+
+#endif // TESTPATTERN_H
@@ -0,0 +1,157 @@
+// V4l2CaptureSource against a real capture node: streams a few frames
+// through the mmap ring and checks their size, format and timestamps, then
+// restarts on the same device. Needs a node such as vivid or the capture
+// side of v4l2loopback, named by OBSBOT_TEST_CAPTURE_DEVICE; without one
+// the test exits with 77, which ctest reports as skipped.
+
+#include "V4l2CaptureSource.h"
+
+#include "FrameClock.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QSignalSpy>
+#include <QVideoFrameFormat>
+#include <QtTest>
+#include <cstdio>
+
+namespace {
+
+constexpr int kFrames = 8;
+constexpr int kTimeoutMs = 10000;
+
+QString captureDevice()
+{
+    return QString::fromLocal8Bit(qgetenv("OBSBOT_TEST_CAPTURE_DEVICE"));
+}
+
+} // namespace
+
+class V4l2CaptureSourceTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void streamsFrames_data();
+    void streamsFrames();
+    void restartsOnTheSameDevice();
+    void reportsAMissingDevice();
+
+private:
+    V4l2CaptureSource::Settings settings(bool preferMjpeg) const;
+};
+
+V4l2CaptureSource::Settings V4l2CaptureSourceTest::settings(bool preferMjpeg) const
+{
+    V4l2CaptureSource::Settings settings;
+    settings.devicePath = captureDevice();
+    settings.resolution = QSize(640, 480);
+    settings.frameRate = 30;
+    settings.preferMjpeg = preferMjpeg;
+    return settings;
+}
+
+void V4l2CaptureSourceTest::streamsFrames_data()
+{
+    QTest::addColumn<bool>("preferMjpeg");
+    QTest::newRow("raw") << false;
+    QTest::newRow("mjpeg") << true;
+}
+
+void V4l2CaptureSourceTest::streamsFrames()
+{
+    QFETCH(bool, preferMjpeg);
+
+    V4l2CaptureSource source;
+    QSignalSpy started(&source, &V4l2CaptureSource::started);
+    QSignalSpy errors(&source, &V4l2CaptureSource::errorOccurred);
+    QSignalSpy frames(&source, &V4l2CaptureSource::frameReady);
+
+    source.start(settings(preferMjpeg));
+    QTRY_VERIFY_WITH_TIMEOUT(started.count() == 1 || !errors.isEmpty(), kTimeoutMs);
+    QVERIFY2(errors.isEmpty(), qPrintable(errors.value(0).value(0).toString()));
+    const QSize size = started.at(0).at(0).toSize();
+    QVERIFY(size.isValid());
+    qInfo() << "Streaming" << size << started.at(0).at(1).toString();
+
+    QTRY_VERIFY_WITH_TIMEOUT(frames.count() >= kFrames, kTimeoutMs);
+    source.stop();
+    QVERIFY(!source.isActive());
+    QVERIFY(errors.isEmpty());
+
+    qint64 previousUs = 0;
+    QVideoFrameFormat::PixelFormat pixelFormat = QVideoFrameFormat::Format_Invalid;
+    for (int i = 0; i < kFrames; ++i) {
+        QVideoFrame frame = frames.at(i).at(0).value<QVideoFrame>();
+        const qint64 captureTimeUs = frames.at(i).at(1).toLongLong();
+
+        QVERIFY(frame.isValid());
+        QCOMPARE(frame.size(), size);
+        if (i == 0) {
+            pixelFormat = frame.pixelFormat();
+            QVERIFY(pixelFormat == QVideoFrameFormat::Format_YUYV ||
+                    pixelFormat == QVideoFrameFormat::Format_NV12 ||
+                    pixelFormat == QVideoFrameFormat::Format_Jpeg);
+        }
+        QCOMPARE(frame.pixelFormat(), pixelFormat);
+
+        QVERIFY(frame.map(QVideoFrame::ReadOnly));
+        if (pixelFormat == QVideoFrameFormat::Format_YUYV) {
+            QVERIFY(frame.bytesPerLine(0) >= size.width() * 2);
+        } else if (pixelFormat == QVideoFrameFormat::Format_NV12) {
+            QVERIFY(frame.bytesPerLine(0) >= size.width());
+            QVERIFY(frame.bytesPerLine(1) >= size.width());
+        } else {
+            QVERIFY(frame.mappedBytes(0) > 0);
+        }
+        frame.unmap();
+
+        // Monotonic, and on the clock the rest of the pipeline reads
+        QVERIFY2(captureTimeUs > previousUs, qPrintable(QStringLiteral("frame %1").arg(i)));
+        previousUs = captureTimeUs;
+    }
+    const qint64 ageUs = FrameClock::nowUs() - previousUs;
+    QVERIFY2(ageUs >= 0 && ageUs < kTimeoutMs * qint64(1000),
+             qPrintable(QStringLiteral("last frame is %1 us old").arg(ageUs)));
+}
+
+void V4l2CaptureSourceTest::restartsOnTheSameDevice()
+{
+    // Buffers must be unmapped and released, or the second open is busy
+    V4l2CaptureSource source;
+    QSignalSpy errors(&source, &V4l2CaptureSource::errorOccurred);
+    QSignalSpy frames(&source, &V4l2CaptureSource::frameReady);
+    for (int run = 0; run < 2; ++run) {
+        frames.clear();
+        source.start(settings(false));
+        QTRY_VERIFY_WITH_TIMEOUT(frames.count() >= 2 || !errors.isEmpty(), kTimeoutMs);
+        QVERIFY2(errors.isEmpty(), qPrintable(errors.value(0).value(0).toString()));
+        source.stop();
+    }
+}
+
+void V4l2CaptureSourceTest::reportsAMissingDevice()
+{
+    V4l2CaptureSource source;
+    QSignalSpy errors(&source, &V4l2CaptureSource::errorOccurred);
+    V4l2CaptureSource::Settings missing = settings(false);
+    missing.devicePath = QStringLiteral("/dev/obsbot-test-no-such-device");
+    source.start(missing);
+    QTRY_COMPARE_WITH_TIMEOUT(errors.count(), 1, kTimeoutMs);
+    QVERIFY(!source.isActive());
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QString device = captureDevice();
+    if (device.isEmpty() || !QFile::exists(device)) {
+        std::printf("skip: set OBSBOT_TEST_CAPTURE_DEVICE to a capture node (vivid, v4l2loopback)\n");
+        return 77;
+    }
+
+    V4l2CaptureSourceTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "V4l2CaptureSourceTest.moc"
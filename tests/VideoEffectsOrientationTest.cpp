@@ -0,0 +1,191 @@
+// Renders an asymmetric test frame, as RGB, NV12 and MJPEG input, through
+// VideoEffectsEngine and checks that every output keeps the camera's
+// orientation: the virtual camera readback (RGBA and GPU-packed YUYV) and
+// the preview's draws, both straight from the engine and through the copy
+// the offscreen worker publishes.
+// Runs headless; see tests/CMakeLists.txt for the environment.
+
+#include "TestPattern.h"
+#include "VideoEffectsEngine.h"
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QSurfaceFormat>
+#include <QtTest>
+#include <functional>
+#include <memory>
+
+namespace {
+
+// RGB and YUV uploads round differently; neither gets anywhere near this
+constexpr int kTolerance = 12;
+
+} // namespace
+
+class VideoEffectsOrientationTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void readback_data();
+    void readback();
+    void packedReadback();
+    void display_data();
+    void display();
+
+private:
+    void addInputRows();
+    bool renderFrame(const QVideoFrame &frame);
+    QImage drawToImage(const std::function<void()> &draw);
+
+    QOffscreenSurface m_surface;
+    QOpenGLContext m_context;
+    std::unique_ptr<VideoEffectsEngine> m_engine;
+};
+
+void VideoEffectsOrientationTest::initTestCase()
+{
+    // Same context as OffscreenEffectsEngine: the shaders are GLSL 330 core
+    QSurfaceFormat format;
+    format.setRenderableType(QSurfaceFormat::OpenGL);
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    m_surface.setFormat(format);
+    m_surface.create();
+    m_context.setFormat(format);
+    if (!m_surface.isValid() || !m_context.create() || !m_context.makeCurrent(&m_surface)) {
+        QSKIP("No OpenGL 3.3 core context on this platform");
+    }
+}
+
+void VideoEffectsOrientationTest::cleanupTestCase()
+{
+    m_context.doneCurrent();
+}
+
+void VideoEffectsOrientationTest::init()
+{
+    m_engine = std::make_unique<VideoEffectsEngine>();
+    QVERIFY(m_engine->initialize());
+    // Synchronous readback, so render() emits the frame it just drew
+    m_engine->setReadbackLatency(0);
+}
+
+void VideoEffectsOrientationTest::cleanup()
+{
+    if (m_engine) {
+        m_engine->cleanup();
+        m_engine.reset();
+    }
+}
+
+void VideoEffectsOrientationTest::addInputRows()
+{
+    QTest::addColumn<QVideoFrame>("frame");
+    QTest::newRow("rgba") << TestPattern::makeRgbFrame();
+    QTest::newRow("nv12") << TestPattern::makeNv12Frame();
+    QTest::newRow("mjpeg") << TestPattern::makeJpegFrame();
+}
+
+bool VideoEffectsOrientationTest::renderFrame(const QVideoFrame &frame)
+{
+    m_engine->setFrame(frame);
+    return m_engine->render();
+}
+
+// Draws like the preview widget does into a window-sized framebuffer, then
+// reads it back top row first, as the screen would show it
+QImage VideoEffectsOrientationTest::drawToImage(const std::function<void()> &draw)
+{
+    QOpenGLFramebufferObject target(QSize(TestPattern::kWidth, TestPattern::kHeight));
+    target.bind();
+    m_context.functions()->glViewport(0, 0, target.width(), target.height());
+    draw();
+    target.release();
+    return target.toImage().convertToFormat(QImage::Format_RGB32);
+}
+
+void VideoEffectsOrientationTest::readback_data()
+{
+    addInputRows();
+}
+
+void VideoEffectsOrientationTest::readback()
+{
+    QFETCH(QVideoFrame, frame);
+    QVERIFY(frame.isValid());
+
+    QImage output;
+    connect(m_engine.get(), &VideoEffectsEngine::processedFrameReady, this,
+            [&output](const QImage &image, qint64) { output = image.copy(); });
+    m_engine->setReadbackEnabled(true);
+    QVERIFY(renderFrame(frame));
+
+    QVERIFY2(!output.isNull(), "No frame was read back");
+    const QString mismatch = TestPattern::comparePattern(output, kTolerance);
+    QVERIFY2(mismatch.isEmpty(), qPrintable(mismatch));
+}
+
+void VideoEffectsOrientationTest::packedReadback()
+{
+    PackedFrame packed;
+    connect(m_engine.get(), &VideoEffectsEngine::packedFrameReady, this,
+            [&packed](const PackedFrame &frame) { packed = frame; });
+    m_engine->setReadbackEnabled(true);
+    m_engine->setGpuPacking(true);
+    QVERIFY(renderFrame(TestPattern::makeRgbFrame()));
+
+    QVERIFY2(!packed.isNull(), "No packed frame was read back");
+    QCOMPARE(packed.size, QSize(TestPattern::kWidth, TestPattern::kHeight));
+
+    // Luma tells the three colours apart on its own
+    for (const auto &point : TestPattern::kSamplePoints) {
+        const int x = point[0];
+        const int y = point[1];
+        int expected = 0;
+        int u = 0;
+        int v = 0;
+        TestPattern::toYuv(TestPattern::expectedColor(x, y), expected, u, v);
+        const int actual = packed.data.constData()[y * packed.stride + x * 2];
+        QVERIFY2(std::abs(actual - expected) <= kTolerance,
+                 qPrintable(QStringLiteral("luma at (%1, %2) is %3, expected %4")
+                                .arg(x).arg(y).arg(actual).arg(expected)));
+    }
+}
+
+void VideoEffectsOrientationTest::display_data()
+{
+    addInputRows();
+}
+
+void VideoEffectsOrientationTest::display()
+{
+    QFETCH(QVideoFrame, frame);
+    QVERIFY(frame.isValid());
+    QVERIFY(renderFrame(frame));
+
+    // The widget's own fallback path
+    QString mismatch = TestPattern::comparePattern(
+        drawToImage([this]() { m_engine->drawOutput(QVector2D(1.0f, 1.0f)); }), kTolerance);
+    QVERIFY2(mismatch.isEmpty(), qPrintable(QStringLiteral("drawOutput: ") + mismatch));
+
+    // The copy OffscreenEffectsEngine publishes for the widget to sample
+    std::unique_ptr<QOpenGLFramebufferObject> published;
+    QVERIFY(m_engine->copyOutput(published));
+    const GLuint texture = published->texture();
+    mismatch = TestPattern::comparePattern(
+        drawToImage([this, texture]() { m_engine->drawTexture(texture, QVector2D(1.0f, 1.0f)); }),
+        kTolerance);
+    QVERIFY2(mismatch.isEmpty(), qPrintable(QStringLiteral("copyOutput: ") + mismatch));
+}
+
+QTEST_MAIN(VideoEffectsOrientationTest)
+
+#include "VideoEffectsOrientationTest.moc"
@@ -0,0 +1,251 @@
+// Checks every SIMD backend this CPU supports against Backend::Scalar.
+// The SIMD kernels work in blocks and hand the rest of a row to the scalar
+// code, so the widths below cover empty blocks, exact blocks, every tail
+// length and odd widths that end in a single pixel.
+//
+// The NV12 and I420 converters use the active backend, which ctest forces
+// through OBSBOT_YUV_BACKEND; their output is checked against 4:2:0 planes
+// built here from scalar YUYV rows.
+
+#include "YuvConverter.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+using YuvConverter::Backend;
+
+namespace {
+
+int g_failures = 0;
+
+// Fixed seed, so a failure reproduces
+uint32_t nextRandom(uint32_t &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 24;
+}
+
+std::vector<uint8_t> makeRow(int width, uint32_t seed)
+{
+    std::vector<uint8_t> rgb(static_cast<size_t>(width) * 3);
+    uint32_t state = seed;
+    for (size_t i = 0; i < rgb.size(); ++i) {
+        rgb[i] = static_cast<uint8_t>(nextRandom(state));
+    }
+    // Saturated pixels exercise the clamps at both ends
+    if (width > 2) {
+        rgb[0] = rgb[1] = rgb[2] = 255;
+        rgb[3] = rgb[4] = rgb[5] = 0;
+    }
+    return rgb;
+}
+
+// Converts with one backend into a buffer with a guard band after the row
+std::vector<uint8_t> convertRow(Backend backend, const std::vector<uint8_t> &rgb, int width)
+{
+    const size_t rowBytes = static_cast<size_t>((width + 1) / 2) * 4;
+    std::vector<uint8_t> yuyv(rowBytes + 64, 0xA5);
+    YuvConverter::convertRgbRowToYuyv(backend, rgb.data(), yuyv.data(), width);
+    return yuyv;
+}
+
+void checkRowBackend(Backend backend)
+{
+    std::vector<int> widths;
+    for (int width = 1; width <= 80; ++width) {
+        widths.push_back(width);
+    }
+    const int wide[] = {127, 128, 129, 639, 640, 1279, 1280, 1919, 1920};
+    widths.insert(widths.end(), std::begin(wide), std::end(wide));
+
+    for (int width : widths) {
+        const std::vector<uint8_t> rgb = makeRow(width, static_cast<uint32_t>(width) * 7919u);
+        const std::vector<uint8_t> expected = convertRow(Backend::Scalar, rgb, width);
+        const std::vector<uint8_t> actual = convertRow(backend, rgb, width);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (expected[i] != actual[i]) {
+                std::fprintf(stderr, "FAIL %s row width %d: byte %zu is %d, scalar gives %d\n",
+                             YuvConverter::backendName(backend), width, i,
+                             actual[i], expected[i]);
+                ++g_failures;
+                break;
+            }
+        }
+    }
+}
+
+struct Planes {
+    std::vector<uint8_t> y;
+    std::vector<uint8_t> u;  // U plane for I420, interleaved UV for NV12
+    std::vector<uint8_t> v;  // Unused for NV12
+};
+
+// Padded strides, so a write past the visible width shows up in the padding
+struct PlaneLayout {
+    int width;
+    int height;
+    int yStride;
+    int chromaWidth;
+    int chromaHeight;
+    int chromaStride;
+
+    PlaneLayout(int w, int h, bool nv12)
+        : width(w)
+        , height(h)
+        , yStride(w + 5)
+        , chromaWidth((w + 1) / 2)
+        , chromaHeight((h + 1) / 2)
+        , chromaStride((nv12 ? chromaWidth * 2 : chromaWidth) + 3)
+    {
+    }
+};
+
+Planes makePlanes(const PlaneLayout &layout, bool nv12)
+{
+    Planes planes;
+    planes.y.assign(static_cast<size_t>(layout.yStride) * layout.height, 0xA5);
+    planes.u.assign(static_cast<size_t>(layout.chromaStride) * layout.chromaHeight, 0xA5);
+    if (!nv12) {
+        planes.v.assign(planes.u.size(), 0xA5);
+    }
+    return planes;
+}
+
+// 4:2:0 from scalar YUYV rows: chroma is averaged over each row pair, and
+// an odd last row pairs with itself
+Planes referencePlanes(const std::vector<uint8_t> &rgb, const PlaneLayout &layout, bool nv12)
+{
+    Planes planes = makePlanes(layout, nv12);
+    const int rgbStride = layout.width * 3;
+    const size_t rowBytes = static_cast<size_t>(layout.chromaWidth) * 4;
+    std::vector<uint8_t> top(rowBytes);
+    std::vector<uint8_t> bottom(rowBytes);
+
+    for (int y = 0; y < layout.height; y += 2) {
+        const bool hasBottom = y + 1 < layout.height;
+        YuvConverter::convertRgbRowToYuyv(Backend::Scalar, rgb.data() + static_cast<size_t>(y) * rgbStride,
+                                          top.data(), layout.width);
+        if (hasBottom) {
+            YuvConverter::convertRgbRowToYuyv(Backend::Scalar, rgb.data() + static_cast<size_t>(y + 1) * rgbStride,
+                                              bottom.data(), layout.width);
+        }
+        const std::vector<uint8_t> &second = hasBottom ? bottom : top;
+
+        for (int x = 0; x < layout.width; ++x) {
+            planes.y[static_cast<size_t>(y) * layout.yStride + x] = top[x * 2];
+            if (hasBottom) {
+                planes.y[static_cast<size_t>(y + 1) * layout.yStride + x] = bottom[x * 2];
+            }
+        }
+
+        const size_t chromaRow = static_cast<size_t>(y / 2) * layout.chromaStride;
+        for (int c = 0; c < layout.chromaWidth; ++c) {
+            const uint8_t u = static_cast<uint8_t>((top[c * 4 + 1] + second[c * 4 + 1] + 1) >> 1);
+            const uint8_t v = static_cast<uint8_t>((top[c * 4 + 3] + second[c * 4 + 3] + 1) >> 1);
+            if (nv12) {
+                planes.u[chromaRow + c * 2] = u;
+                planes.u[chromaRow + c * 2 + 1] = v;
+            } else {
+                planes.u[chromaRow + c] = u;
+                planes.v[chromaRow + c] = v;
+            }
+        }
+    }
+    return planes;
+}
+
+void comparePlane(const char *format, const char *plane, const PlaneLayout &layout,
+                  const std::vector<uint8_t> &expected, const std::vector<uint8_t> &actual)
+{
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i] != actual[i]) {
+            std::fprintf(stderr, "FAIL %s %s plane %dx%d: byte %zu is %d, expected %d\n",
+                         format, plane, layout.width, layout.height, i, actual[i], expected[i]);
+            ++g_failures;
+            return;
+        }
+    }
+}
+
+void checkPlanar()
+{
+    const int widths[] = {1, 2, 3, 7, 15, 16, 17, 31, 32, 33, 63, 65, 641};
+    const int heights[] = {1, 2, 3, 4, 5, 9};
+
+    for (int width : widths) {
+        for (int height : heights) {
+            const int rgbStride = width * 3;
+            std::vector<uint8_t> rgb;
+            for (int y = 0; y < height; ++y) {
+                const std::vector<uint8_t> row = makeRow(width, static_cast<uint32_t>(width * 31 + y));
+                rgb.insert(rgb.end(), row.begin(), row.end());
+            }
+
+            const PlaneLayout nv12Layout(width, height, true);
+            const Planes nv12Expected = referencePlanes(rgb, nv12Layout, true);
+            Planes nv12 = makePlanes(nv12Layout, true);
+            if (!YuvConverter::convertRgbToNv12(rgb.data(), rgbStride, width, height,
+                                                nv12.y.data(), nv12Layout.yStride,
+                                                nv12.u.data(), nv12Layout.chromaStride)) {
+                std::fprintf(stderr, "FAIL NV12 %dx%d rejected\n", width, height);
+                ++g_failures;
+            }
+            comparePlane("NV12", "Y", nv12Layout, nv12Expected.y, nv12.y);
+            comparePlane("NV12", "UV", nv12Layout, nv12Expected.u, nv12.u);
+
+            const PlaneLayout i420Layout(width, height, false);
+            const Planes i420Expected = referencePlanes(rgb, i420Layout, false);
+            Planes i420 = makePlanes(i420Layout, false);
+            if (!YuvConverter::convertRgbToI420(rgb.data(), rgbStride, width, height,
+                                                i420.y.data(), i420Layout.yStride,
+                                                i420.u.data(), i420.v.data(), i420Layout.chromaStride)) {
+                std::fprintf(stderr, "FAIL I420 %dx%d rejected\n", width, height);
+                ++g_failures;
+            }
+            comparePlane("I420", "Y", i420Layout, i420Expected.y, i420.y);
+            comparePlane("I420", "U", i420Layout, i420Expected.u, i420.u);
+            comparePlane("I420", "V", i420Layout, i420Expected.v, i420.v);
+        }
+    }
+}
+
+} // namespace
+
+int main()
+{
+    // ctest runs the planar check once per backend; one this CPU lacks is skipped
+    const char *forced = std::getenv("OBSBOT_YUV_BACKEND");
+    const Backend active = YuvConverter::activeBackend();
+    if (forced && forced[0] != '\0' && std::strcmp(forced, YuvConverter::backendName(active)) != 0) {
+        std::printf("skip: %s not supported on this CPU\n", forced);
+        return 77;
+    }
+
+    checkPlanar();
+    std::printf("checked NV12 and I420 with %s\n", YuvConverter::backendName(active));
+
+    const Backend backends[] = {Backend::Sse41, Backend::Avx2, Backend::Neon};
+    int tested = 0;
+    for (Backend backend : backends) {
+        if (!YuvConverter::isBackendSupported(backend)) {
+            std::printf("skip %s: not supported on this CPU\n", YuvConverter::backendName(backend));
+            continue;
+        }
+        checkRowBackend(backend);
+        ++tested;
+        std::printf("checked %s\n", YuvConverter::backendName(backend));
+    }
+
+    if (tested == 0) {
+        std::printf("no SIMD backend on this CPU, scalar only\n");
+    }
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}